@@ -0,0 +1,340 @@
+/*
+* ---------------------------------------------------------
+* Copyright 2018-present (c) Automatos Studios. All Rights Reserved.
+* ---------------------------------------------------------
+*/
+
+/**
+* @file			benchCommon.h
+* @author		cosmoplankton < cosmoplankton@automatos.studio >
+*/
+
+
+#ifndef BENCH_COMMON
+#define BENCH_COMMON
+
+
+#include <cstdio>
+#include <cstdint>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <limits>
+#include <utility>
+#include <algorithm>
+
+#include "../source/devicemanager/Idevice.h"
+#include "../source/devicemanager/IcomputeAppManager.h"
+#include "../source/devicemanager/computeManager.h"
+
+
+#define BENCH_KERNEL_NAMESPACE "bench"		/* kernel namespace of the embedded benchmark kernels */
+
+
+namespace bench
+{
+	using namespace graphics_compute;
+
+
+	/**
+	* @struct	BenchOptions
+	* @brief	Command line options shared by all the suites (see benchMain.cpp).
+	*/
+	struct BenchOptions
+	{
+		uint64_t minSize{ 1000 };
+		uint64_t maxSize{ 100000000 };
+		uint32_t repetitions{ 5 };
+		std::string kernelDirectory{ "..\\source\\data\\kernels\\" };
+		bool verbose{ false };
+	};
+
+
+	/* problem sizes of a sweep, decades from minSize up to maxSize */
+	static inline std::vector< uint64_t > GET_SWEEP_SIZES(BenchOptions const& options)
+	{
+		std::vector< uint64_t > sizes;
+		for (uint64_t size = options.minSize; size && size <= options.maxSize; size *= 10)
+		{
+			sizes.push_back(size);
+		}
+		return sizes;
+	}
+
+
+	/* best wall time (ms) of the repetitions after an untimed warm-up run, negative if a run fails */
+	template<typename FuncT>
+	static inline double TIME_BEST_MS(uint32_t repetitions, FuncT&& func)
+	{
+		if (func())
+			return -1.0;
+
+		double best = std::numeric_limits<double>::max();
+		for (uint32_t rep = 0; rep < std::max<uint32_t>(repetitions, 1); ++rep)
+		{
+			auto start = std::chrono::high_resolution_clock::now();
+			if (func())
+				return -1.0;
+			std::chrono::duration<double, std::milli> elapsed = std::chrono::high_resolution_clock::now() - start;
+			best = std::min(best, elapsed.count());
+		}
+		return best;
+	}
+
+
+	/* relative comparison of the float results (fused multiply-add and reassociation change the last bits) */
+	static inline bool IS_CLOSE(double value, double expected, double tolerance = 1e-5)
+	{
+		return std::fabs(value - expected) <= tolerance * std::max(1.0, std::fabs(expected));
+	}
+
+
+	/**
+	* @class	BenchReport
+	* @brief	One row per measured case, failed checks are counted for the exit code.
+	*/
+	class BenchReport final
+	{
+	public:
+		BenchReport()
+		{
+			printf("%-14s %-26s %12s %12s %12s %10s %9s  %s\n", "suite", "case", "size", "device ms", "host ms", "GB/s", "speedup", "check");
+		}
+
+		/* bytes - moved by one device run (for the GB/s column), 0 - not a bandwidth case */
+		void addRow(std::string const& suite, std::string const& caseName, uint64_t size, double deviceMs, double hostMs, uint64_t bytes, bool passed)
+		{
+			double bandwidth = (bytes && deviceMs > 0.0) ? (bytes / (deviceMs * 1.0e6)) : 0.0;
+			double speedup = (deviceMs > 0.0 && hostMs > 0.0) ? (hostMs / deviceMs) : 0.0;
+			printf("%-14s %-26s %12llu %12.3f %12.3f %10.2f %8.2fx  %s\n",
+				suite.c_str(), caseName.c_str(), static_cast<unsigned long long>(size), deviceMs, hostMs, bandwidth, speedup, passed ? "PASS" : "FAIL");
+			fflush(stdout);
+
+			if (!passed)
+				++p_failures;
+		}
+
+		/* host overhead per call of two api paths over the same work */
+		void addOverheadRow(std::string const& suite, std::string const& caseName, uint64_t calls, double baselineUs, double optimizedUs, bool passed)
+		{
+			double speedup = (optimizedUs > 0.0 && baselineUs > 0.0) ? (baselineUs / optimizedUs) : 0.0;
+			printf("%-14s %-26s %12llu calls %9.3f us -> %9.3f us per call %8.2fx  %s\n",
+				suite.c_str(), caseName.c_str(), static_cast<unsigned long long>(calls), baselineUs, optimizedUs, speedup, passed ? "PASS" : "FAIL");
+			fflush(stdout);
+
+			if (!passed)
+				++p_failures;
+		}
+
+		void addSkipped(std::string const& suite, std::string const& reason)
+		{
+			printf("%-14s SKIPPED - %s\n", suite.c_str(), reason.c_str());
+			fflush(stdout);
+		}
+
+		void addError(std::string const& suite, std::string const& caseName, int error)
+		{
+			printf("%-14s %-26s ERROR %d\n", suite.c_str(), caseName.c_str(), error);
+			fflush(stdout);
+			++p_failures;
+		}
+
+		inline uint32_t getFailureCount() const { return p_failures; }
+
+	protected:
+		uint32_t p_failures{ 0 };
+	};
+
+
+	/* backend logs, the messages only in verbose mode */
+	class BenchApp final : public I_ComputeAppManager
+	{
+	public:
+		BenchApp(bool verbose)
+			: p_verbose(verbose)
+		{}
+
+		virtual void COMPUTE_LOGMESSAGE(std::string const& message) override final
+		{
+			if (p_verbose)
+				fprintf(stderr, "%s\n", message.c_str());
+		}
+
+		virtual void COMPUTE_LOGERROR(std::string const& message) override final
+		{
+			fprintf(stderr, "ERROR: %s\n", message.c_str());
+		}
+
+	protected:
+		bool p_verbose;
+	};
+
+
+	/* the suites add their resources and dispatches at runtime */
+	class BenchPipeline final
+		: public T_AppComputePipeline
+		<
+		BenchApp,
+		IComputeManager
+		>
+	{
+	public:
+		BenchPipeline(BenchApp* appMgr, IComputeManager* cMgr)
+			: T_AppComputePipeline
+			<
+			BenchApp,
+			IComputeManager
+			>
+			(appMgr, cMgr)
+		{}
+
+		virtual int setupAppComputePipeline() override final
+		{
+			return 0;
+		}
+	};
+
+
+	/**
+	* @class	BenchContext
+	* @brief	Compute manager with an empty pipeline and the kernel namespaces of a suite.
+	*--------------------------------------------------------------------------
+	* The backend keeps its manager in statics (resource and arg slots), so only one context
+	* is alive at a time, the suites create and destroy them sequentially.
+	*--------------------------------------------------------------------------
+	*/
+	class BenchContext final
+	{
+	public:
+		BenchContext(BenchOptions const& options)
+			: p_app(options.verbose)
+			, p_host(1, device::DeviceType::eCPU)
+		{}
+
+		~BenchContext()
+		{
+			p_pipeline.reset();
+			p_computeManager.reset();
+		}
+
+		/* namespaceSources - (kernel namespace, OpenCL C source), every namespace is built before the call returns */
+		int init(ContextDescription const& contextDesc, std::vector< std::pair<std::string, std::string> > const& namespaceSources)
+		{
+			p_computeManager = IComputeManager::createComputeManager(&p_app, device::DeviceApiType::eOPENCL, &p_host);
+			if (!p_computeManager)
+				return -1;
+
+			int result = p_computeManager->initContextandDevices(contextDesc);
+			if (result)
+				return result;
+
+			for (auto const& namespaceSource : namespaceSources)
+			{
+				result = p_computeManager->initKernelsFromSource({ namespaceSource.second.c_str() }, namespaceSource.first);
+				if (!result)
+					result = p_computeManager->getKernelsReady(namespaceSource.first).get();
+				if (result)
+					return result;
+			}
+
+			p_pipeline = std::make_shared<BenchPipeline>(&p_app, p_computeManager.get());
+			AppComputePipelineHandle pipelineHandle = p_pipeline;
+			return p_computeManager->initApplicationComputePipeline(pipelineHandle);
+		}
+
+		inline IComputeManager* getComputeManager() { return p_computeManager.get(); }
+		inline IApplicationComputePipeline* getPipeline() { return p_pipeline.get(); }
+
+		inline KernelIO* getKernelIO(std::string const& kernelName, std::string const& kernelNamespace = BENCH_KERNEL_NAMESPACE)
+		{
+			return p_pipeline->getKernelIO(kernelName, kernelNamespace);
+		}
+
+		inline BufferSlot* getBufferSlot(std::string const& tag)
+		{
+			return p_pipeline->getDataIO()->getImpl()->getBufferSlot(tag);
+		}
+
+		inline ImageSlot* getImageSlot(std::string const& tag)
+		{
+			return p_pipeline->getDataIO()->getImpl()->getImageSlot(tag);
+		}
+
+		int addBuffer(std::string const& tag, device::DataFormat format, uint64_t unitCount)
+		{
+			device::DataAttribute attribute;
+			attribute.setType(device::DataAttributeType::eUndefined).setFormat(format);
+
+			return p_pipeline->addBuffer(BufferDescription()
+				.setTag(tag)
+				.setMaxUnitCount(static_cast<uint32_t>(unitCount)) // #safecast
+				.setDataAttributeList({ attribute })
+				.setDataAccessQualifier(device::DataAccessQualifier::eDeviceLocal));
+		}
+
+		int addImage2D(std::string const& tag, device::DataFormat format, uint32_t width, uint32_t height)
+		{
+			return p_pipeline->addImage(ImageDescription()
+				.setTag(tag)
+				.setWidth(width)
+				.setHeight(height)
+				.setDataFormat(format)
+				.setResourceType(ImageViewType::e2D)
+				.setDataAccessQualifier(device::DataAccessQualifier::eDeviceLocal));
+		}
+
+		/* the dispatch tag is the kernel name */
+		int addDispatch(std::string const& kernelName, std::string const& kernelNamespace = BENCH_KERNEL_NAMESPACE)
+		{
+			return p_pipeline->addDispatch(DispatchDescription().setTag(kernelName).setKernelName(kernelName).setKernelNamespace(kernelNamespace));
+		}
+
+		/* blocking dispatch, a single node graph returns after the kernel completed */
+		int run(std::string const& tag, uint64_t globalWorkSize)
+		{
+			DispatchPayload dispatch;
+			dispatch.tag = tag;
+			dispatch.globalworksize = static_cast<size_t>(globalWorkSize); // #safecast
+
+			GraphPayload payload;
+			payload.dispatches.push_back(dispatch);
+			return p_pipeline->dispatchGraph(payload);
+		}
+
+		/* blocking transfers of the first count units */
+		template<typename T>
+		int write(std::string const& tag, T const* data, size_t count)
+		{
+			BufferSlot* slot = getBufferSlot(tag);
+			return slot ? slot->writeData(data, count * sizeof(T)) : -1;
+		}
+
+		template<typename T>
+		int read(std::string const& tag, T* data, size_t count)
+		{
+			BufferSlot* slot = getBufferSlot(tag);
+			return slot ? slot->readData(data, count * sizeof(T)) : -1;
+		}
+
+	protected:
+		BenchApp p_app;
+		device::Host p_host;
+		ComputeManagerHandle p_computeManager;
+		std::shared_ptr< BenchPipeline > p_pipeline;
+	};
+
+
+	/* suites, non-zero for a setup error (the failed checks are counted by the report) */
+	using BenchSuite = int(*)(BenchOptions const&, BenchReport&);
+
+	int RUN_CPU_DISPATCH(BenchOptions const& options, BenchReport& report);
+	int RUN_NUMA_BANDWIDTH(BenchOptions const& options, BenchReport& report);
+	int RUN_SLOT_OVERHEAD(BenchOptions const& options, BenchReport& report);
+	int RUN_HALF_BANDWIDTH(BenchOptions const& options, BenchReport& report);
+	int RUN_PRIMITIVES(BenchOptions const& options, BenchReport& report);
+
+} // end namespace bench
+
+
+#endif // !BENCH_COMMON
@@ -0,0 +1,106 @@
+/*
+* ---------------------------------------------------------
+* Copyright 2018-present (c) Automatos Studios. All Rights Reserved.
+* ---------------------------------------------------------
+*/
+
+/**
+* @file			benchCpuDispatch.cpp
+* @author		cosmoplankton < cosmoplankton@automatos.studio >
+*/
+
+
+#include "benchCommon.h"
+
+
+namespace bench
+{
+	static char const* const CPU_DISPATCH_KERNELS = R"CLC(
+__kernel void bench_saxpy(__global const float* x, __global const float* y, __global float* out, float a, uint count)
+{
+	size_t i = get_global_id(0);
+	if (i < count)
+		out[i] = a * x[i] + y[i];
+}
+)CLC";
+
+
+	/*
+	*-------------------------------
+	* CPU device path (DeviceProfile::eGeneral) against a scalar host loop, saxpy over the sweep sizes.
+	* The primary device is forced to the cpu, the suite is skipped without a cpu runtime (e.g. PoCL).
+	*-------------------------------
+	*/
+	int RUN_CPU_DISPATCH(BenchOptions const& options, BenchReport& report)
+	{
+		std::vector< uint64_t > sizes = GET_SWEEP_SIZES(options);
+		if (sizes.empty())
+			return 0;
+
+		BenchContext context(options);
+		int result = context.init(ContextDescription().setPrimaryDeviceType(device::DeviceType::eCPU), { { BENCH_KERNEL_NAMESPACE, CPU_DISPATCH_KERNELS } });
+		if (result)
+		{
+			report.addSkipped("cpu_dispatch", "no opencl cpu device (error " + std::to_string(result) + ")");
+			return 0;
+		}
+
+		uint64_t maxCount = sizes.back();
+		for (char const* tag : { "x", "y", "out" })
+		{
+			result = context.addBuffer(tag, device::DataFormat::eDouble32, maxCount);
+			if (result)
+				return result;
+		}
+
+		result = context.addDispatch("bench_saxpy");
+		if (result)
+			return result;
+
+		std::vector< float > x(maxCount), y(maxCount), out(maxCount), expected(maxCount);
+		for (uint64_t idx = 0; idx < maxCount; ++idx)
+		{
+			x[idx] = static_cast<float>(idx % 1024) * 0.5f;
+			y[idx] = static_cast<float>(idx % 97) - 48.0f;
+		}
+
+		const float a = 1.75f;
+		KernelIO* kernelIO = context.getKernelIO("bench_saxpy");
+		kernelIO->argBindBuffer(0, "x");
+		kernelIO->argBindBuffer(1, "y");
+		kernelIO->argBindBuffer(2, "out");
+		kernelIO->argSet<float>(3, a);
+
+		for (uint64_t count : sizes)
+		{
+			result = context.write("x", x.data(), count);
+			if (!result)
+				result = context.write("y", y.data(), count);
+			if (result)
+				return result;
+
+			kernelIO->argSet<uint32_t>(4, static_cast<uint32_t>(count)); // #safecast
+			double deviceMs = TIME_BEST_MS(options.repetitions, [&]() { return context.run("bench_saxpy", count); });
+
+			double hostMs = TIME_BEST_MS(options.repetitions, [&]()
+			{
+				for (uint64_t idx = 0; idx < count; ++idx)
+				{
+					expected[idx] = a * x[idx] + y[idx];
+				}
+				return 0;
+			});
+
+			bool passed = deviceMs >= 0.0 && !context.read("out", out.data(), count);
+			for (uint64_t idx = 0; passed && idx < count; ++idx)
+			{
+				passed = IS_CLOSE(out[idx], expected[idx]);
+			}
+
+			report.addRow("cpu_dispatch", "saxpy", count, deviceMs, hostMs, 3 * sizeof(float) * count, passed);
+		}
+
+		return 0;
+	}
+
+} // end namespace bench
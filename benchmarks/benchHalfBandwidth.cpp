@@ -0,0 +1,271 @@
+/*
+* ---------------------------------------------------------
+* Copyright 2018-present (c) Automatos Studios. All Rights Reserved.
+* ---------------------------------------------------------
+*/
+
+/**
+* @file			benchHalfBandwidth.cpp
+* @author		cosmoplankton < cosmoplankton@automatos.studio >
+*/
+
+
+#include <cstring>
+#include <iterator>
+
+#include "benchCommon.h"
+
+
+#define BENCH_HALF_IMAGE_WIDTH 4096			/* row length of the 2D images, the elements fill whole rows */
+#define BENCH_HALF_IMAGE_MAX_ROWS 4096		/* 16M texels, within the 2D image limits of the common devices */
+
+
+namespace bench
+{
+	static char const* const HALF_BANDWIDTH_KERNELS = R"CLC(
+__constant sampler_t BENCH_SAMPLER = CLK_NORMALIZED_COORDS_FALSE | CLK_ADDRESS_NONE | CLK_FILTER_NEAREST;
+
+__kernel void bench_scale_float(__global const float* in, __global float* out, float scale, uint count)
+{
+	size_t i = get_global_id(0);
+	if (i < count)
+		out[i] = scale * in[i] + 1.0f;
+}
+
+__kernel void bench_scale_half(__global const half* in, __global half* out, float scale, uint count)
+{
+	size_t i = get_global_id(0);
+	if (i < count)
+		compute_store_half(out, i, scale * compute_load_half(in, i) + 1.0f);
+}
+
+__kernel void bench_scale_image(__read_only image2d_t in, __write_only image2d_t out, float scale, uint count)
+{
+	size_t i = get_global_id(0);
+	if (i < count)
+	{
+		int2 coord = (int2)((int)(i % get_image_width(in)), (int)(i / get_image_width(in)));
+		float4 value = read_imagef(in, BENCH_SAMPLER, coord);
+		write_imagef(out, coord, (float4)(scale * value.x + 1.0f, 0.0f, 0.0f, 1.0f));
+	}
+}
+)CLC";
+
+
+	/* normal values and zero only, exact for the values the suite uses (see RUN_HALF_BANDWIDTH) */
+	static inline uint16_t FLOAT_TO_HALF(float value)
+	{
+		uint32_t bits = 0;
+		memcpy(&bits, &value, sizeof(bits));
+
+		uint16_t sign = static_cast<uint16_t>((bits >> 16) & 0x8000);
+		int32_t exponent = static_cast<int32_t>((bits >> 23) & 0xff) - 127 + 15;
+		if (!(bits & 0x7fffffff) || exponent <= 0)
+			return sign;
+
+		return static_cast<uint16_t>(sign | (exponent << 10) | ((bits >> 13) & 0x3ff));
+	}
+
+	static inline float HALF_TO_FLOAT(uint16_t value)
+	{
+		uint32_t sign = static_cast<uint32_t>(value & 0x8000) << 16;
+		uint32_t exponent = (value >> 10) & 0x1f;
+		uint32_t bits = exponent ? (sign | ((exponent - 15 + 127) << 23) | (static_cast<uint32_t>(value & 0x3ff) << 13)) : sign;
+
+		float result = 0.0f;
+		memcpy(&result, &bits, sizeof(result));
+		return result;
+	}
+
+
+	/* storage of one case, float or half bits */
+	template<typename T>
+	static inline T TO_STORAGE(float value);
+
+	template<>
+	inline float TO_STORAGE<float>(float value) { return value; }
+
+	template<>
+	inline uint16_t TO_STORAGE<uint16_t>(float value) { return FLOAT_TO_HALF(value); }
+
+	static inline float FROM_STORAGE(float value) { return value; }
+	static inline float FROM_STORAGE(uint16_t value) { return HALF_TO_FLOAT(value); }
+
+
+	/*
+	* scale kernel over the sweep sizes (up to maxCount) with T storage, read back and checked against the host.
+	* The images hold whole rows of BENCH_HALF_IMAGE_WIDTH, the tail of the last row is not part of the result.
+	*/
+	template<typename T>
+	static int RUN_STORAGE_CASE(BenchOptions const& options, BenchReport& report, BenchContext& context, std::string const& caseName,
+		std::string const& kernelName, bool isImage, std::vector< uint64_t > const& sizes, std::vector< float > const& in, std::vector< float > const& expected)
+	{
+		const uint64_t maxCount = sizes.back();
+		const uint64_t rowCount = (maxCount + BENCH_HALF_IMAGE_WIDTH - 1) / BENCH_HALF_IMAGE_WIDTH;
+		const uint64_t storageCount = isImage ? rowCount * BENCH_HALF_IMAGE_WIDTH : maxCount;
+
+		std::vector< T > storageIn(storageCount), storageOut(storageCount);
+		for (uint64_t idx = 0; idx < storageCount; ++idx)
+		{
+			storageIn[idx] = TO_STORAGE<T>(in[idx % in.size()]);
+		}
+
+		const float scale = 2.0f;
+		KernelIO* kernelIO = context.getKernelIO(kernelName);
+		kernelIO->argSet<float>(2, scale);
+
+		int result = 0;
+		if (isImage)
+		{
+			const size_t region[3] = { BENCH_HALF_IMAGE_WIDTH, static_cast<size_t>(rowCount), 1 };
+			result = context.getImageSlot(caseName + "_in")->writeData(storageIn.data(), region);
+		}
+		else
+		{
+			result = context.write(caseName + "_in", storageIn.data(), storageCount);
+		}
+		if (result)
+			return result;
+
+		for (uint64_t count : sizes)
+		{
+			kernelIO->argSet<uint32_t>(3, static_cast<uint32_t>(count)); // #safecast
+			double deviceMs = TIME_BEST_MS(options.repetitions, [&]() { return context.run(kernelName, count); });
+
+			bool passed = deviceMs >= 0.0;
+			if (passed && isImage)
+			{
+				const size_t rows = static_cast<size_t>((count + BENCH_HALF_IMAGE_WIDTH - 1) / BENCH_HALF_IMAGE_WIDTH);
+				const size_t region[3] = { BENCH_HALF_IMAGE_WIDTH, rows, 1 };
+				passed = !context.getImageSlot(caseName + "_out")->readData(storageOut.data(), region);
+			}
+			else if (passed)
+			{
+				passed = !context.read(caseName + "_out", storageOut.data(), count);
+			}
+
+			// half keeps 11 significant bits, the inputs and the results of the suite are exact in half
+			for (uint64_t idx = 0; passed && idx < count; ++idx)
+			{
+				passed = IS_CLOSE(FROM_STORAGE(storageOut[idx]), expected[idx % expected.size()], 1e-3);
+			}
+
+			report.addRow("half_bandwidth", caseName, count, deviceMs, 0.0, 2 * sizeof(T) * count, passed);
+		}
+
+		return 0;
+	}
+
+
+	/*
+	*-------------------------------
+	* Bandwidth of 16 bit (eFloat16) against 32 bit float storage for the same scale kernel, buffers
+	* (compute_load_half/compute_store_half of the half prelude) and single channel 2D images
+	* (CL_HALF_FLOAT/CL_FLOAT, read_imagef). Half moves half the bytes, the GB/s column counts the storage bytes.
+	* The image cases stop at BENCH_HALF_IMAGE_MAX_ROWS rows and are skipped on devices without the formats.
+	*-------------------------------
+	*/
+	int RUN_HALF_BANDWIDTH(BenchOptions const& options, BenchReport& report)
+	{
+		std::vector< uint64_t > sizes = GET_SWEEP_SIZES(options);
+		if (sizes.empty())
+			return 0;
+
+		std::vector< uint64_t > imageSizes;
+		std::copy_if(sizes.begin(), sizes.end(), std::back_inserter(imageSizes),
+			[](uint64_t size) { return size <= static_cast<uint64_t>(BENCH_HALF_IMAGE_WIDTH) * BENCH_HALF_IMAGE_MAX_ROWS; });
+
+		BenchContext context(options);
+		int result = context.init(ContextDescription(), { { BENCH_KERNEL_NAMESPACE, HALF_BANDWIDTH_KERNELS } });
+		if (result)
+			return result;
+
+		// one period of the inputs, values of 10 significant bits in [-256, 256) are exact in half (and so are the results)
+		std::vector< float > in(2048), expected(2048);
+		for (uint32_t idx = 0; idx < in.size(); ++idx)
+		{
+			in[idx] = static_cast<float>(idx) * 0.25f - 256.0f;
+			expected[idx] = 2.0f * in[idx] + 1.0f;
+		}
+
+		struct StorageCase
+		{
+			char const* name;
+			char const* kernel;
+			device::DataFormat format;
+			bool isImage;
+		} storageCases[] =
+		{
+			{ "buffer_float", "bench_scale_float", device::DataFormat::eDouble32, false },
+			{ "buffer_half", "bench_scale_half", device::DataFormat::eFloat16, false },
+			{ "image_float", "bench_scale_image", device::DataFormat::eDouble32, true },
+			{ "image_half", "bench_scale_image", device::DataFormat::eFloat16, true }
+		};
+
+		for (auto const& storageCase : storageCases)
+		{
+			std::vector< uint64_t > const& caseSizes = storageCase.isImage ? imageSizes : sizes;
+			if (caseSizes.empty())
+				continue;
+
+			std::string name = storageCase.name;
+			std::string inTag = name + "_in", outTag = name + "_out";
+			if (storageCase.isImage)
+			{
+				const uint32_t rows = static_cast<uint32_t>((caseSizes.back() + BENCH_HALF_IMAGE_WIDTH - 1) / BENCH_HALF_IMAGE_WIDTH); // #safecast
+				result = context.addImage2D(inTag, storageCase.format, BENCH_HALF_IMAGE_WIDTH, rows);
+				if (!result)
+					result = context.addImage2D(outTag, storageCase.format, BENCH_HALF_IMAGE_WIDTH, rows);
+				if (result)
+				{
+					context.getPipeline()->removeImage(inTag);
+					report.addSkipped("half_bandwidth", name + " format not supported by the device (error " + std::to_string(result) + ")");
+					continue;
+				}
+			}
+			else
+			{
+				result = context.addBuffer(inTag, storageCase.format, caseSizes.back());
+				if (!result)
+					result = context.addBuffer(outTag, storageCase.format, caseSizes.back());
+				if (result)
+					return result;
+			}
+
+			result = context.addDispatch(storageCase.kernel);
+			if (result)
+				return result;
+
+			KernelIO* kernelIO = context.getKernelIO(storageCase.kernel);
+			if (storageCase.isImage)
+			{
+				kernelIO->argBindImage(0, inTag);
+				kernelIO->argBindImage(1, outTag);
+			}
+			else
+			{
+				kernelIO->argBindBuffer(0, inTag);
+				kernelIO->argBindBuffer(1, outTag);
+			}
+
+			result = storageCase.format == device::DataFormat::eFloat16
+				? RUN_STORAGE_CASE<uint16_t>(options, report, context, name, storageCase.kernel, storageCase.isImage, caseSizes, in, expected)
+				: RUN_STORAGE_CASE<float>(options, report, context, name, storageCase.kernel, storageCase.isImage, caseSizes, in, expected);
+			if (result)
+				return result;
+
+			// the next case gets the memory back, the resources are unbound with the dispatch
+			result = context.getPipeline()->removeDispatch(storageCase.kernel);
+			for (std::string const& tag : { inTag, outTag })
+			{
+				if (!result)
+					result = storageCase.isImage ? context.getPipeline()->removeImage(tag) : context.getPipeline()->removeBuffer(tag);
+			}
+			if (result)
+				return result;
+		}
+
+		return 0;
+	}
+
+} // end namespace bench
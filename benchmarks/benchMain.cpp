@@ -0,0 +1,84 @@
+/*
+* ---------------------------------------------------------
+* Copyright 2018-present (c) Automatos Studios. All Rights Reserved.
+* ---------------------------------------------------------
+*/
+
+/**
+* @file			benchMain.cpp
+* @author		cosmoplankton < cosmoplankton@automatos.studio >
+*/
+
+
+#include <cstring>
+#include <exception>
+
+#include "benchCommon.h"
+
+
+/*
+*-------------------------------
+* benchmarks [--min N] [--max N] [--reps N] [--kernels DIR] [--verbose] [suite ...]
+*-------------------------------
+* Runs the selected suites (all by default) and prints one row per case. Every case checks the
+* device results against the host reference, the exit code is non-zero if any check failed.
+*-------------------------------
+*/
+int main(int argc, char* argv[])
+{
+	static const struct
+	{
+		char const* name;
+		bench::BenchSuite run;
+	} suites[] =
+	{
+		{ "cpu_dispatch", bench::RUN_CPU_DISPATCH },
+		{ "numa_bandwidth", bench::RUN_NUMA_BANDWIDTH },
+		{ "slot_overhead", bench::RUN_SLOT_OVERHEAD },
+		{ "half_bandwidth", bench::RUN_HALF_BANDWIDTH },
+		{ "primitives", bench::RUN_PRIMITIVES }
+	};
+
+	bench::BenchOptions options;
+	std::vector< std::string > selected;
+	for (int argIdx = 1; argIdx < argc; ++argIdx)
+	{
+		bool hasValue = argIdx + 1 < argc;
+		if (!strcmp(argv[argIdx], "--min") && hasValue)
+			options.minSize = std::stoull(argv[++argIdx]);
+		else if (!strcmp(argv[argIdx], "--max") && hasValue)
+			options.maxSize = std::stoull(argv[++argIdx]);
+		else if (!strcmp(argv[argIdx], "--reps") && hasValue)
+			options.repetitions = static_cast<uint32_t>(std::stoul(argv[++argIdx]));
+		else if (!strcmp(argv[argIdx], "--kernels") && hasValue)
+			options.kernelDirectory = argv[++argIdx];
+		else if (!strcmp(argv[argIdx], "--verbose"))
+			options.verbose = true;
+		else
+			selected.push_back(argv[argIdx]);
+	}
+
+	bench::BenchReport report;
+	for (auto const& suite : suites)
+	{
+		if (!selected.empty() && std::find(selected.begin(), selected.end(), suite.name) == selected.end())
+			continue;
+
+		int result = 0;
+		try
+		{
+			result = suite.run(options, report);
+		}
+		catch (std::exception const& e)
+		{
+			// a throwing suite is a failure (e.g. out_of_range of an unknown arg name)
+			report.addError(suite.name, e.what(), -1);
+		}
+
+		if (result)
+			report.addError(suite.name, "setup", result);
+	}
+
+	printf("%u failed\n", report.getFailureCount());
+	return report.getFailureCount() ? 1 : 0;
+}
@@ -0,0 +1,137 @@
+/*
+* ---------------------------------------------------------
+* Copyright 2018-present (c) Automatos Studios. All Rights Reserved.
+* ---------------------------------------------------------
+*/
+
+/**
+* @file			benchNumaBandwidth.cpp
+* @author		cosmoplankton < cosmoplankton@automatos.studio >
+*/
+
+
+#include "benchCommon.h"
+
+
+namespace bench
+{
+	static char const* const NUMA_BANDWIDTH_KERNELS = R"CLC(
+__kernel void bench_triad(__global float* a, __global const float* b, __global const float* c, float scalar, uint count)
+{
+	size_t i = get_global_id(0);
+	if (i < count)
+		a[i] = b[i] + scalar * c[i];
+}
+)CLC";
+
+
+	/* stream triad sweep on the primary device of contextDesc, CL_DEVICE_NOT_FOUND (-1) if there is no such device */
+	static int RUN_TRIAD_SWEEP(BenchOptions const& options, BenchReport& report, ContextDescription const& contextDesc, std::string const& caseName, std::vector< uint64_t > const& sizes)
+	{
+		BenchContext context(options);
+		int result = context.init(contextDesc, { { BENCH_KERNEL_NAMESPACE, NUMA_BANDWIDTH_KERNELS } });
+		if (result)
+			return result;
+
+		uint64_t maxCount = sizes.back();
+		for (char const* tag : { "a", "b", "c" })
+		{
+			result = context.addBuffer(tag, device::DataFormat::eDouble32, maxCount);
+			if (result)
+				return result;
+		}
+
+		result = context.addDispatch("bench_triad");
+		if (result)
+			return result;
+
+		std::vector< float > b(maxCount), c(maxCount), a(maxCount), expected(maxCount);
+		for (uint64_t idx = 0; idx < maxCount; ++idx)
+		{
+			b[idx] = static_cast<float>(idx % 251);
+			c[idx] = static_cast<float>(idx % 13) * 0.25f;
+		}
+
+		const float scalar = 3.0f;
+		KernelIO* kernelIO = context.getKernelIO("bench_triad");
+		kernelIO->argBindBuffer(0, "a");
+		kernelIO->argBindBuffer(1, "b");
+		kernelIO->argBindBuffer(2, "c");
+		kernelIO->argSet<float>(3, scalar);
+
+		for (uint64_t count : sizes)
+		{
+			result = context.write("b", b.data(), count);
+			if (!result)
+				result = context.write("c", c.data(), count);
+			if (result)
+				return result;
+
+			kernelIO->argSet<uint32_t>(4, static_cast<uint32_t>(count)); // #safecast
+			double deviceMs = TIME_BEST_MS(options.repetitions, [&]() { return context.run("bench_triad", count); });
+
+			double hostMs = TIME_BEST_MS(options.repetitions, [&]()
+			{
+				for (uint64_t idx = 0; idx < count; ++idx)
+				{
+					expected[idx] = b[idx] + scalar * c[idx];
+				}
+				return 0;
+			});
+
+			bool passed = deviceMs >= 0.0 && !context.read("a", a.data(), count);
+			for (uint64_t idx = 0; passed && idx < count; ++idx)
+			{
+				passed = IS_CLOSE(a[idx], expected[idx]);
+			}
+
+			report.addRow("numa", caseName, count, deviceMs, hostMs, 3 * sizeof(float) * count, passed);
+		}
+
+		return 0;
+	}
+
+
+	/*
+	*-------------------------------
+	* Memory bandwidth (stream triad) of the whole cpu device against each numa node of the fissioned
+	* device (ContextDescription::setIsNumaFission, opt-in). A node allocates and runs on its own memory,
+	* the nodes run one after the other (one compute manager at a time).
+	*-------------------------------
+	*/
+	int RUN_NUMA_BANDWIDTH(BenchOptions const& options, BenchReport& report)
+	{
+		std::vector< uint64_t > sizes = GET_SWEEP_SIZES(options);
+		if (sizes.empty())
+			return 0;
+
+		ContextDescription wholeDesc;
+		wholeDesc.setPrimaryDeviceType(device::DeviceType::eCPU);
+		int result = RUN_TRIAD_SWEEP(options, report, wholeDesc, "triad whole device", sizes);
+		if (result == -1) // CL_DEVICE_NOT_FOUND
+		{
+			report.addSkipped("numa", "no opencl cpu device");
+			return 0;
+		}
+		if (result)
+			return result;
+
+		uint32_t nodeCount = 0;
+		for (;; ++nodeCount)
+		{
+			ContextDescription nodeDesc;
+			nodeDesc.setIsNumaFission(true).setPrimaryDeviceType(device::DeviceType::eCPU).setPrimaryDeviceIndex(nodeCount);
+			result = RUN_TRIAD_SWEEP(options, report, nodeDesc, "triad numa node " + std::to_string(nodeCount), sizes);
+			if (result == -1)
+				break;
+			if (result)
+				return result;
+		}
+
+		if (nodeCount < 2)
+			report.addSkipped("numa", "no numa partition, the fissioned device is the whole device");
+
+		return 0;
+	}
+
+} // end namespace bench
@@ -0,0 +1,279 @@
+/*
+* ---------------------------------------------------------
+* Copyright 2018-present (c) Automatos Studios. All Rights Reserved.
+* ---------------------------------------------------------
+*/
+
+/**
+* @file			benchPrimitives.cpp
+* @author		cosmoplankton < cosmoplankton@automatos.studio >
+*/
+
+
+#include <atomic>
+#include <fstream>
+#include <iterator>
+#include <numeric>
+#include <execution>
+
+#include "benchCommon.h"
+#include "../source/devicemanager/computePrimitives.h"
+
+
+#define BENCH_PRIMITIVES_BINS 256			/* histogram bins over [0, 1), power of two so the bin scale is exact */
+#define BENCH_PRIMITIVES_NAN_STRIDE 997		/* every n-th histogram input is NaN (not counted) */
+
+
+namespace bench
+{
+	/* deterministic 32 bit hash of the index, the inputs are the same on every run */
+	static inline uint32_t HASH_INDEX(uint32_t idx)
+	{
+		idx ^= idx >> 16;
+		idx *= 0x7feb352dU;
+		idx ^= idx >> 15;
+		idx *= 0x846ca68bU;
+		idx ^= idx >> 16;
+		return idx;
+	}
+
+
+	/*
+	*-------------------------------
+	* ComputePrimitives (source/data/kernels/primitives.cl) over the sweep sizes against the std::execution::par
+	* host algorithms: reduce (float sum, std::transform_reduce), exclusive scan (uint, std::exclusive_scan),
+	* histogram (float, atomic bins over std::for_each, NaN inputs skipped), compaction (uint, std::copy_if) and
+	* radix sort (uint keys + values, std::stable_sort). The device time ends with a blocking read of the output,
+	* the GB/s column counts the input and output bytes of the primitive. Every result is checked.
+	*-------------------------------
+	*/
+	int RUN_PRIMITIVES(BenchOptions const& options, BenchReport& report)
+	{
+		std::vector< uint64_t > sizes = GET_SWEEP_SIZES(options);
+		if (sizes.empty())
+			return 0;
+
+		std::string sourceFile = options.kernelDirectory + "primitives.cl";
+		std::ifstream fileStream(sourceFile, std::ios::binary);
+		if (!fileStream.is_open())
+		{
+			report.addSkipped("primitives", "kernel source not found: " + sourceFile + " (see --kernels)");
+			return 0;
+		}
+		std::string source((std::istreambuf_iterator<char>(fileStream)), std::istreambuf_iterator<char>());
+
+		BenchContext context(options);
+		int result = context.init(ContextDescription(), { { COMPUTE_PRIMITIVES_NAMESPACE, source } });
+		if (result)
+			return result;
+
+		const uint32_t maxCount = static_cast<uint32_t>(sizes.back()); // #safecast
+		ComputePrimitives primitives(context.getComputeManager(), context.getPipeline());
+		result = primitives.init(maxCount);
+		if (result)
+			return result;
+
+		struct BufferSpec
+		{
+			char const* tag;
+			device::DataFormat format;
+			uint64_t count;
+		} bufferSpecs[] =
+		{
+			{ "values", device::DataFormat::eDouble32, maxCount },
+			{ "flags", device::DataFormat::eUint32, maxCount },
+			{ "scanned", device::DataFormat::eUint32, maxCount },
+			{ "keys", device::DataFormat::eUint32, maxCount },
+			{ "payload", device::DataFormat::eUint32, maxCount },
+			{ "sum", device::DataFormat::eDouble32, 1 },
+			{ "count", device::DataFormat::eUint32, 1 },
+			{ "bins", device::DataFormat::eUint32, BENCH_PRIMITIVES_BINS }
+		};
+
+		for (auto const& bufferSpec : bufferSpecs)
+		{
+			result = context.addBuffer(bufferSpec.tag, bufferSpec.format, bufferSpec.count);
+			if (result)
+				return result;
+		}
+
+		// values in [0, 1) (24 bit), flags 0..3 (scan input, compaction keeps the non-zero), keys full 32 bit, payload the index
+		std::vector< float > values(maxCount), nanValues(maxCount);
+		std::vector< uint32_t > flags(maxCount), keys(maxCount), payload(maxCount);
+		for (uint32_t idx = 0; idx < maxCount; ++idx)
+		{
+			uint32_t hash = HASH_INDEX(idx);
+			values[idx] = static_cast<float>(hash >> 8) * (1.0f / 16777216.0f);
+			nanValues[idx] = (idx % BENCH_PRIMITIVES_NAN_STRIDE) ? values[idx] : std::numeric_limits<float>::quiet_NaN();
+			flags[idx] = hash & 3;
+			keys[idx] = HASH_INDEX(idx ^ 0x9e3779b9U);
+			payload[idx] = idx;
+		}
+
+		result = context.write("values", values.data(), maxCount);
+		if (!result)
+			result = context.write("flags", flags.data(), maxCount);
+		if (!result)
+			result = context.write("payload", payload.data(), maxCount);
+		if (result)
+			return result;
+
+		std::vector< uint32_t > deviceOut(maxCount), deviceValues(maxCount), hostOut(maxCount);
+		std::vector< uint32_t > indices(maxCount);
+		std::iota(indices.begin(), indices.end(), 0u);
+
+		char const* caseName = "primitives";
+
+		// reduce
+		for (uint64_t size : sizes)
+		{
+			uint32_t count = static_cast<uint32_t>(size); // #safecast
+			float deviceSum = 0.0f;
+			double deviceMs = TIME_BEST_MS(options.repetitions, [&]()
+			{
+				int opResult = primitives.reduce(ReduceOp::eSum, device::DataFormat::eDouble32, "values", "sum", count);
+				return opResult ? opResult : context.read("sum", &deviceSum, 1);
+			});
+
+			double hostSum = 0.0;
+			double hostMs = TIME_BEST_MS(options.repetitions, [&]()
+			{
+				hostSum = std::transform_reduce(std::execution::par, values.begin(), values.begin() + count, 0.0, std::plus<double>(), [](float value) { return static_cast<double>(value); });
+				return 0;
+			});
+
+			bool passed = deviceMs >= 0.0 && IS_CLOSE(deviceSum, hostSum, 1e-4);
+			report.addRow(caseName, "reduce sum float", count, deviceMs, hostMs, sizeof(float) * count, passed);
+		}
+
+		// exclusive scan
+		for (uint64_t size : sizes)
+		{
+			uint32_t count = static_cast<uint32_t>(size); // #safecast
+			double deviceMs = TIME_BEST_MS(options.repetitions, [&]()
+			{
+				int opResult = primitives.scan(device::DataFormat::eUint32, "flags", "scanned", count);
+				return opResult ? opResult : context.read("scanned", deviceOut.data(), 1);
+			});
+
+			double hostMs = TIME_BEST_MS(options.repetitions, [&]()
+			{
+				std::exclusive_scan(std::execution::par, flags.begin(), flags.begin() + count, hostOut.begin(), 0u);
+				return 0;
+			});
+
+			bool passed = deviceMs >= 0.0 && !context.read("scanned", deviceOut.data(), count)
+				&& std::equal(deviceOut.begin(), deviceOut.begin() + count, hostOut.begin());
+			report.addRow(caseName, "scan exclusive uint", count, deviceMs, hostMs, 2 * sizeof(uint32_t) * count, passed);
+		}
+
+		// histogram, the NaN inputs are skipped
+		result = context.write("values", nanValues.data(), maxCount);
+		if (result)
+			return result;
+
+		std::vector< uint32_t > deviceBins(BENCH_PRIMITIVES_BINS);
+		std::vector< std::atomic<uint32_t> > hostBins(BENCH_PRIMITIVES_BINS);
+		for (uint64_t size : sizes)
+		{
+			uint32_t count = static_cast<uint32_t>(size); // #safecast
+			double deviceMs = TIME_BEST_MS(options.repetitions, [&]()
+			{
+				int opResult = primitives.histogram("values", "bins", count, BENCH_PRIMITIVES_BINS, 0.0f, 1.0f);
+				return opResult ? opResult : context.read("bins", deviceBins.data(), BENCH_PRIMITIVES_BINS);
+			});
+
+			double hostMs = TIME_BEST_MS(options.repetitions, [&]()
+			{
+				for (auto &pBin : hostBins)
+				{
+					pBin.store(0, std::memory_order_relaxed);
+				}
+
+				std::for_each(std::execution::par, nanValues.begin(), nanValues.begin() + count, [&hostBins](float value)
+				{
+					if (std::isnan(value))
+						return;
+
+					float bin = std::floor(value * static_cast<float>(BENCH_PRIMITIVES_BINS));
+					bin = std::min(std::max(bin, 0.0f), static_cast<float>(BENCH_PRIMITIVES_BINS - 1));
+					hostBins[static_cast<size_t>(bin)].fetch_add(1, std::memory_order_relaxed);
+				});
+				return 0;
+			});
+
+			bool passed = deviceMs >= 0.0;
+			uint64_t counted = 0;
+			for (uint32_t bin = 0; passed && bin < BENCH_PRIMITIVES_BINS; ++bin)
+			{
+				passed = deviceBins[bin] == hostBins[bin].load();
+				counted += deviceBins[bin];
+			}
+			passed = passed && counted == count - (count + BENCH_PRIMITIVES_NAN_STRIDE - 1) / BENCH_PRIMITIVES_NAN_STRIDE;
+			report.addRow(caseName, "histogram float (NaN)", count, deviceMs, hostMs, sizeof(float) * count, passed);
+		}
+
+		// compaction of the payload (the indices) with a non-zero flag
+		for (uint64_t size : sizes)
+		{
+			uint32_t count = static_cast<uint32_t>(size); // #safecast
+			uint32_t deviceCount = 0;
+			double deviceMs = TIME_BEST_MS(options.repetitions, [&]()
+			{
+				int opResult = primitives.compact("payload", "flags", "scanned", "count", count);
+				return opResult ? opResult : context.read("count", &deviceCount, 1);
+			});
+
+			size_t hostCount = 0;
+			double hostMs = TIME_BEST_MS(options.repetitions, [&]()
+			{
+				hostCount = static_cast<size_t>(std::copy_if(std::execution::par, indices.begin(), indices.begin() + count, hostOut.begin(),
+					[&flags](uint32_t idx) { return flags[idx] != 0; }) - hostOut.begin());
+				return 0;
+			});
+
+			bool passed = deviceMs >= 0.0 && deviceCount == hostCount && !context.read("scanned", deviceOut.data(), hostCount)
+				&& std::equal(deviceOut.begin(), deviceOut.begin() + hostCount, hostOut.begin());
+			report.addRow(caseName, "compact uint", count, deviceMs, hostMs, 2 * sizeof(uint32_t) * count + sizeof(uint32_t) * hostCount, passed);
+		}
+
+		// radix sort, sorting sorted keys again keeps them (and the stable order of the values)
+		std::vector< std::pair<uint32_t, uint32_t> > hostPairs(maxCount);
+		for (uint64_t size : sizes)
+		{
+			uint32_t count = static_cast<uint32_t>(size); // #safecast
+			result = context.write("keys", keys.data(), count);
+			if (!result)
+				result = context.write("payload", payload.data(), count);
+			if (result)
+				return result;
+
+			double deviceMs = TIME_BEST_MS(options.repetitions, [&]()
+			{
+				int opResult = primitives.radixSort("keys", "payload", count);
+				return opResult ? opResult : context.read("keys", deviceOut.data(), 1);
+			});
+
+			double hostMs = TIME_BEST_MS(options.repetitions, [&]()
+			{
+				for (uint32_t idx = 0; idx < count; ++idx)
+				{
+					hostPairs[idx] = std::make_pair(keys[idx], payload[idx]);
+				}
+				std::stable_sort(std::execution::par, hostPairs.begin(), hostPairs.begin() + count,
+					[](std::pair<uint32_t, uint32_t> const& a, std::pair<uint32_t, uint32_t> const& b) { return a.first < b.first; });
+				return 0;
+			});
+
+			bool passed = deviceMs >= 0.0 && !context.read("keys", deviceOut.data(), count) && !context.read("payload", deviceValues.data(), count);
+			for (uint32_t idx = 0; passed && idx < count; ++idx)
+			{
+				passed = deviceOut[idx] == hostPairs[idx].first && deviceValues[idx] == hostPairs[idx].second;
+			}
+			report.addRow(caseName, "radix sort uint", count, deviceMs, hostMs, 4 * sizeof(uint32_t) * count, passed);
+		}
+
+		return 0;
+	}
+
+} // end namespace bench
@@ -0,0 +1,139 @@
+/*
+* ---------------------------------------------------------
+* Copyright 2018-present (c) Automatos Studios. All Rights Reserved.
+* ---------------------------------------------------------
+*/
+
+/**
+* @file			benchSlotOverhead.cpp
+* @author		cosmoplankton < cosmoplankton@automatos.studio >
+*/
+
+
+#include "benchCommon.h"
+
+
+#define BENCH_OVERHEAD_CALLS 100000		/* arg updates per timed run */
+#define BENCH_OVERHEAD_DISPATCHES 10000	/* arg updates + dispatches per timed run */
+#define BENCH_OVERHEAD_COUNT 1024		/* elements of the dispatched kernel, small so the host overhead dominates */
+
+
+namespace bench
+{
+	static char const* const SLOT_OVERHEAD_KERNELS = R"CLC(
+__kernel void bench_scale(__global const float* in, __global float* out, float factor, uint count)
+{
+	size_t i = get_global_id(0);
+	if (i < count)
+		out[i] = factor * in[i];
+}
+)CLC";
+
+
+	/*
+	*-------------------------------
+	* Host overhead per call of the string keyed slot access (kernel io lookup, args by name, buffers by tag)
+	* against the interned ids (TypedKernel, BufferId), for the arg updates alone and with a dispatch.
+	* The dispatched runs end with a blocking read of the output, so the queued kernels are part of the timing.
+	*-------------------------------
+	*/
+	int RUN_SLOT_OVERHEAD(BenchOptions const& options, BenchReport& report)
+	{
+		BenchContext context(options);
+		int result = context.init(ContextDescription(), { { BENCH_KERNEL_NAMESPACE, SLOT_OVERHEAD_KERNELS } });
+		if (result)
+			return result;
+
+		for (char const* tag : { "in", "out" })
+		{
+			result = context.addBuffer(tag, device::DataFormat::eDouble32, BENCH_OVERHEAD_COUNT);
+			if (result)
+				return result;
+		}
+
+		result = context.addDispatch("bench_scale");
+		if (result)
+			return result;
+
+		std::vector< float > in(BENCH_OVERHEAD_COUNT), out(BENCH_OVERHEAD_COUNT);
+		for (uint32_t idx = 0; idx < BENCH_OVERHEAD_COUNT; ++idx)
+		{
+			in[idx] = static_cast<float>(idx) - 512.0f;
+		}
+
+		result = context.write("in", in.data(), in.size());
+		if (result)
+			return result;
+
+		// ids are resolved once at setup
+		BufferId inId = context.getPipeline()->getDataIO()->resolveBuffer("in");
+		BufferId outId = context.getPipeline()->getDataIO()->resolveBuffer("out");
+		TypedKernel< BufferId, BufferId, float, uint32_t > typedKernel;
+		result = typedKernel.init(context.getKernelIO("bench_scale"));
+		if (result)
+			return result;
+
+		DispatchPayload payload;
+		payload.tag = "bench_scale";
+		payload.globalworksize = BENCH_OVERHEAD_COUNT;
+
+		const uint32_t count = BENCH_OVERHEAD_COUNT;
+		float factor = 0.0f;
+
+		auto byName = [&](uint32_t calls, bool withDispatch)
+		{
+			for (uint32_t call = 0; call < calls; ++call)
+			{
+				factor = static_cast<float>(call % 7) + 0.5f;
+				KernelIO* kernelIO = context.getKernelIO("bench_scale");
+				kernelIO->argBindBuffer("in", "in");
+				kernelIO->argBindBuffer("out", "out");
+				kernelIO->argSet<float>("factor", factor);
+				kernelIO->argSet<uint32_t>("count", count);
+				if (withDispatch && context.getPipeline()->dispatch(payload))
+					return -1;
+			}
+			return withDispatch ? context.read("out", out.data(), out.size()) : 0;
+		};
+
+		auto byId = [&](uint32_t calls, bool withDispatch)
+		{
+			for (uint32_t call = 0; call < calls; ++call)
+			{
+				factor = static_cast<float>(call % 7) + 0.5f;
+				typedKernel.set(inId, outId, factor, count);
+				if (withDispatch && context.getPipeline()->dispatch(payload))
+					return -1;
+			}
+			return withDispatch ? context.read("out", out.data(), out.size()) : 0;
+		};
+
+		auto checkOutput = [&]()
+		{
+			if (context.read("out", out.data(), out.size()))
+				return false;
+
+			for (uint32_t idx = 0; idx < BENCH_OVERHEAD_COUNT; ++idx)
+			{
+				if (!IS_CLOSE(out[idx], factor * in[idx]))
+					return false;
+			}
+			return true;
+		};
+
+		double nameMs = TIME_BEST_MS(options.repetitions, [&]() { return byName(BENCH_OVERHEAD_CALLS, false); });
+		double idMs = TIME_BEST_MS(options.repetitions, [&]() { return byId(BENCH_OVERHEAD_CALLS, false); });
+		report.addOverheadRow("slot_overhead", "args by name -> by id", BENCH_OVERHEAD_CALLS,
+			nameMs * 1000.0 / BENCH_OVERHEAD_CALLS, idMs * 1000.0 / BENCH_OVERHEAD_CALLS, nameMs >= 0.0 && idMs >= 0.0);
+
+		nameMs = TIME_BEST_MS(options.repetitions, [&]() { return byName(BENCH_OVERHEAD_DISPATCHES, true); });
+		bool passed = nameMs >= 0.0 && checkOutput();
+		idMs = TIME_BEST_MS(options.repetitions, [&]() { return byId(BENCH_OVERHEAD_DISPATCHES, true); });
+		passed = passed && idMs >= 0.0 && checkOutput();
+		report.addOverheadRow("slot_overhead", "args+dispatch name -> id", BENCH_OVERHEAD_DISPATCHES,
+			nameMs * 1000.0 / BENCH_OVERHEAD_DISPATCHES, idMs * 1000.0 / BENCH_OVERHEAD_DISPATCHES, passed);
+
+		return 0;
+	}
+
+} // end namespace bench
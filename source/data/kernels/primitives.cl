@@ -0,0 +1,378 @@
+/*
+* ---------------------------------------------------------
+* Copyright 2018-present (c) Automatos Studios. All Rights Reserved.
+* ---------------------------------------------------------
+*/
+
+/**
+* @file			primitives.cl
+* @author		cosmoplankton < cosmoplankton@automatos.studio >
+*/
+
+
+/*
+*-------------------------------------------------------------
+* Parallel primitives, kernel namespace "primitives" (see graphics_compute::ComputePrimitives).
+*-------------------------------------------------------------
+* Every kernel runs PRIM_GROUP_SIZE work-items per group over a grid of groups sized by the host from the
+* compute units of the device (see ComputePrimitives::getGroupCount). Group g owns the
+* contiguous tile [g * tile, (g + 1) * tile) of the elements and walks it in blocks of the group size,
+* so the global reads are coalesced and the per group results (partials) come out in element order.
+* The single group kernels (prim_scan_groups_*) run with a grid of one group.
+* Counts are limited to 2^31 elements.
+*-------------------------------------------------------------
+*/
+
+#define PRIM_GROUP_SIZE 256
+#define PRIM_RADIX_BITS 4
+#define PRIM_RADIX_DIGITS (1 << PRIM_RADIX_BITS)
+#define PRIM_LOCAL_BINS 1024
+
+#define PRIM_KERNEL __kernel __attribute__((reqd_work_group_size(PRIM_GROUP_SIZE, 1, 1)))
+
+
+/* the dispatch could distribute the groups over up to 3 dimensions */
+static inline uint prim_group_id(void)
+{
+	return (uint)(get_group_id(0) + get_num_groups(0) * (get_group_id(1) + get_num_groups(1) * get_group_id(2)));
+}
+
+static inline uint prim_group_count(void)
+{
+	return (uint)(get_num_groups(0) * get_num_groups(1) * get_num_groups(2));
+}
+
+/* tile of the group, a multiple of the group size so only the last non-empty tile is partial */
+static inline void prim_tile(uint count, uint* begin, uint* end)
+{
+	uint groups = prim_group_count();
+	uint blocks = (count + PRIM_GROUP_SIZE - 1) / PRIM_GROUP_SIZE;
+	uint tile = ((blocks + groups - 1) / groups) * PRIM_GROUP_SIZE;
+
+	*begin = min(prim_group_id() * tile, count);
+	*end = min(*begin + tile, count);
+}
+
+
+/*
+*-------------------------------------------------------------
+* reduce - out[group] = op over the tile of the group
+*-------------------------------------------------------------
+* A grid of G groups writes G partials, a second dispatch with one group over the partials writes the result.
+*/
+#define PRIM_ADD(a, b) ((a) + (b))
+
+#define PRIM_REDUCE_KERNEL(T, NAME, OP, IDENTITY)												\
+PRIM_KERNEL void prim_reduce_##NAME##_##T(__global const T* prim_in, __global T* prim_out, uint prim_count)	\
+{																								\
+	__local T scratch[PRIM_GROUP_SIZE];															\
+	uint lid = get_local_id(0);																	\
+	uint begin, end;																			\
+	prim_tile(prim_count, &begin, &end);														\
+																								\
+	T acc = IDENTITY;																			\
+	for (uint i = begin + lid; i < end; i += PRIM_GROUP_SIZE)									\
+		acc = OP(acc, prim_in[i]);																\
+																								\
+	scratch[lid] = acc;																			\
+	barrier(CLK_LOCAL_MEM_FENCE);																\
+	for (uint offset = PRIM_GROUP_SIZE / 2; offset > 0; offset >>= 1)							\
+	{																							\
+		if (lid < offset)																		\
+			scratch[lid] = OP(scratch[lid], scratch[lid + offset]);								\
+		barrier(CLK_LOCAL_MEM_FENCE);															\
+	}																							\
+																								\
+	if (lid == 0)																				\
+		prim_out[prim_group_id()] = scratch[0];													\
+}
+
+PRIM_REDUCE_KERNEL(float, sum, PRIM_ADD, 0.0f)
+PRIM_REDUCE_KERNEL(float, min, min, FLT_MAX)
+PRIM_REDUCE_KERNEL(float, max, max, -FLT_MAX)
+PRIM_REDUCE_KERNEL(int, sum, PRIM_ADD, 0)
+PRIM_REDUCE_KERNEL(int, min, min, INT_MAX)
+PRIM_REDUCE_KERNEL(int, max, max, INT_MIN)
+PRIM_REDUCE_KERNEL(uint, sum, PRIM_ADD, 0u)
+PRIM_REDUCE_KERNEL(uint, min, min, UINT_MAX)
+PRIM_REDUCE_KERNEL(uint, max, max, 0u)
+
+
+/*
+*-------------------------------------------------------------
+* scan - prefix sums (reduce, scan of the partials, apply)
+*-------------------------------------------------------------
+* 1. prim_reduce_sum_T - partials of the tiles.
+* 2. prim_scan_groups_T - exclusive scan of the partials in place (one group), total of all the elements.
+* 3. prim_scan_apply_T - every tile is scanned block by block, seeded with its scanned partial.
+*/
+
+/* exclusive scan of the block (Hillis-Steele), every work-item of the group has to call it */
+#define PRIM_BLOCK_SCAN(T)																		\
+static inline T prim_block_scan_##T(__local T* scratch, T value, T* total)							\
+{																								\
+	uint lid = get_local_id(0);																	\
+	scratch[lid] = value;																		\
+	barrier(CLK_LOCAL_MEM_FENCE);																\
+	for (uint offset = 1; offset < PRIM_GROUP_SIZE; offset <<= 1)								\
+	{																							\
+		T add = lid >= offset ? scratch[lid - offset] : (T)0;									\
+		barrier(CLK_LOCAL_MEM_FENCE);															\
+		scratch[lid] += add;																	\
+		barrier(CLK_LOCAL_MEM_FENCE);															\
+	}																							\
+																								\
+	T exclusive = lid ? scratch[lid - 1] : (T)0;												\
+	*total = scratch[PRIM_GROUP_SIZE - 1];														\
+	barrier(CLK_LOCAL_MEM_FENCE);																\
+	return exclusive;																			\
+}
+
+#define PRIM_SCAN_KERNELS(T)																	\
+PRIM_BLOCK_SCAN(T)																				\
+																								\
+PRIM_KERNEL void prim_scan_groups_##T(__global T* prim_data, __global T* prim_total, uint prim_count)	\
+{																								\
+	__local T scratch[PRIM_GROUP_SIZE];															\
+	uint lid = get_local_id(0);																	\
+																								\
+	T carry = (T)0;																				\
+	for (uint base = 0; base < prim_count; base += PRIM_GROUP_SIZE)								\
+	{																							\
+		uint i = base + lid;																	\
+		T value = i < prim_count ? prim_data[i] : (T)0;											\
+		T total;																				\
+		T exclusive = prim_block_scan_##T(scratch, value, &total);								\
+		if (i < prim_count)																		\
+			prim_data[i] = carry + exclusive;													\
+		carry += total;																			\
+	}																							\
+																								\
+	if (lid == 0)																				\
+		prim_total[0] = carry;																	\
+}																								\
+																								\
+PRIM_KERNEL void prim_scan_apply_##T(__global const T* prim_in, __global T* prim_out, __global const T* prim_partials, uint prim_count, uint prim_inclusive)	\
+{																								\
+	__local T scratch[PRIM_GROUP_SIZE];															\
+	uint lid = get_local_id(0);																	\
+	uint begin, end;																			\
+	prim_tile(prim_count, &begin, &end);														\
+																								\
+	T carry = prim_partials[prim_group_id()];													\
+	for (uint base = begin; base < end; base += PRIM_GROUP_SIZE)								\
+	{																							\
+		uint i = base + lid;																	\
+		T value = i < end ? prim_in[i] : (T)0;													\
+		T total;																				\
+		T exclusive = prim_block_scan_##T(scratch, value, &total);								\
+		if (i < end)																			\
+			prim_out[i] = carry + exclusive + (prim_inclusive ? value : (T)0);					\
+		carry += total;																			\
+	}																							\
+}
+
+PRIM_SCAN_KERNELS(float)
+PRIM_SCAN_KERNELS(int)
+PRIM_SCAN_KERNELS(uint)
+
+
+/*
+*-------------------------------------------------------------
+* fill - out[i] = value (clears the histogram bins)
+*-------------------------------------------------------------
+*/
+PRIM_KERNEL void prim_fill_uint(__global uint* prim_out, uint prim_value, uint prim_count)
+{
+	uint begin, end;
+	prim_tile(prim_count, &begin, &end);
+
+	for (uint i = begin + get_local_id(0); i < end; i += PRIM_GROUP_SIZE)
+		prim_out[i] = prim_value;
+}
+
+
+/*
+*-------------------------------------------------------------
+* histogram - bins[clamp((x - minValue) * scale)] += 1, accumulates into the bins
+*-------------------------------------------------------------
+* Values outside [minValue, minValue + binCount / scale) count into the first/last bin, NaN values are skipped
+* (the conversion of a NaN bin index is undefined). Up to PRIM_LOCAL_BINS
+* bins the group counts in local memory and adds its counts to the global bins once.
+*/
+PRIM_KERNEL void prim_histogram_float(__global const float* prim_in, __global uint* prim_bins, uint prim_count, uint prim_binCount, float prim_minValue, float prim_scale)
+{
+	__local uint localBins[PRIM_LOCAL_BINS];
+	uint lid = get_local_id(0);
+	uint begin, end;
+	prim_tile(prim_count, &begin, &end);
+
+	bool isLocal = prim_binCount <= PRIM_LOCAL_BINS;
+	if (isLocal)
+	{
+		for (uint bin = lid; bin < prim_binCount; bin += PRIM_GROUP_SIZE)
+			localBins[bin] = 0;
+	}
+	barrier(CLK_LOCAL_MEM_FENCE);
+
+	float lastBin = (float)(prim_binCount - 1);
+	for (uint i = begin + lid; i < end; i += PRIM_GROUP_SIZE)
+	{
+		float value = prim_in[i];
+		if (isnan(value))
+			continue;
+
+		uint bin = (uint)clamp(floor((value - prim_minValue) * prim_scale), 0.0f, lastBin);
+		if (isLocal)
+			atomic_inc(&localBins[bin]);
+		else
+			atomic_inc(&prim_bins[bin]);
+	}
+	barrier(CLK_LOCAL_MEM_FENCE);
+
+	if (isLocal)
+	{
+		for (uint bin = lid; bin < prim_binCount; bin += PRIM_GROUP_SIZE)
+		{
+			if (localBins[bin])
+				atomic_add(&prim_bins[bin], localBins[bin]);
+		}
+	}
+}
+
+
+/*
+*-------------------------------------------------------------
+* radix sort - stable LSD sort of uint keys (+ uint values), PRIM_RADIX_BITS per pass
+*-------------------------------------------------------------
+* 1. prim_radix_count - digit counts of every tile, digit major (histogram[digit * groups + group]).
+* 2. prim_scan_groups_uint - exclusive scan of the counts, the scatter base of every (digit, tile).
+* 3. prim_radix_scatter - every tile is scattered block by block, the rank of an element among the
+*    elements of its digit in the block comes from a block scan of 16 bit counters (two digits per uint).
+*/
+PRIM_KERNEL void prim_radix_count(__global const uint* prim_keys, __global uint* prim_histogram, uint prim_count, uint prim_shift)
+{
+	__local uint counts[PRIM_RADIX_DIGITS];
+	uint lid = get_local_id(0);
+	uint begin, end;
+	prim_tile(prim_count, &begin, &end);
+
+	if (lid < PRIM_RADIX_DIGITS)
+		counts[lid] = 0;
+	barrier(CLK_LOCAL_MEM_FENCE);
+
+	for (uint i = begin + lid; i < end; i += PRIM_GROUP_SIZE)
+		atomic_inc(&counts[(prim_keys[i] >> prim_shift) & (PRIM_RADIX_DIGITS - 1)]);
+	barrier(CLK_LOCAL_MEM_FENCE);
+
+	if (lid < PRIM_RADIX_DIGITS)
+		prim_histogram[lid * prim_group_count() + prim_group_id()] = counts[lid];
+}
+
+PRIM_KERNEL void prim_radix_scatter(__global const uint* prim_keysIn, __global const uint* prim_valuesIn, __global uint* prim_keysOut, __global uint* prim_valuesOut, __global const uint* prim_histogram, uint prim_count, uint prim_shift)
+{
+	__local uint digitBase[PRIM_RADIX_DIGITS];
+	__local uint blockTotals[PRIM_RADIX_DIGITS];
+	__local uint counters[(PRIM_RADIX_DIGITS / 2) * PRIM_GROUP_SIZE];
+	uint lid = get_local_id(0);
+	uint begin, end;
+	prim_tile(prim_count, &begin, &end);
+
+	if (lid < PRIM_RADIX_DIGITS)
+		digitBase[lid] = prim_histogram[lid * prim_group_count() + prim_group_id()];
+	barrier(CLK_LOCAL_MEM_FENCE);
+
+	for (uint base = begin; base < end; base += PRIM_GROUP_SIZE)
+	{
+		uint i = base + lid;
+		bool isValid = i < end;
+		uint key = isValid ? prim_keysIn[i] : 0;
+		uint digit = (key >> prim_shift) & (PRIM_RADIX_DIGITS - 1);
+
+		// one-hot 16 bit counter of the digit, the block holds at most PRIM_GROUP_SIZE elements of a digit
+		for (uint k = 0; k < PRIM_RADIX_DIGITS / 2; ++k)
+			counters[k * PRIM_GROUP_SIZE + lid] = (isValid && (digit >> 1) == k) ? (1u << ((digit & 1) * 16)) : 0;
+		barrier(CLK_LOCAL_MEM_FENCE);
+
+		for (uint offset = 1; offset < PRIM_GROUP_SIZE; offset <<= 1)
+		{
+			uint add[PRIM_RADIX_DIGITS / 2];
+			for (uint k = 0; k < PRIM_RADIX_DIGITS / 2; ++k)
+				add[k] = lid >= offset ? counters[k * PRIM_GROUP_SIZE + lid - offset] : 0;
+			barrier(CLK_LOCAL_MEM_FENCE);
+			for (uint k = 0; k < PRIM_RADIX_DIGITS / 2; ++k)
+				counters[k * PRIM_GROUP_SIZE + lid] += add[k];
+			barrier(CLK_LOCAL_MEM_FENCE);
+		}
+
+		if (lid < PRIM_RADIX_DIGITS)
+			blockTotals[lid] = (counters[(lid >> 1) * PRIM_GROUP_SIZE + PRIM_GROUP_SIZE - 1] >> ((lid & 1) * 16)) & 0xFFFF;
+
+		if (isValid)
+		{
+			uint rank = ((counters[(digit >> 1) * PRIM_GROUP_SIZE + lid] >> ((digit & 1) * 16)) & 0xFFFF) - 1;
+			uint dst = digitBase[digit] + rank;
+			prim_keysOut[dst] = key;
+			prim_valuesOut[dst] = prim_valuesIn[i];
+		}
+		barrier(CLK_LOCAL_MEM_FENCE);
+
+		if (lid < PRIM_RADIX_DIGITS)
+			digitBase[lid] += blockTotals[lid];
+		barrier(CLK_LOCAL_MEM_FENCE);
+	}
+}
+
+
+/*
+*-------------------------------------------------------------
+* stream compaction - out = values[i] with flags[i] != 0, order preserved
+*-------------------------------------------------------------
+* 1. prim_compact_count - flagged elements of every tile.
+* 2. prim_scan_groups_uint - output offset of every tile, total = output count.
+* 3. prim_compact_scatter - block scan of the flags seeded with the tile offset.
+* The values are any 32 bit data (floats are moved bitwise).
+*/
+PRIM_KERNEL void prim_compact_count(__global const uint* prim_flags, __global uint* prim_partials, uint prim_count)
+{
+	__local uint scratch[PRIM_GROUP_SIZE];
+	uint lid = get_local_id(0);
+	uint begin, end;
+	prim_tile(prim_count, &begin, &end);
+
+	uint flagged = 0;
+	for (uint i = begin + lid; i < end; i += PRIM_GROUP_SIZE)
+		flagged += prim_flags[i] ? 1 : 0;
+
+	scratch[lid] = flagged;
+	barrier(CLK_LOCAL_MEM_FENCE);
+	for (uint offset = PRIM_GROUP_SIZE / 2; offset > 0; offset >>= 1)
+	{
+		if (lid < offset)
+			scratch[lid] += scratch[lid + offset];
+		barrier(CLK_LOCAL_MEM_FENCE);
+	}
+
+	if (lid == 0)
+		prim_partials[prim_group_id()] = scratch[0];
+}
+
+PRIM_KERNEL void prim_compact_scatter(__global const uint* prim_values, __global const uint* prim_flags, __global uint* prim_out, __global const uint* prim_partials, uint prim_count)
+{
+	__local uint scratch[PRIM_GROUP_SIZE];
+	uint lid = get_local_id(0);
+	uint begin, end;
+	prim_tile(prim_count, &begin, &end);
+
+	uint carry = prim_partials[prim_group_id()];
+	for (uint base = begin; base < end; base += PRIM_GROUP_SIZE)
+	{
+		uint i = base + lid;
+		uint flag = (i < end && prim_flags[i]) ? 1 : 0;
+		uint total;
+		uint exclusive = prim_block_scan_uint(scratch, flag, &total);
+		if (flag)
+			prim_out[carry + exclusive] = prim_values[i];
+		carry += total;
+	}
+}
@@ -17,6 +17,9 @@
 
 
 #include <memory>
+#include <utility>
+#include <algorithm>
+#include <future>
 
 namespace graphics_compute
 {
@@ -47,6 +50,69 @@ namespace graphics_compute
 	};
 
 
+	/**
+	* @class	ContextDescription
+	* @brief	Description of the compute context and device initialization.
+	*/
+	class ContextDescription final
+	{
+		using this_ref = ContextDescription & ;
+	public:
+		inline auto getIsOutOfOrderCompute() const { return m_outOfOrderCompute; }
+		inline auto const& getProgramCacheDirectory() const { return m_programCacheDirectory; }
+		inline auto getIsNumaFission() const { return m_numaFission; }
+		inline auto const& getTuningDatabasePath() const { return m_tuningDatabasePath; }
+		inline auto getIsProfiling() const { return m_profiling; }
+		inline auto getPrimaryDeviceType() const { return m_primaryDeviceType; }
+		inline auto getPrimaryDeviceIndex() const { return m_primaryDeviceIndex; }
+
+		/* out of order compute queues (if supported), dispatches without data hazards run concurrently */
+		inline this_ref setIsOutOfOrderCompute(bool outOfOrder) { m_outOfOrderCompute = outOfOrder; return *this; }
+
+		/* existing directory for the compiled program binaries, empty disables the program cache */
+		inline this_ref setProgramCacheDirectory(std::string const& directory) { m_programCacheDirectory = directory; return *this; }
+
+		/* split multi-socket cpu devices into one device per numa node, each with its own context and memory */
+		inline this_ref setIsNumaFission(bool numaFission) { m_numaFission = numaFission; return *this; }
+
+		/* file of the work-group autotuning results (see DispatchDescription::setIsAutotuned), empty keeps them in memory */
+		inline this_ref setTuningDatabasePath(std::string const& path) { m_tuningDatabasePath = path; return *this; }
+
+		/* profiling queues and per dispatch/transfer timings (see IComputeManager::getTimingStats), adds a small per command overhead */
+		inline this_ref setIsProfiling(bool profiling) { m_profiling = profiling; return *this; }
+
+		/* type of the primary device (runs the pipeline), eUndefined - a gpu if available else a cpu */
+		inline this_ref setPrimaryDeviceType(device::DeviceType type) { m_primaryDeviceType = type; return *this; }
+
+		/* n-th device of the primary device type, e.g. a numa node of a fissioned cpu (see setIsNumaFission) */
+		inline this_ref setPrimaryDeviceIndex(uint32_t index) { m_primaryDeviceIndex = index; return *this; }
+
+	protected:
+		bool m_outOfOrderCompute{ true };
+		bool m_numaFission{ false };
+		bool m_profiling{ false };
+		device::DeviceType m_primaryDeviceType{ device::DeviceType::eUndefined };
+		uint32_t m_primaryDeviceIndex{ 0 };
+		std::string m_programCacheDirectory;
+		std::string m_tuningDatabasePath;
+	};
+
+
+	/**
+	* @enum		BufferLayout
+	* @brief	Placement of the attributes of a multi-attribute buffer.
+	*--------------------------------------------------------------------------
+	* ePackedAoS - units of all the attributes back to back, no padding (unit stride = sum of the attribute sizes).
+	* eSoA - one contiguous stream per attribute (maxUnitCount values each), coalesced per attribute access.
+	*--------------------------------------------------------------------------
+	*/
+	enum class BufferLayout : uint32_t
+	{
+		ePackedAoS = 0x0,
+		eSoA = 0x1
+	};
+
+
 	/**
 	* @class	BufferDescription
 	* @brief	Description of buffer reaources.
@@ -59,17 +125,20 @@ namespace graphics_compute
 		inline auto getMaxUnitCount() const { return m_maxUnitCount; }
 		inline auto const& getDataAttributes() const { return m_dataAttributes; }
 		inline auto getDataAccessQualifier() const { return m_dataAccessQ; }
+		inline auto getLayout() const { return m_layout; }
 
 		inline this_ref setTag(std::string const& tag) { m_tag = tag; return *this; }
 		inline this_ref setMaxUnitCount(uint32_t count) { m_maxUnitCount = count; return *this; }
 		inline this_ref setDataAttributeList(device::DataAttributeList const& list) { m_dataAttributes = list; return *this; }
 		inline this_ref setDataAccessQualifier(device::DataAccessQualifier accessQ) { m_dataAccessQ = accessQ; return *this; }
+		inline this_ref setLayout(BufferLayout layout) { m_layout = layout; return *this; }
 
 	protected:
 		std::string m_tag;
 		uint32_t m_maxUnitCount{ 0 };
 		device::DataAttributeList m_dataAttributes;
 		device::DataAccessQualifier m_dataAccessQ{ device::DataAccessQualifier::eHostToDevice };
+		BufferLayout m_layout{ BufferLayout::ePackedAoS };
 	};
 
 
@@ -128,6 +197,41 @@ namespace graphics_compute
 	};
 
 
+	/**
+	* @class	PipeDescription
+	* @brief	Description of a pipe resource (bounded fifo of packets between a producer and a consumer kernel).
+	*----------------------------------------
+	* Kernels declare the pipe args with the prelude macros, the same source builds with native pipes
+	* (OpenCL 2.0 devices) and with the ring buffer fallback:
+	*	__kernel void detect(..., COMPUTE_PIPE_OUT(Record, records)) { ... compute_write_pipe(records, &record); }
+	*	__kernel void fit(COMPUTE_PIPE_IN(Record, records), ...) { ... if (compute_read_pipe(records, &record) == 0) ... }
+	* Writes to a full pipe and reads from an empty pipe fail (non-zero), as read_pipe/write_pipe.
+	*
+	* The ring buffer fallback is a staging buffer, not a stream: the consumer dispatch starts only after
+	* the producer dispatch completed, so maxPackets has to hold every packet of a producer dispatch.
+	* Writes dropped on a full ring are reported by waitGraph() (and the blocking dispatchGraph()) as
+	* CL_OUT_OF_RESOURCES. Only the namespaces declaring pipe args build with the pipe prelude and OpenCL C 2.0.
+	*----------------------------------------
+	*/
+	class PipeDescription final
+	{
+		using this_ref = PipeDescription & ;
+	public:
+		inline auto const& getTag() const { return m_tag; }
+		inline auto getPacketSize() const { return m_packetSize; }
+		inline auto getMaxPackets() const { return m_maxPackets; }
+
+		inline this_ref setTag(std::string const& tag) { m_tag = tag; return *this; }
+		inline this_ref setPacketSize(uint32_t size) { m_packetSize = size; return *this; }
+		inline this_ref setMaxPackets(uint32_t count) { m_maxPackets = count; return *this; }
+
+	protected:
+		std::string m_tag;
+		uint32_t m_packetSize{ 0 }; // bytes, sizeof the record type of the kernels
+		uint32_t m_maxPackets{ 0 };
+	};
+
+
 	/**
 	* @class	Dependency
 	* @brief	Description of the synchronization primitives for dispatch/dataslots.
@@ -139,18 +243,49 @@ namespace graphics_compute
 	* 3. stage/executionnode dependency
 	*----------------------------------------
 	*/
-	class Dependency
-	{};
-	class Synchronization
-	{};
+	class Dependency final
+	{
+		using this_ref = Dependency & ;
+	public:
+		inline auto const& getTag() const { return m_tag; }
+
+		/* tag of the upstream dispatch, this dispatch starts only after the upstream dispatch completes */
+		inline this_ref setTag(std::string const& tag) { m_tag = tag; return *this; }
+
+	protected:
+		std::string m_tag;
+	};
+	using DependencyList = std::vector< Dependency >;
+
+
+	/**
+	* @class	Synchronization
+	* @brief	Host synchronization for a submitted ExecutionGraph.
+	*----------------------------------------
+	* A blocking submission returns after all the dispatches of the graph complete (single host sync).
+	* A non-blocking submission returns immediately, the application calls waitGraph() before
+	* consuming the results.
+	*----------------------------------------
+	*/
+	class Synchronization final
+	{
+		using this_ref = Synchronization & ;
+	public:
+		inline auto getIsHostBlocking() const { return m_hostBlocking; }
+
+		inline this_ref setIsHostBlocking(bool blocking) { m_hostBlocking = blocking; return *this; }
+
+	protected:
+		bool m_hostBlocking{ true };
+	};
 
 
 	/**
 	* @class	DispatchDescription
 	* @brief	Description of a compute kernel dispatch.
 	*--------------------------------------------------------------------------
-	* Currently a single dispatch supports only a single kernel at a time till the complete
-	* implementation of the ExecutionGraph. So to execute multiple kernels we need multiple dispatch calls.
+	* A single dispatch executes a single kernel. Dependencies on other dispatches form the ExecutionGraph,
+	* which could be submitted at once with dispatchGraph(). Independent branches of the graph run concurrently.
 	*--------------------------------------------------------------------------
 	*/
 	class DispatchDescription final
@@ -160,15 +295,53 @@ namespace graphics_compute
 		inline auto const& getTag() const { return m_tag; }
 		inline auto const& getKernelName() const { return m_kernalName; }
 		inline auto const& getKernelNamespace() const { return m_kernalNamespace; }
+		inline auto const& getDependencies() const { return m_dependencies; }
+		inline auto getIsSharded() const { return m_sharded; }
+		inline auto getIsAutotuned() const { return m_autotuned; }
+		inline auto const& getElementwiseFunction() const { return m_elementwiseFunction; }
 
 		inline this_ref setTag(std::string const& tag) { m_tag = tag; return *this; }
 		inline this_ref setKernelName(std::string const& name) { m_kernalName = name; return *this; }
 		inline this_ref setKernelNamespace(std::string const& name) { m_kernalNamespace = name; return *this; }
+		inline this_ref addDependency(Dependency const& dependency) { m_dependencies.push_back(dependency); return *this; }
+
+		/*
+		* Split dispatch() of this kernel across all the devices (see ContextDescription::setIsNumaFission).
+		* The global work is partitioned with work offsets by the measured device throughput, the bound buffers
+		* are scattered to / gathered from the devices per slice. Contract: work item i accesses only unit i
+		* of every bound buffer (elementwise), no images bound. Sharded dispatches block the host, graph
+		* submissions run the kernel unsharded on the primary device.
+		*/
+		inline this_ref setIsSharded(bool sharded) { m_sharded = sharded; return *this; }
+
+		/*
+		* The first dispatch of every problem size bucket (power of two of the global work size) times the
+		* candidate work-group shapes and keeps the fastest in the tuning database, later dispatches reuse it.
+		* Tuning repeats the kernel, so only idempotent kernels (outputs depend on the inputs only) should be autotuned.
+		*/
+		inline this_ref setIsAutotuned(bool autotuned) { m_autotuned = autotuned; return *this; }
+
+		/*
+		* Marks the kernel as a fusable elementwise op: __kernel(__global T* in, __global T* out, params...)
+		* computing out[i] = functionName(in[i], params...) for work item i, with the OpenCL C function
+		* "T functionName(T x, params...)" defined in the sources of the kernel namespace.
+		* Linear chains of these dispatches (each one the only dependency of the next one, same namespace and T)
+		* are built into one fused kernel. A dispatchGraph()/dispatchBatch() opting in (GraphPayload::fuseElementwise, dispatchBatch fuseElementwise)
+		* and submitting the complete chain with the same global work size runs the fused kernel instead.
+		* The fused kernel doesn't write the intermediate buffers of the chain, a chain with an intermediate
+		* buffer bound to any other dispatch runs unfused. The application must not read the intermediates
+		* after a fused submission.
+		*/
+		inline this_ref setElementwiseFunction(std::string const& functionName) { m_elementwiseFunction = functionName; return *this; }
 
 	protected:
 		std::string m_tag;
 		std::string m_kernalName; // __kernel entrypoint
 		std::string m_kernalNamespace;
+		DependencyList m_dependencies;
+		bool m_sharded{ false };
+		bool m_autotuned{ false };
+		std::string m_elementwiseFunction;
 	};
 
 	
@@ -196,18 +369,140 @@ namespace graphics_compute
 	};
 
 
+	/**
+	* @struct	GraphPayload
+	* @brief	Dispatches submitted together as an ExecutionGraph.
+	*--------------------------------------------------------------------------
+	* The order of the dispatches is derived from the DispatchDescription dependencies.
+	* Dependencies on dispatches not part of the payload are ignored.
+	*--------------------------------------------------------------------------
+	*/
+	struct GraphPayload
+	{
+		std::vector< DispatchPayload > dispatches;
+		Synchronization sync;
+		bool fuseElementwise{ false };	/* complete elementwise chains run fused, see DispatchDescription::setElementwiseFunction */
+	};
+
+
+	/**
+	* @class	IEvent
+	* @brief	Waitable completion handle of an asynchronous operation.
+	*/
+	class IEvent
+	{
+	public:
+		virtual ~IEvent()
+		{}
+
+		virtual int wait() = 0;
+		virtual bool isComplete() const = 0;
+	};
+	using EventHandle = std::shared_ptr<IEvent>;
+
+
+	/**
+	* @struct	MappedSpan
+	* @brief	Host view of a mapped resource region, valid till the slot unmap.
+	*/
+	struct MappedSpan
+	{
+		void*	data{ nullptr };
+		size_t	size{ 0 };			/* bytes in the view */
+		size_t	rowPitch{ 0 };		/* images only */
+		size_t	slicePitch{ 0 };	/* 3D images and image arrays only */
+
+		template<typename T>
+		inline T* as() const { return reinterpret_cast<T*>(data); }
+
+		template<typename T>
+		inline size_t count() const { return size / sizeof(T); }
+	};
+
+
+	/**
+	* @struct	TimingPercentiles
+	* @brief	Percentiles (milliseconds) of the recent samples of a timing.
+	*/
+	struct TimingPercentiles
+	{
+		double p50{ 0.0 };
+		double p95{ 0.0 };
+		double p99{ 0.0 };
+		double max{ 0.0 };
+	};
+
+
+	/**
+	* @struct	TimingStats
+	* @brief	Profiled timings of a dispatch tag or a transfer command (e.g. WRITE_BUFFER).
+	*--------------------------------------------------------------------------
+	* The count and total cover all the samples, the percentiles cover a rolling window of the recent samples.
+	*--------------------------------------------------------------------------
+	*/
+	struct TimingStats
+	{
+		std::string			tag;
+		bool				isTransfer{ false };
+		size_t				count{ 0 };
+		double				totalMs{ 0.0 };		/* sum of the execution times */
+		TimingPercentiles	queuedMs;			/* enqueued on the host -> submitted to the device */
+		TimingPercentiles	submitMs;			/* submitted -> started (waiting for dependencies and the device) */
+		TimingPercentiles	executionMs;		/* started -> ended */
+	};
+
+
+	/**
+	* @struct	DeviceInfo
+	* @brief	Properties of the primary device (the device of the dispatches), for sizing the dispatch grids.
+	*/
+	struct DeviceInfo
+	{
+		std::string			name;
+		device::DeviceType	type{ device::DeviceType::eUndefined };
+		uint32_t			computeUnits{ 1 };		/* CL_DEVICE_MAX_COMPUTE_UNITS */
+		uint64_t			maxWorkGroupSize{ 1 };
+	};
+
+
 	/**
 	* @class	IResourceSlot
 	* @brief	Data IO Slot Base.
+	*--------------------------------------------------------------------------
+	* Non-blocking slots return from read/write immediately. The host memory passed to the transfer
+	* must stay valid (and unmodified for writes) till the returned event or waitTransfers() completes.
+	*--------------------------------------------------------------------------
 	*/
 	class IResourceSlot
 	{
 	public:
 		virtual void setIsBlocking(bool isBlocking) = 0; // allows for both synchronous and asychronous update.
+		virtual int waitTransfers() = 0; // block till all the pending transfers of this slot complete.
 	};
 	using ResourceSlotHandle = std::shared_ptr<IResourceSlot>;
 
 
+	/**
+	* @struct	TransferRect
+	* @brief	2D/3D window of a buffer and of the host memory for the rect transfers.
+	*--------------------------------------------------------------------------
+	* Origins and region are (bytes, rows, slices). Pitches are in bytes, 0 - tightly packed
+	* (row pitch = region[0], slice pitch = region[1] * row pitch). A tile of a larger host frame
+	* is the hostOrigin of the tile with the row/slice pitch of the frame.
+	*--------------------------------------------------------------------------
+	*/
+	struct TransferRect
+	{
+		size_t region[3] = { 0, 1, 1 };
+		size_t bufferOrigin[3] = { 0, 0, 0 };
+		size_t hostOrigin[3] = { 0, 0, 0 };
+		size_t bufferRowPitch{ 0 };
+		size_t bufferSlicePitch{ 0 };
+		size_t hostRowPitch{ 0 };
+		size_t hostSlicePitch{ 0 };
+	};
+
+
 	/**
 	* @class	BufferSlot
 	* @brief	IO slot interfaace for the buffer resources.
@@ -215,10 +510,41 @@ namespace graphics_compute
 	class BufferSlot : public IResourceSlot
 	{
 	public:
-		virtual int writeData(const void* srcPtr, size_t dataSize, size_t offset = 0) = 0;
-		virtual int readData(void* dstPtr, size_t dataSize, size_t offset = 0) = 0;
+		virtual int writeData(const void* srcPtr, size_t dataSize, size_t offset = 0, EventHandle* event = nullptr) = 0;
+		virtual int readData(void* dstPtr, size_t dataSize, size_t offset = 0, EventHandle* event = nullptr) = 0;
 		virtual int copyDataTo(const void* srcSlot, size_t dataSize, size_t srcOffset = 0, size_t dstOffset = 0) = 0;
 		virtual int copyDataFrom(void* dstSlot, size_t dataSize, size_t srcOffset = 0, size_t dstOffset = 0) = 0;
+
+		/* strided 2D/3D window transfers, no packing of the host data (hostPtr is the base of the host frame) */
+		virtual int writeRect(const void* hostPtr, TransferRect const& rect, EventHandle* event = nullptr) = 0;
+		virtual int readRect(void* hostPtr, TransferRect const& rect, EventHandle* event = nullptr) = 0;
+
+		/*
+		* Direct host access to the buffer memory, zero-copy for host resident devices and eHostLocal buffers.
+		* map for write discards the region content. The resource can't be used by the pipeline till unmap.
+		*/
+		virtual int mapForWrite(MappedSpan& span, size_t dataSize, size_t offset = 0) = 0;
+		virtual int mapForRead(MappedSpan& span, size_t dataSize, size_t offset = 0) = 0;
+		virtual int unmap(MappedSpan& span) = 0;
+
+		/*
+		* eSharedVirtual buffers hold pointer-rich data (octrees, adjacency graphs) without flattening it every frame.
+		* A link to the byte offset of the buffer is stored as getSharedVirtualRef(offset) (a ulong in the kernel structs)
+		* and followed in the kernel with compute_svm_ptr(T, base, ref), base is the buffer arg. The ref is the device
+		* address with shared virtual memory, else the offset itself (the fallback is a plain buffer of the same layout).
+		*/
+		virtual bool getIsSharedVirtual() const = 0;
+		virtual uint64_t getSharedVirtualRef(size_t offset) const = 0;
+
+		/*
+		* attribute-wise transfers in either BufferLayout, the host side holds unitCount tightly packed values of the
+		* attribute (strided rect transfer for ePackedAoS, contiguous for eSoA).
+		*/
+		virtual int writeAttribute(size_t attributeIdx, const void* srcPtr, size_t unitCount, size_t firstUnit = 0, EventHandle* event = nullptr) = 0;
+		virtual int readAttribute(size_t attributeIdx, void* dstPtr, size_t unitCount, size_t firstUnit = 0, EventHandle* event = nullptr) = 0;
+
+		/* byte offset of the attribute in a unit (ePackedAoS) or of its stream (eSoA), passed to the kernels as an arg */
+		virtual size_t getAttributeOffset(size_t attributeIdx) const = 0;
 	};
 
 	/**
@@ -228,14 +554,48 @@ namespace graphics_compute
 	class ImageSlot : public IResourceSlot
 	{
 	public:
-		virtual int writeData(const void* srcPtr, const size_t region[3], const size_t origin[3] = {0}) = 0;
-		virtual int readData(void* dstPtr, const size_t region[3], const size_t origin[3] = { 0 }) = 0;
+		virtual int writeData(const void* srcPtr, const size_t region[3], const size_t origin[3] = { 0 }, EventHandle* event = nullptr) = 0;
+		virtual int readData(void* dstPtr, const size_t region[3], const size_t origin[3] = { 0 }, EventHandle* event = nullptr) = 0;
 		virtual int copyDataTo(const void* srcSlot, const size_t region[3], const size_t srcOrigin[3] = { 0 }, const size_t dstOrigin[3] = { 0 }) = 0;
 		virtual int copyDataFrom(void* dstSlot, const size_t region[3], const size_t srcOrigin[3] = { 0 }, const size_t dstOrigin[3] = { 0 }) = 0;
+
+		/*
+		* host rows/slices hostRowPitch/hostSlicePitch bytes apart (0 - tightly packed), so a tile is transferred
+		* straight from/to a larger (padded) host frame, hostPtr points at the first pixel of the tile.
+		*/
+		virtual int writeDataPitched(const void* hostPtr, const size_t region[3], const size_t origin[3], size_t hostRowPitch, size_t hostSlicePitch = 0, EventHandle* event = nullptr) = 0;
+		virtual int readDataPitched(void* hostPtr, const size_t region[3], const size_t origin[3], size_t hostRowPitch, size_t hostSlicePitch = 0, EventHandle* event = nullptr) = 0;
+
+		/* see BufferSlot, rows of the view are span.rowPitch bytes apart */
+		virtual int mapForWrite(MappedSpan& span, const size_t region[3], const size_t origin[3] = { 0 }) = 0;
+		virtual int mapForRead(MappedSpan& span, const size_t region[3], const size_t origin[3] = { 0 }) = 0;
+		virtual int unmap(MappedSpan& span) = 0;
 	};
 
 
 
+	/**
+	* @struct	SlotId
+	* @brief	Interned (pre-resolved) tag/name of a slot.
+	*--------------------------------------------------------------------------
+	* Resolve the tags once at setup (DataIO::resolveBuffer, KernelIO::resolveArg, etc.) and use the ids
+	* on the hot path, an id indexes the slot arrays directly instead of hashing the tag on every access.
+	* Ids stay valid for the lifetime of the pipeline, accessing a slot with an invalid id is undefined.
+	*--------------------------------------------------------------------------
+	*/
+	template<typename SlotT>
+	struct SlotId
+	{
+		static constexpr uint32_t INVALID = 0xFFFFFFFF;
+
+		uint32_t index{ INVALID };
+
+		inline bool isValid() const { return index != INVALID; }
+	};
+	using BufferId = SlotId<BufferSlot>;
+	using ImageId = SlotId<ImageSlot>;
+
+
 	/**
 	* @class	IDataIO
 	* @brief	Interface to all data io slots.
@@ -245,6 +605,13 @@ namespace graphics_compute
 	public:
 		virtual BufferSlot* getBufferSlot(std::string const& tag) const = 0;
 		virtual ImageSlot* getImageSlot(std::string const& tag) const = 0;
+
+		/* invalid id for an unknown tag */
+		virtual BufferId resolveBuffer(std::string const& tag) const = 0;
+		virtual ImageId resolveImage(std::string const& tag) const = 0;
+
+		virtual BufferSlot* getBufferSlot(BufferId bufferId) const = 0;
+		virtual ImageSlot* getImageSlot(ImageId imageId) const = 0;
 	};
 	using DataSlotHandle = std::unique_ptr<IDataSlot>;
 
@@ -289,6 +656,26 @@ namespace graphics_compute
 			return m_dataIOslot->getImageSlot(tag);
 		}
 
+		inline BufferId resolveBuffer(std::string const& tag) const
+		{
+			return m_dataIOslot->resolveBuffer(tag);
+		}
+
+		inline ImageId resolveImage(std::string const& tag) const
+		{
+			return m_dataIOslot->resolveImage(tag);
+		}
+
+		inline BufferSlot* getSlot(BufferId bufferId)
+		{
+			return m_dataIOslot->getBufferSlot(bufferId);
+		}
+
+		inline ImageSlot* getSlot(ImageId imageId)
+		{
+			return m_dataIOslot->getImageSlot(imageId);
+		}
+
 	protected:
 		DataSlotHandle m_dataIOslot;
 	};
@@ -297,11 +684,20 @@ namespace graphics_compute
 
 
 
+	/* non-owning view of the arg value, the value is copied by the backend before argSet returns */
 	struct ArgPayload
 	{
-		std::shared_ptr<void> data;
-		size_t size;
-		// std::type_info typeinfo;
+		const void* data{ nullptr };
+		size_t size{ 0 };
+	};
+
+
+	/* kind of a kernel arg, checked against the __kernel signature (see TypedKernel) */
+	enum class ArgKind : uint32_t
+	{
+		eValue = 0x0,		/* __private scalar/vector/struct */
+		eBuffer = 0x1,		/* __global or __constant pointer */
+		eImage = 0x2		/* image*_t */
 	};
 
 	/**
@@ -314,8 +710,12 @@ namespace graphics_compute
 		virtual int argSet(ArgPayload const& payload) = 0;
 		virtual int argBindBuffer(std::string const& bufferTag) = 0;
 		virtual int argBindImage(std::string const& imageTag) = 0;
+		virtual int argBindBuffer(BufferId bufferId) = 0;
+		virtual int argBindImage(ImageId imageId) = 0;
+		virtual int argBindPipe(std::string const& pipeTag) = 0;
 	};
 	using ArgSlotHandle = std::unique_ptr<IArgSlot>;
+	using ArgId = SlotId<IArgSlot>;
 
 	/**
 	* @class	ArgIO
@@ -337,7 +737,7 @@ namespace graphics_compute
 		inline int argSet(ArgT const& arg)
 		{
 			ArgPayload _payload;
-			_payload.data = std::make_shared<ArgT>(arg);
+			_payload.data = &arg;
 			_payload.size = sizeof(arg);
 			return m_argslot->argSet(_payload);
 		}
@@ -352,6 +752,21 @@ namespace graphics_compute
 			return m_argslot->argBindImage(std::move(imageTag));
 		}
 
+		inline int argBindBuffer(BufferId bufferId)
+		{
+			return m_argslot->argBindBuffer(bufferId);
+		}
+
+		inline int argBindImage(ImageId imageId)
+		{
+			return m_argslot->argBindImage(imageId);
+		}
+
+		inline int argBindPipe(std::string const& pipeTag)
+		{
+			return m_argslot->argBindPipe(pipeTag);
+		}
+
 	protected:
 		ArgSlotHandle m_argslot;
 	};
@@ -363,6 +778,15 @@ namespace graphics_compute
 	public:
 		virtual ArgIO* getArgSlot(size_t argIdx) const = 0;
 		virtual ArgIO* getArgSlot(std::string const& argName) const = 0;
+		virtual ArgIO* getArgSlot(ArgId argId) const = 0;
+
+		/* invalid id for an unknown arg name */
+		virtual ArgId resolveArg(std::string const& argName) const = 0;
+
+		virtual size_t getArgCount() const = 0;
+
+		/* checks the kind (and the size of value args) against the __kernel signature, non-zero on mismatch */
+		virtual int checkArg(size_t argIdx, ArgKind kind, size_t valueSize) const = 0;
 	};
 
 	using KernelSlotHandle = std::unique_ptr<IKernelSlot>;
@@ -417,12 +841,135 @@ namespace graphics_compute
 			m_kernelSlot->getArgSlot(argName)->argBindImage(imageTag);
 		}
 
+		/* argName should be exactly same as in the _kernel source */
+		inline ArgId resolveArg(std::string const& argName) const
+		{
+			return m_kernelSlot->resolveArg(argName);
+		}
+
+		template<typename ArgT>
+		inline void argSet(ArgId argId, ArgT const& arg)
+		{
+			m_kernelSlot->getArgSlot(argId)->argSet<ArgT>(arg);
+		}
+
+		inline void argBindBuffer(ArgId argId, BufferId bufferId)
+		{
+			m_kernelSlot->getArgSlot(argId)->argBindBuffer(bufferId);
+		}
+
+		inline void argBindImage(ArgId argId, ImageId imageId)
+		{
+			m_kernelSlot->getArgSlot(argId)->argBindImage(imageId);
+		}
+
 	protected:
 		KernelSlotHandle m_kernelSlot;
 	};
 	using KernelIOHandle = std::shared_ptr<KernelIO>;
 
 
+	/* kernel arg kind of a TypedKernel parameter */
+	template<typename ArgT>
+	struct arg_trait { static constexpr ArgKind kind = ArgKind::eValue; static constexpr size_t size = sizeof(ArgT); };
+	template<>
+	struct arg_trait<BufferId> { static constexpr ArgKind kind = ArgKind::eBuffer; static constexpr size_t size = 0; };
+	template<>
+	struct arg_trait<ImageId> { static constexpr ArgKind kind = ArgKind::eImage; static constexpr size_t size = 0; };
+
+
+	/**
+	* @class	TypedKernel
+	* @brief	Compile-time signature of a KernelIO, e.g. TypedKernel< float, BufferId, int >.
+	*--------------------------------------------------------------------------
+	* init() checks the arg count and the kind/size of every arg against the __kernel signature once,
+	* set() then sets all the args by their index from the parameter pack without any lookup or heap allocation.
+	* Buffers and images are passed as the interned ids (DataIO::resolveBuffer/resolveImage).
+	*--------------------------------------------------------------------------
+	*/
+	template<typename... ArgTs>
+	class TypedKernel final
+	{
+	public:
+		TypedKernel()
+		{}
+
+		/* error code, any non-zero value specifies a signature mismatch (the kernel stays unbound) */
+		inline int init(KernelIO* kernelIO)
+		{
+			m_kernelIO = nullptr;
+			if (!kernelIO || kernelIO->getImpl()->getArgCount() != sizeof...(ArgTs))
+				return -1;
+
+			int result = pCheckArgs(kernelIO->getImpl(), std::index_sequence_for<ArgTs...>{});
+			if (!result)
+				m_kernelIO = kernelIO;
+
+			return result;
+		}
+
+		inline bool isValid() const
+		{
+			return m_kernelIO != nullptr;
+		}
+
+		/* error code, non-zero if the kernel is unbound (init failed or wasn't called) */
+		inline int set(ArgTs const&... args)
+		{
+			if (!isValid())
+				return -1;
+
+			pSetArgs(std::index_sequence_for<ArgTs...>{}, args...);
+			return 0;
+		}
+
+	protected:
+		template<size_t... Is>
+		inline int pCheckArgs(IKernelSlot* kernelSlot, std::index_sequence<Is...>)
+		{
+			int results[] = { 0, kernelSlot->checkArg(Is, arg_trait<ArgTs>::kind, arg_trait<ArgTs>::size)... };
+			for (int result : results)
+			{
+				if (result)
+					return result;
+			}
+			return 0;
+		}
+
+		template<size_t... Is>
+		inline void pSetArgs(std::index_sequence<Is...>, ArgTs const&... args)
+		{
+			int expand[] = { 0, (pSetArg(static_cast<uint32_t>(Is), args), 0)... };
+			(void)expand;
+		}
+
+		template<typename ArgT>
+		inline void pSetArg(uint32_t argIdx, ArgT const& arg)
+		{
+			ArgId argId;
+			argId.index = argIdx;
+			m_kernelIO->argSet<ArgT>(argId, arg);
+		}
+
+		inline void pSetArg(uint32_t argIdx, BufferId const& bufferId)
+		{
+			ArgId argId;
+			argId.index = argIdx;
+			m_kernelIO->argBindBuffer(argId, bufferId);
+		}
+
+		inline void pSetArg(uint32_t argIdx, ImageId const& imageId)
+		{
+			ArgId argId;
+			argId.index = argIdx;
+			m_kernelIO->argBindImage(argId, imageId);
+		}
+
+	protected:
+		KernelIO* m_kernelIO{ nullptr };
+	};
+
+
 
 	class IDispatchSlot
 	{
@@ -473,12 +1020,23 @@ namespace graphics_compute
 		
 		virtual std::vector< BufferDescription > const& getBufferDescriptions() = 0;
 		virtual std::vector< ImageDescription > const& getImageDescriptions() = 0;
+		virtual std::vector< PipeDescription > const& getPipeDescriptions() = 0;
 		virtual std::vector< DispatchDescription > const& getDispatchDescriptions() = 0;
 
 		virtual void initDataIO(DataIOHandle const&& dataio) = 0;
 		virtual void initDispatchIO(DispatchIOHandle const&& dataio) = 0;
 
 		virtual int dispatch(DispatchPayload const& payload) = 0;
+		virtual int dispatchGraph(GraphPayload const& payload) = 0;
+		virtual int waitGraph() = 0;
+
+		/* runtime changes of the initialized pipeline (see IComputeManager::addBuffer) */
+		virtual int addBuffer(BufferDescription const& bufDesc) = 0;
+		virtual int removeBuffer(std::string const& tag) = 0;
+		virtual int addImage(ImageDescription const& imgDesc) = 0;
+		virtual int removeImage(std::string const& tag) = 0;
+		virtual int addDispatch(DispatchDescription const& dispatchDesc) = 0;
+		virtual int removeDispatch(std::string const& tag) = 0;
 
 		/* The application will provide the concrete implementation */
 		virtual int setupAppComputePipeline() = 0;
@@ -536,6 +1094,11 @@ namespace graphics_compute
 			return m_imageDescriptions;
 		}
 
+		virtual std::vector< PipeDescription > const& getPipeDescriptions() override final
+		{
+			return m_pipeDescriptions;
+		}
+
 		virtual std::vector< DispatchDescription > const& getDispatchDescriptions() override final
 		{
 			return m_dispatchDescriptions;
@@ -556,17 +1119,85 @@ namespace graphics_compute
 			return m_computeManager->dispatch(payload);
 		}
 
+		virtual int dispatchGraph(GraphPayload const& payload) override final
+		{
+			return m_computeManager->dispatchGraph(payload);
+		}
+
+		virtual int waitGraph() override final
+		{
+			return m_computeManager->waitGraph();
+		}
+
+		virtual int addBuffer(BufferDescription const& bufDesc) override final
+		{
+			int result = m_computeManager->addBuffer(bufDesc);
+			if (!result)
+				m_bufferDescriptions.push_back(bufDesc);
+			return result;
+		}
+
+		virtual int removeBuffer(std::string const& tag) override final
+		{
+			int result = m_computeManager->removeBuffer(tag);
+			if (!result)
+				pEraseDescription(m_bufferDescriptions, tag);
+			return result;
+		}
+
+		virtual int addImage(ImageDescription const& imgDesc) override final
+		{
+			int result = m_computeManager->addImage(imgDesc);
+			if (!result)
+				m_imageDescriptions.push_back(imgDesc);
+			return result;
+		}
+
+		virtual int removeImage(std::string const& tag) override final
+		{
+			int result = m_computeManager->removeImage(tag);
+			if (!result)
+				pEraseDescription(m_imageDescriptions, tag);
+			return result;
+		}
+
+		/* the description is added first, so dispatches described earlier can depend on it */
+		virtual int addDispatch(DispatchDescription const& dispatchDesc) override final
+		{
+			m_dispatchDescriptions.push_back(dispatchDesc);
+			int result = m_computeManager->addDispatch(dispatchDesc);
+			if (result)
+				m_dispatchDescriptions.pop_back();
+			return result;
+		}
+
+		virtual int removeDispatch(std::string const& tag) override final
+		{
+			int result = m_computeManager->removeDispatch(tag);
+			if (!result)
+				pEraseDescription(m_dispatchDescriptions, tag);
+			return result;
+		}
+
 		/* The application will provide the concrete implementation */
 		virtual int setupAppComputePipeline() = 0;
 
+	protected:
+		template<typename DescT>
+		static inline void pEraseDescription(std::vector< DescT >& descriptions, std::string const& tag)
+		{
+			descriptions.erase(std::remove_if(descriptions.begin(), descriptions.end(), [&tag](DescT const& desc) { return desc.getTag() == tag; }), descriptions.end());
+		}
+
 	protected:
 		app_manager * m_appManager;
 		compute_manager * m_computeManager;
 
 		/* These descriptions are retained after initialization so that pipeline could be re-initialized if required */
-		/* #improvement - provide a layer to add and delete during runtime (just need to add two fuctions) */
+		/* add/remove during runtime keep them in sync (addBuffer, removeBuffer, etc.) */
 		std::vector< BufferDescription > m_bufferDescriptions;
 		std::vector< ImageDescription > m_imageDescriptions;
+		std::vector< PipeDescription > m_pipeDescriptions;
 		std::vector< DispatchDescription > m_dispatchDescriptions;
 
 	private:
@@ -45,7 +45,8 @@ namespace device
 	{
 		eGeneral = 0x0,
 		eBuffer = 0x1,
-		eImage = 0x2
+		eImage = 0x2,
+		ePipe = 0x3
 	};
 
 
@@ -10,6 +10,8 @@
 */
 
 
+#include "oclEvent.h"
+#include "oclResources.h"
 #include "oclDataIO.h"
 #include "oclManager.h"
 #include "oclExecutionManager.h"
@@ -22,23 +24,94 @@ namespace opencl
 	bool ResourceIO::s_globalLOCK = true;
 
 
+	/*
+	*************************************
+	* ResourceIO
+	*************************************
+	*/
+	void ResourceIO::pSetPendingTransfer(cl::Event const& clEvent, compute::EventHandle* event)
+	{
+		p_pendingTransfer = clEvent;
+
+		if (event)
+		{
+			*event = std::make_shared<SyncEvent>(clEvent);
+		}
+	}
+
+	int ResourceIO::pWaitTransfers()
+	{
+		cl_int clResult = CL_SUCCESS;
+
+		if (p_pendingTransfer())
+		{
+			clResult = p_pendingTransfer.wait();
+			p_pendingTransfer = cl::Event();
+		}
+
+		return clResult;
+	}
+
+
 	/*
 	*************************************
 	* BufferIO (BufferSlots)
 	*************************************
 	*/
-	int BufferIO::writeData(const void* srcPtr, size_t dataSize, size_t offset)
+	int BufferIO::writeData(const void* srcPtr, size_t dataSize, size_t offset, compute::EventHandle* event)
+	{
+		Buffer* buffer = getMgr()->getExecManager()->getBuffer(p_KEY);
+
+		cl::Event clEvent;
+		cl_int clResult = getMgr()->getResourceManager()->writeBuffer(buffer, srcPtr, dataSize, offset, p_BLOCKING, &clEvent);
+		if (clResult == CL_SUCCESS)
+		{
+			pSetPendingTransfer(clEvent, event);
+		}
+
+		return clResult;
+	}
+
+	int BufferIO::readData(void* dstPtr, size_t dataSize, size_t offset, compute::EventHandle* event)
+	{
+		Buffer* buffer = getMgr()->getExecManager()->getBuffer(p_KEY);
+
+		cl::Event clEvent;
+		cl_int clResult = getMgr()->getResourceManager()->readBuffer(buffer, dstPtr, dataSize, offset, p_BLOCKING, &clEvent);
+		if (clResult == CL_SUCCESS)
+		{
+			pSetPendingTransfer(clEvent, event);
+		}
+
+		return clResult;
+	}
+
+	int BufferIO::writeRect(const void* hostPtr, compute::TransferRect const& rect, compute::EventHandle* event)
 	{
 		Buffer* buffer = getMgr()->getExecManager()->getBuffer(p_KEY);
 
-		return getMgr()->getResourceManager()->writeBuffer(buffer, srcPtr, dataSize, offset);
+		cl::Event clEvent;
+		cl_int clResult = getMgr()->getResourceManager()->writeBufferRect(buffer, hostPtr, rect, p_BLOCKING, &clEvent);
+		if (clResult == CL_SUCCESS)
+		{
+			pSetPendingTransfer(clEvent, event);
+		}
+
+		return clResult;
 	}
 
-	int BufferIO::readData(void* dstPtr, size_t dataSize, size_t offset)
+	int BufferIO::readRect(void* hostPtr, compute::TransferRect const& rect, compute::EventHandle* event)
 	{
 		Buffer* buffer = getMgr()->getExecManager()->getBuffer(p_KEY);
 
-		return getMgr()->getResourceManager()->readBuffer(buffer, dstPtr, dataSize, offset);
+		cl::Event clEvent;
+		cl_int clResult = getMgr()->getResourceManager()->readBufferRect(buffer, hostPtr, rect, p_BLOCKING, &clEvent);
+		if (clResult == CL_SUCCESS)
+		{
+			pSetPendingTransfer(clEvent, event);
+		}
+
+		return clResult;
 	}
 
 	int BufferIO::copyDataTo(const void* srcSlot, size_t dataSize, size_t srcOffset, size_t dstOffset)
@@ -57,24 +130,153 @@ namespace opencl
 		return getMgr()->getResourceManager()->copyBuffer(srcBuffer, dstBuffer, dataSize, srcOffset, dstOffset);
 	}
 
+	int BufferIO::mapForWrite(compute::MappedSpan& span, size_t dataSize, size_t offset)
+	{
+		return pMap(CL_MAP_WRITE_INVALIDATE_REGION, span, dataSize, offset);
+	}
+
+	int BufferIO::mapForRead(compute::MappedSpan& span, size_t dataSize, size_t offset)
+	{
+		return pMap(CL_MAP_READ, span, dataSize, offset);
+	}
+
+	int BufferIO::unmap(compute::MappedSpan& span)
+	{
+		Buffer* buffer = getMgr()->getExecManager()->getBuffer(p_KEY);
+
+		cl_int clResult = getMgr()->getResourceManager()->unmapBuffer(buffer, span.data);
+		if (clResult == CL_SUCCESS)
+		{
+			pSetPendingTransfer(buffer->getSyncEvent(), nullptr);
+			span = compute::MappedSpan();
+		}
+
+		return clResult;
+	}
+
+	bool BufferIO::getIsSharedVirtual() const
+	{
+		return getMgr()->getExecManager()->getBuffer(p_KEY)->getIsSharedVirtual();
+	}
+
+	uint64_t BufferIO::getSharedVirtualRef(size_t offset) const
+	{
+		Buffer* buffer = getMgr()->getExecManager()->getBuffer(p_KEY);
+		if (void* svmPtr = buffer->getSVMPointer())
+			return reinterpret_cast<uint64_t>(static_cast<unsigned char*>(svmPtr) + offset);
+
+		return offset;
+	}
+
+	int BufferIO::writeAttribute(size_t attributeIdx, const void* srcPtr, size_t unitCount, size_t firstUnit, compute::EventHandle* event)
+	{
+		Buffer* buffer = getMgr()->getExecManager()->getBuffer(p_KEY);
+
+		cl::Event clEvent;
+		cl_int clResult = getMgr()->getResourceManager()->writeBufferAttribute(buffer, attributeIdx, srcPtr, unitCount, firstUnit, p_BLOCKING, &clEvent);
+		if (clResult == CL_SUCCESS)
+		{
+			pSetPendingTransfer(clEvent, event);
+		}
+
+		return clResult;
+	}
+
+	int BufferIO::readAttribute(size_t attributeIdx, void* dstPtr, size_t unitCount, size_t firstUnit, compute::EventHandle* event)
+	{
+		Buffer* buffer = getMgr()->getExecManager()->getBuffer(p_KEY);
+
+		cl::Event clEvent;
+		cl_int clResult = getMgr()->getResourceManager()->readBufferAttribute(buffer, attributeIdx, dstPtr, unitCount, firstUnit, p_BLOCKING, &clEvent);
+		if (clResult == CL_SUCCESS)
+		{
+			pSetPendingTransfer(clEvent, event);
+		}
+
+		return clResult;
+	}
+
+	size_t BufferIO::getAttributeOffset(size_t attributeIdx) const
+	{
+		Buffer* buffer = getMgr()->getExecManager()->getBuffer(p_KEY);
+		return buffer->getDataLayout().getAttributeOffset(attributeIdx, buffer->getMaxUnitCount());
+	}
+
+	int BufferIO::pMap(cl_map_flags flags, compute::MappedSpan& span, size_t dataSize, size_t offset)
+	{
+		Buffer* buffer = getMgr()->getExecManager()->getBuffer(p_KEY);
+
+		void* mappedPtr = nullptr;
+		cl_int clResult = getMgr()->getResourceManager()->mapBuffer(buffer, flags, dataSize, offset, mappedPtr);
+		if (clResult == CL_SUCCESS)
+		{
+			span.data = mappedPtr;
+			span.size = dataSize;
+		}
+
+		return clResult;
+	}
+
 
 	/*
 	*************************************
 	* ImageIO (ImageSlots)
 	*************************************
 	*/
-	int ImageIO::writeData(const void* srcPtr, const size_t region[3], const size_t origin[3])
+	int ImageIO::writeData(const void* srcPtr, const size_t region[3], const size_t origin[3], compute::EventHandle* event)
+	{
+		Image* img = getMgr()->getExecManager()->getImage(p_KEY);
+
+		cl::Event clEvent;
+		cl_int clResult = getMgr()->getResourceManager()->writeImage(img, srcPtr, region, origin, 0, 0, p_BLOCKING, &clEvent);
+		if (clResult == CL_SUCCESS)
+		{
+			pSetPendingTransfer(clEvent, event);
+		}
+
+		return clResult;
+	}
+
+	int ImageIO::readData(void* dstPtr, const size_t region[3], const size_t origin[3], compute::EventHandle* event)
+	{
+		Image* img = getMgr()->getExecManager()->getImage(p_KEY);
+
+		cl::Event clEvent;
+		cl_int clResult = getMgr()->getResourceManager()->readImage(img, dstPtr, region, origin, 0, 0, p_BLOCKING, &clEvent);
+		if (clResult == CL_SUCCESS)
+		{
+			pSetPendingTransfer(clEvent, event);
+		}
+
+		return clResult;
+	}
+
+	int ImageIO::writeDataPitched(const void* hostPtr, const size_t region[3], const size_t origin[3], size_t hostRowPitch, size_t hostSlicePitch, compute::EventHandle* event)
 	{
 		Image* img = getMgr()->getExecManager()->getImage(p_KEY);
 
-		return getMgr()->getResourceManager()->writeImage(img, srcPtr, region, origin);
+		cl::Event clEvent;
+		cl_int clResult = getMgr()->getResourceManager()->writeImage(img, hostPtr, region, origin, hostRowPitch, hostSlicePitch, p_BLOCKING, &clEvent);
+		if (clResult == CL_SUCCESS)
+		{
+			pSetPendingTransfer(clEvent, event);
+		}
+
+		return clResult;
 	}
 
-	int ImageIO::readData(void* dstPtr, const size_t region[3], const size_t origin[3])
+	int ImageIO::readDataPitched(void* hostPtr, const size_t region[3], const size_t origin[3], size_t hostRowPitch, size_t hostSlicePitch, compute::EventHandle* event)
 	{
 		Image* img = getMgr()->getExecManager()->getImage(p_KEY);
 
-		return getMgr()->getResourceManager()->writeImage(img, dstPtr, region, origin);
+		cl::Event clEvent;
+		cl_int clResult = getMgr()->getResourceManager()->readImage(img, hostPtr, region, origin, hostRowPitch, hostSlicePitch, p_BLOCKING, &clEvent);
+		if (clResult == CL_SUCCESS)
+		{
+			pSetPendingTransfer(clEvent, event);
+		}
+
+		return clResult;
 	}
 
 	int ImageIO::copyDataTo(const void* srcSlot, const size_t region[3], const size_t srcOrigin[3], const size_t dstOrigin[3])
@@ -87,10 +289,56 @@ namespace opencl
 
 	int ImageIO::copyDataFrom(void* dstSlot, const size_t region[3], const size_t srcOrigin[3], const size_t dstOrigin[3])
 	{
-		Image* srcImg = getMgr()->getExecManager()->getImage(reinterpret_cast< ImageIO* >(dstSlot)->getKEY());
-		Image* dstImg = getMgr()->getExecManager()->getImage(p_KEY);
+		Image* dstImg = getMgr()->getExecManager()->getImage(reinterpret_cast< ImageIO* >(dstSlot)->getKEY());
+		Image* srcImg = getMgr()->getExecManager()->getImage(p_KEY);
 
 		return getMgr()->getResourceManager()->copyImage(srcImg, dstImg, region, srcOrigin, dstOrigin);
 	}
 
+	int ImageIO::mapForWrite(compute::MappedSpan& span, const size_t region[3], const size_t origin[3])
+	{
+		return pMap(CL_MAP_WRITE_INVALIDATE_REGION, span, region, origin);
+	}
+
+	int ImageIO::mapForRead(compute::MappedSpan& span, const size_t region[3], const size_t origin[3])
+	{
+		return pMap(CL_MAP_READ, span, region, origin);
+	}
+
+	int ImageIO::unmap(compute::MappedSpan& span)
+	{
+		Image* img = getMgr()->getExecManager()->getImage(p_KEY);
+
+		cl_int clResult = getMgr()->getResourceManager()->unmapImage(img, span.data);
+		if (clResult == CL_SUCCESS)
+		{
+			pSetPendingTransfer(img->getSyncEvent(), nullptr);
+			span = compute::MappedSpan();
+		}
+
+		return clResult;
+	}
+
+	int ImageIO::pMap(cl_map_flags flags, compute::MappedSpan& span, const size_t region[3], const size_t origin[3])
+	{
+		Image* img = getMgr()->getExecManager()->getImage(p_KEY);
+
+		void* mappedPtr = nullptr;
+		size_t rowPitch = 0;
+		size_t slicePitch = 0;
+		cl_int clResult = getMgr()->getResourceManager()->mapImage(img, flags, region, origin, mappedPtr, rowPitch, slicePitch);
+		if (clResult == CL_SUCCESS)
+		{
+			span.data = mappedPtr;
+			span.rowPitch = rowPitch;
+			span.slicePitch = slicePitch;
+
+			// the slices of a 1D image array are its images, counted by region[1] (region[2] is 1)
+			size_t sliceCount = img->getResource()->getInfo<CL_MEM_TYPE>() == CL_MEM_OBJECT_IMAGE1D_ARRAY ? region[1] : region[2];
+			span.size = slicePitch ? slicePitch * sliceCount : rowPitch * region[1];
+		}
+
+		return clResult;
+	}
+
 } // end namespace opencl
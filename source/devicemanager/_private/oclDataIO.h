@@ -49,8 +49,14 @@ namespace opencl
 			p_BLOCKING = isBlocking;
 		}
 
+		/* transfers of a slot go through the in-order transfer queue, so the last event completes after all the previous ones */
+		void pSetPendingTransfer(cl::Event const& clEvent, compute::EventHandle* event);
+
+		int pWaitTransfers();
+
 		size_t p_KEY;
 		bool p_BLOCKING{ true };
+		cl::Event p_pendingTransfer;
 
 	private:
 		static Manager* s_MGR;
@@ -75,10 +81,32 @@ namespace opencl
 			pSetIsBlocking(isBlocking);
 		}
 
-		virtual int writeData(const void* srcPtr, size_t dataSize, size_t offset = 0) override;
-		virtual int readData(void* dstPtr, size_t dataSize, size_t offset = 0) override;
+		virtual int waitTransfers() override
+		{
+			return pWaitTransfers();
+		}
+
+		virtual int writeData(const void* srcPtr, size_t dataSize, size_t offset = 0, compute::EventHandle* event = nullptr) override;
+		virtual int readData(void* dstPtr, size_t dataSize, size_t offset = 0, compute::EventHandle* event = nullptr) override;
 		virtual int copyDataTo(const void* srcSlot, size_t dataSize, size_t srcOffset = 0, size_t dstOffset = 0) override;
 		virtual int copyDataFrom(void* dstSlot, size_t dataSize, size_t srcOffset = 0, size_t dstOffset = 0) override;
+
+		virtual int writeRect(const void* hostPtr, compute::TransferRect const& rect, compute::EventHandle* event = nullptr) override;
+		virtual int readRect(void* hostPtr, compute::TransferRect const& rect, compute::EventHandle* event = nullptr) override;
+
+		virtual int mapForWrite(compute::MappedSpan& span, size_t dataSize, size_t offset = 0) override;
+		virtual int mapForRead(compute::MappedSpan& span, size_t dataSize, size_t offset = 0) override;
+		virtual int unmap(compute::MappedSpan& span) override;
+
+		virtual bool getIsSharedVirtual() const override;
+		virtual uint64_t getSharedVirtualRef(size_t offset) const override;
+
+		virtual int writeAttribute(size_t attributeIdx, const void* srcPtr, size_t unitCount, size_t firstUnit = 0, compute::EventHandle* event = nullptr) override;
+		virtual int readAttribute(size_t attributeIdx, void* dstPtr, size_t unitCount, size_t firstUnit = 0, compute::EventHandle* event = nullptr) override;
+		virtual size_t getAttributeOffset(size_t attributeIdx) const override;
+
+	protected:
+		int pMap(cl_map_flags flags, compute::MappedSpan& span, size_t dataSize, size_t offset);
 	};
 
 	using BufferIOHandle = std::shared_ptr<BufferIO>;
@@ -101,10 +129,25 @@ namespace opencl
 			pSetIsBlocking(isBlocking);
 		}
 
-		virtual int writeData(const void* srcPtr, const size_t region[3], const size_t origin[3] = { 0 }) override;
-		virtual int readData(void* dstPtr, const size_t region[3], const size_t origin[3] = { 0 }) override;
+		virtual int waitTransfers() override
+		{
+			return pWaitTransfers();
+		}
+
+		virtual int writeData(const void* srcPtr, const size_t region[3], const size_t origin[3] = { 0 }, compute::EventHandle* event = nullptr) override;
+		virtual int readData(void* dstPtr, const size_t region[3], const size_t origin[3] = { 0 }, compute::EventHandle* event = nullptr) override;
 		virtual int copyDataTo(const void* srcSlot, const size_t region[3], const size_t srcOrigin[3] = { 0 }, const size_t dstOrigin[3] = { 0 }) override;
 		virtual int copyDataFrom(void* dstSlot, const size_t region[3], const size_t srcOrigin[3] = { 0 }, const size_t dstOrigin[3] = { 0 }) override;
+
+		virtual int writeDataPitched(const void* hostPtr, const size_t region[3], const size_t origin[3], size_t hostRowPitch, size_t hostSlicePitch = 0, compute::EventHandle* event = nullptr) override;
+		virtual int readDataPitched(void* hostPtr, const size_t region[3], const size_t origin[3], size_t hostRowPitch, size_t hostSlicePitch = 0, compute::EventHandle* event = nullptr) override;
+
+		virtual int mapForWrite(compute::MappedSpan& span, const size_t region[3], const size_t origin[3] = { 0 }) override;
+		virtual int mapForRead(compute::MappedSpan& span, const size_t region[3], const size_t origin[3] = { 0 }) override;
+		virtual int unmap(compute::MappedSpan& span) override;
+
+	protected:
+		int pMap(cl_map_flags flags, compute::MappedSpan& span, const size_t region[3], const size_t origin[3]);
 	};
 
 	using ImageIOHandle = std::shared_ptr<ImageIO>;
@@ -119,35 +162,114 @@ namespace opencl
 		virtual compute::BufferSlot* getBufferSlot(std::string const& tag) const override
 		{
 			size_t slotKEY = GET_RESOURCEKEY<device::ResourceType::eBuffer>(tag);
-			return p_bufferResourceSlots.at(slotKEY).get();
+			return p_bufferResourceSlots.at(p_bufferSlotIds.at(slotKEY)).get();
 		}
 
 		virtual compute::ImageSlot* getImageSlot(std::string const& tag) const override
 		{
 			size_t slotKEY = GET_RESOURCEKEY<device::ResourceType::eImage>(tag);
-			return p_imageResourceSlots.at(slotKEY).get();
+			return p_imageResourceSlots.at(p_imageSlotIds.at(slotKEY)).get();
+		}
+
+		virtual compute::BufferId resolveBuffer(std::string const& tag) const override
+		{
+			compute::BufferId bufferId;
+			auto pId = p_bufferSlotIds.find(GET_RESOURCEKEY<device::ResourceType::eBuffer>(tag));
+			if (pId != p_bufferSlotIds.end())
+				bufferId.index = pId->second;
+			return bufferId;
+		}
+
+		virtual compute::ImageId resolveImage(std::string const& tag) const override
+		{
+			compute::ImageId imageId;
+			auto pId = p_imageSlotIds.find(GET_RESOURCEKEY<device::ResourceType::eImage>(tag));
+			if (pId != p_imageSlotIds.end())
+				imageId.index = pId->second;
+			return imageId;
 		}
 
+		virtual compute::BufferSlot* getBufferSlot(compute::BufferId bufferId) const override
+		{
+			assert(bufferId.index < p_bufferResourceSlots.size());
+			return p_bufferResourceSlots[bufferId.index].get();
+		}
+
+		virtual compute::ImageSlot* getImageSlot(compute::ImageId imageId) const override
+		{
+			assert(imageId.index < p_imageResourceSlots.size());
+			return p_imageResourceSlots[imageId.index].get();
+		}
+
+		/* returns the interned id of the slot, a slot added again with the same key keeps its id */
 		template<device::ResourceType RsrcT>
-		void addSlot(size_t slotKEY, std::shared_ptr<void> handle);
+		uint32_t addSlot(size_t slotKEY, std::shared_ptr<void> handle);
 
 		template<>
-		void addSlot<device::ResourceType::eBuffer>(size_t slotKEY, std::shared_ptr<void> handle)
+		uint32_t addSlot<device::ResourceType::eBuffer>(size_t slotKEY, std::shared_ptr<void> handle)
 		{
-			p_bufferResourceSlots[slotKEY].reset(reinterpret_cast<BufferIO*>(handle.get()));
-			handle.reset();
+			return pAddSlot(p_bufferSlotIds, p_bufferResourceSlots, slotKEY, std::static_pointer_cast<BufferIO>(handle));
 		}
 
 		template<>
-		void addSlot<device::ResourceType::eImage>(size_t slotKEY, std::shared_ptr<void> handle)
+		uint32_t addSlot<device::ResourceType::eImage>(size_t slotKEY, std::shared_ptr<void> handle)
+		{
+			return pAddSlot(p_imageSlotIds, p_imageResourceSlots, slotKEY, std::static_pointer_cast<ImageIO>(handle));
+		}
+
+		/* returns the id of the removed slot (invalid if not found), the ids of the other slots don't change */
+		template<device::ResourceType RsrcT>
+		uint32_t removeSlot(size_t slotKEY);
+
+		template<>
+		uint32_t removeSlot<device::ResourceType::eBuffer>(size_t slotKEY)
+		{
+			return pRemoveSlot(p_bufferSlotIds, p_bufferResourceSlots, slotKEY);
+		}
+
+		template<>
+		uint32_t removeSlot<device::ResourceType::eImage>(size_t slotKEY)
+		{
+			return pRemoveSlot(p_imageSlotIds, p_imageResourceSlots, slotKEY);
+		}
+
+	protected:
+		template<typename SlotHandleT>
+		static uint32_t pRemoveSlot(std::map< size_t, uint32_t >& slotIds, std::vector< SlotHandleT >& slots, size_t slotKEY)
+		{
+			auto pId = slotIds.find(slotKEY);
+			if (pId == slotIds.end())
+				return compute::BufferId::INVALID;
+
+			// the id is not reused, a stale id of the application resolves to an empty slot
+			uint32_t slotId = pId->second;
+			slots[slotId].reset();
+			slotIds.erase(pId);
+			return slotId;
+		}
+
+		template<typename SlotHandleT>
+		static uint32_t pAddSlot(std::map< size_t, uint32_t >& slotIds, std::vector< SlotHandleT >& slots, size_t slotKEY, SlotHandleT const& handle)
 		{
-			p_imageResourceSlots[slotKEY].reset(reinterpret_cast<ImageIO*>(handle.get()));
-			handle.reset();
+			auto pId = slotIds.find(slotKEY);
+			if (pId != slotIds.end())
+			{
+				slots[pId->second] = handle;
+				return pId->second;
+			}
+
+			uint32_t slotId = static_cast<uint32_t>(slots.size());
+			slots.push_back(handle);
+			slotIds[slotKEY] = slotId;
+			return slotId;
 		}
 
 	protected:
-		std::map< size_t, BufferIOHandle > p_bufferResourceSlots;
-		std::map< size_t, ImageIOHandle > p_imageResourceSlots;
+		/* slots indexed by the interned id, the key -> id maps are used at resolve time only */
+		std::vector< BufferIOHandle > p_bufferResourceSlots;
+		std::vector< ImageIOHandle > p_imageResourceSlots;
+		std::map< size_t, uint32_t > p_bufferSlotIds;
+		std::map< size_t, uint32_t > p_imageSlotIds;
 	};
 
 } // end namespace opencl
@@ -29,6 +29,7 @@
 /* standard library */
 #include <string>
 #include <vector>
+#include <deque>
 #include <fstream>
 #include <locale>
 #include <unordered_map>
@@ -36,6 +37,12 @@
 #include <mutex>
 #include <memory>
 #include <condition_variable>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <thread>
+#include <functional>
+#include <future>
 #include <assert.h>
 
 
@@ -50,6 +57,22 @@ namespace compute = graphics_compute;
 
 #define COMPUTE_WARP_SIZE 32
 #define COMPUTE_GLOBAL_WORK_SIZES 65535
+#define COMPUTE_CPU_MAX_LOCAL_SIZE 128		/* keeps the working set of a cpu work-group cache resident */
+#define COMPUTE_CPU_GROUPS_PER_UNIT 4		/* work-groups per cpu compute unit (hardware thread) for load balancing */
+#define COMPUTE_BUFFER_POOL_SLAB_SIZE (64 * 1024 * 1024)	/* size of the device buffers the pooled buffers are carved from */
+#define COMPUTE_BUFFER_POOL_MAX_ALLOCATION_DIVISOR 4			/* buffers above slab size / divisor get standalone memory */
+#define COMPUTE_COPY_STAGING_CHUNK_SIZE (4 * 1024 * 1024)	/* pinned staging chunk of the cross device copies */
+#define COMPUTE_COPY_STAGING_SLOTS 2						/* chunks in flight (read of chunk i+1 overlaps write of chunk i) */
+#define COMPUTE_TUNING_REPETITIONS 3		/* timed runs per candidate shape (after a warm up run), the fastest counts */
+#define COMPUTE_PROFILING_WINDOW 1024		/* recent samples per timing for the percentiles */
+#define COMPUTE_PROFILING_MAX_PENDING 256	/* profiled events held before the completed ones are collected */
+#define COMPUTE_RESOURCE_MAX_READERS 16		/* reader events of a resource held before the completed ones are collected */
+#define COMPUTE_SHARD_MAX_LOCAL_SIZE 256	/* 1D local size limit of the sharded dispatches on gpus */
+#define COMPUTE_SHARD_EWMA_WEIGHT 0.25		/* weight of the latest throughput sample of a shard device */
+#define COMPUTE_PROGRAM_BUILD_OPTIONS "-cl-mad-enable -cl-kernel-arg-info"	/* arg info - arg names, TypedKernel signature checks, kernel fusion and read-only args */
+#define COMPUTE_FUSED_NAMESPACE_SUFFIX "__fused__"	/* namespace of the fused elementwise kernels of a namespace */
+#define COMPUTE_PIPE_RING_HEADER 8			/* uint header of the ring buffer pipes (see COMPUTE_PIPE_PRELUDE), the packets follow */
+#define COMPUTE_PIPE_RING_OVERFLOW 4		/* header word set by a write to a full ring buffer pipe */
 
 namespace opencl
 {
@@ -69,9 +92,33 @@ namespace opencl
 	class Image;
 	using ImageHandle = std::shared_ptr<Image>;
 
+	class Pipe;
+	using PipeHandle = std::shared_ptr<Pipe>;
+
 	/* oclExecutionNode */
 	class ExecutionNode;
 	using ExecNodeHandle = std::shared_ptr<ExecutionNode>;
+	struct DispatchSync;
+
+	/* oclMemoryPool.h */
+	class MemoryPool;
+	using MemoryPoolHandle = std::shared_ptr<MemoryPool>;
+
+	/* oclProgramCache.h */
+	class ProgramCache;
+	using ProgramCacheHandle = std::shared_ptr<ProgramCache>;
+
+	/* oclProfiler.h */
+	class Profiler;
+	using ProfilerHandle = std::shared_ptr<Profiler>;
+
+	/* oclTuningDatabase.h */
+	class TuningDatabase;
+	using TuningDbHandle = std::shared_ptr<TuningDatabase>;
+
+	/* oclExecutionGraph.h */
+	class ExecutionGraph;
+	using ExecGraphHandle = std::shared_ptr<ExecutionGraph>;
 
 	/* oclManager.h */
 	class Manager;
@@ -116,6 +163,24 @@ namespace opencl
 			throw device::runtime_error("OPENCL ERROR");	\
 		}
 
+	/* FNV-1a, stable across runs and builds (std::hash is not) | keys persisted on disk */
+	static const uint64_t FNV_OFFSET_BASIS = 14695981039346656037ull;
+
+	static inline void FNV_HASH_BYTES(uint64_t& hash, const void* data, size_t size)
+	{
+		const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data);
+		for (size_t i = 0; i < size; ++i)
+		{
+			hash ^= bytes[i];
+			hash *= 1099511628211ull;
+		}
+	}
+
+	static inline void FNV_HASH_STRING(uint64_t& hash, std::string const& str)
+	{
+		FNV_HASH_BYTES(hash, str.c_str(), str.size() + 1); // including the terminator as field separator
+	}
+
 	static inline size_t GET_EXECNODEKEY(std::string const& dispatchKEY)
 	{
 		return std::hash<std::string>{}(dispatchKEY);
@@ -141,6 +206,12 @@ namespace opencl
 		return std::hash<std::string>{}("__image__" + str);
 	}
 
+	template<>
+	size_t inline GET_RESOURCEKEY<device::ResourceType::ePipe>(std::string const& str)
+	{
+		return std::hash<std::string>{}("__pipe__" + str);
+	}
+
 	static inline cl::ImageFormat GET_CL_IMAGEFORMAT_FROM_DATAFORMAT(device::DataFormat dataFormat)
 	{
 		/*
@@ -186,6 +257,24 @@ namespace opencl
 			imageFormat.image_channel_data_type = CL_FLOAT;
 			imageFormat.image_channel_order = CL_RGBA;
 			break;
+		/* single channel float, the 32 bit counterpart of eFloat16 */
+		case device::DataFormat::eDouble32:
+			imageFormat.image_channel_data_type = CL_FLOAT;
+			imageFormat.image_channel_order = CL_R;
+			break;
+		/* 16 bit storage, read_imagef widens to float (normalized for the integer formats) */
+		case device::DataFormat::eFloat16:
+			imageFormat.image_channel_data_type = CL_HALF_FLOAT;
+			imageFormat.image_channel_order = CL_R;
+			break;
+		case device::DataFormat::eUint16:
+			imageFormat.image_channel_data_type = CL_UNORM_INT16;
+			imageFormat.image_channel_order = CL_R;
+			break;
+		case device::DataFormat::eInt16:
+			imageFormat.image_channel_data_type = CL_SNORM_INT16;
+			imageFormat.image_channel_order = CL_R;
+			break;
 		default:
 			assert(0);
 		}
@@ -193,7 +282,7 @@ namespace opencl
 		return imageFormat;
 	}
 
-	static inline void SET_CL_MEMFLAGS_FROM_DATA_ACCESS_QUALIFIER(device::DataAccessQualifier dataaccessQ, cl_mem_flags memflags)
+	static inline void SET_CL_MEMFLAGS_FROM_DATA_ACCESS_QUALIFIER(device::DataAccessQualifier dataaccessQ, cl_mem_flags& memflags)
 	{
 		/*
 		******************************
@@ -215,27 +304,46 @@ namespace opencl
 		case device::DataAccessQualifier::eDeviceLocal:
 			memflags |= CL_MEM_READ_WRITE;
 			break;
+		case device::DataAccessQualifier::eDeviceToHost:
+			memflags |= CL_MEM_READ_WRITE;
+			break;
 		case device::DataAccessQualifier::eHostLocal:
-			memflags |= CL_MEM_USE_HOST_PTR;
+			memflags |= CL_MEM_READ_WRITE | CL_MEM_ALLOC_HOST_PTR; // runtime allocated host memory, accessed with map/unmap
+			break;
+		case device::DataAccessQualifier::eSharedVirtual:
+			memflags |= CL_MEM_READ_WRITE; // svm allocation or the flattened fallback buffer, see Buffer::createSharedVirtual
 			break;
 		default:
 			assert(0);
 		}
 	}
 
+	/* size in bytes of a data unit of the format */
 	static inline size_t GET_SIZE_FROM_DATAFORMAT(device::DataFormat dataFormat)
 	{
-		// #improvement - add all the formats
 		switch (dataFormat)
 		{
-		case device::DataFormat::eDouble32:
-		case device::DataFormat::eInt32:
-		case device::DataFormat::eUint32:
-			return 32 * sizeof(char);
+		case device::DataFormat::eA8:
+			return sizeof(cl_uchar);
 		case device::DataFormat::eFloat16:
+			return sizeof(cl_half);
 		case device::DataFormat::eInt16:
+			return sizeof(cl_short);
 		case device::DataFormat::eUint16:
-			return 16 * sizeof(char);
+			return sizeof(cl_ushort);
+		case device::DataFormat::eDouble32:
+			return sizeof(cl_float);
+		case device::DataFormat::eInt32:
+			return sizeof(cl_int);
+		case device::DataFormat::eUint32:
+		case device::DataFormat::eRGBA32:
+			return sizeof(cl_uint);
+		case device::DataFormat::eR32G32Float:
+			return 2 * sizeof(cl_float);
+		case device::DataFormat::eR32G32B32A32Float:
+			return 4 * sizeof(cl_float);
+		case device::DataFormat::eMAT4Float:
+			return 16 * sizeof(cl_float);
 		default:
 			assert(0);
 		}
@@ -20,10 +20,37 @@ namespace opencl
 	ProgramHandle Device::createProgram(std::string const& kernelnamespace, std::vector< std::pair<char const*, size_t> > const& sources)
 	{
 		size_t _progHash = std::hash<std::string>{}(kernelnamespace); // #improvement - move Hash() to utils.
-		p_programs[_progHash] = std::make_shared<Program>(this);
-		p_programs[_progHash]->initProgram(sources);
+		ProgramHandle program = std::make_shared<Program>(this);
+		program->initProgram(sources);
 
-		return p_programs[_progHash];
+		std::lock_guard<std::mutex> lock(p_programMutex);
+		p_programs[_progHash] = program;
+
+		return program;
+	}
+
+	cl_int Device::createProgramFromBinary(std::string const& kernelnamespace, std::vector< unsigned char > const& binary)
+	{
+		size_t _progHash = std::hash<std::string>{}(kernelnamespace);
+		ProgramHandle program = std::make_shared<Program>(this);
+		cl_int clResult = program->initProgramFromBinary(binary);
+
+		std::lock_guard<std::mutex> lock(p_programMutex);
+		p_programs[_progHash] = program;
+
+		return clResult;
+	}
+
+	cl_int Device::createProgramFromIL(std::string const& kernelnamespace, std::vector< char > const& il)
+	{
+		size_t _progHash = std::hash<std::string>{}(kernelnamespace);
+		ProgramHandle program = std::make_shared<Program>(this);
+		cl_int clResult = program->initProgramFromIL(il);
+
+		std::lock_guard<std::mutex> lock(p_programMutex);
+		p_programs[_progHash] = program;
+
+		return clResult;
 	}
 
 	cl_int Device::buildProgram
@@ -36,10 +63,10 @@ namespace opencl
 	{
 		cl_int clResult = CL_BUILD_SUCCESS;
 
-		size_t _progHash = std::hash<std::string>{}(kernelnamespace);
-		if (p_programs.find(_progHash) != p_programs.end())
+		ProgramHandle program = pFindProgram(kernelnamespace);
+		if (program)
 		{
-			clResult = p_programs[_progHash]->build(options, notifyFptr, data);
+			clResult = program->build(options, notifyFptr, data);
 		}
 
 		return clResult;
@@ -49,13 +76,21 @@ namespace opencl
 	{
 		cl_int clResult = CL_SUCCESS;
 
-		size_t _progHash = std::hash<std::string>{}(kernelnamespace);
-		if (p_programs.find(_progHash) != p_programs.end())
+		ProgramHandle program = pFindProgram(kernelnamespace);
+		if (program)
 		{
-			clResult = p_programs[_progHash]->createKernels();
+			clResult = program->createKernels();
 		}
 
 		return clResult;
 	}
 
+	ProgramHandle Device::pFindProgram(std::string const& kernelnamespace) const
+	{
+		std::lock_guard<std::mutex> lock(p_programMutex);
+		auto pProgram = p_programs.find(std::hash<std::string>{}(kernelnamespace));
+
+		return pProgram != p_programs.end() ? pProgram->second : ProgramHandle();
+	}
+
 } // end namespace opencl
\ No newline at end of file
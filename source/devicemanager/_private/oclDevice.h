@@ -20,11 +20,29 @@ namespace opencl
 {
 	enum class DeviceProfile : uint32_t
 	{
-		eGeneral		= 0x0,
-		eGPGPU			= 0x1
+		eGeneral		= 0x0,	/* cpu devices (e.g. PoCL) */
+		eGPGPU			= 0x1	/* gpu devices */
 	};
 
 
+	enum class QueueType : uint32_t
+	{
+		eCompute		= 0x0,	/* ndrange dispatches, out of order (optional) */
+		eTransfer		= 0x1,	/* read/write/copy, always in order */
+		eCount			= 0x2
+	};
+
+
+
+	/* dispatch limits of a device, queried once (clGetDeviceInfo is not free on every dispatch) */
+	struct DeviceLimits
+	{
+		cl_uint						maxWorkItemDimensions{ 1 };			/* clamped to 3 */
+		std::array< uint64_t, 3 >	maxWorkItemSizes{ { 1, 1, 1 } };
+		uint64_t					maxWorkGroupSize{ 1 };
+		uint64_t					computeUnits{ 1 };
+	};
+
 
 	class Device
 		: public device::IDevice
@@ -34,7 +52,29 @@ namespace opencl
 			: IDevice(id, type)
 			, p_clDevice(clDevice)
 			, p_deviceProfile(profile)
-		{}
+		{
+			p_limits.maxWorkItemDimensions = std::min<cl_uint>(p_clDevice.getInfo<CL_DEVICE_MAX_WORK_ITEM_DIMENSIONS>(), 3);
+			std::vector<size_t> maxWorkItemSizes = p_clDevice.getInfo<CL_DEVICE_MAX_WORK_ITEM_SIZES>();
+			for (size_t idx = 0; idx < p_limits.maxWorkItemDimensions && idx < maxWorkItemSizes.size(); ++idx)
+			{
+				p_limits.maxWorkItemSizes[idx] = maxWorkItemSizes[idx];
+			}
+			p_limits.maxWorkGroupSize = p_clDevice.getInfo<CL_DEVICE_MAX_WORK_GROUP_SIZE>();
+			p_limits.computeUnits = std::max<uint64_t>(p_clDevice.getInfo<CL_DEVICE_MAX_COMPUTE_UNITS>(), 1);
+			p_isILSupported = p_clDevice.getInfo<CL_DEVICE_EXTENSIONS>().find("cl_khr_il_program") != std::string::npos;
+#ifdef CL_VERSION_2_0
+			// "OpenCL C <major>.<minor> ...", pipes are core in 2.x and optional from 3.0
+			std::string clcVersion = p_clDevice.getInfo<CL_DEVICE_OPENCL_C_VERSION>();
+			p_isPipeSupported = clcVersion.compare(0, 9, "OpenCL C ") == 0 && std::atoi(clcVersion.c_str() + 9) == 2;
+#ifdef CL_VERSION_3_0
+			p_isPipeSupported = p_isPipeSupported || p_clDevice.getInfo<CL_DEVICE_PIPE_SUPPORT>() == CL_TRUE;
+#endif
+			// 1.x runtimes fail the query, the capabilities stay 0
+			cl_device_svm_capabilities svmCapabilities = 0;
+			clGetDeviceInfo(p_clDevice(), CL_DEVICE_SVM_CAPABILITIES, sizeof(svmCapabilities), &svmCapabilities, nullptr);
+			p_isSVMSupported = (svmCapabilities & CL_DEVICE_SVM_COARSE_GRAIN_BUFFER) != 0;
+#endif
+		}
 
 		virtual ~Device()
 		{}
@@ -49,33 +89,84 @@ namespace opencl
 			return p_clDevice;
 		}
 
+		inline DeviceLimits const& getLimits() const
+		{
+			return p_limits;
+		}
+
+		/* SPIR-V programs (cl_khr_il_program) */
+		inline bool getIsILSupported() const
+		{
+			return p_isILSupported;
+		}
+
+		/* native pipes, false with the OpenCL 1.2 headers (the pipes are ring buffers, see Pipe) */
+		inline bool getIsPipeSupported() const
+		{
+			return p_isPipeSupported;
+		}
+
+		/* coarse-grained svm buffers, false with the OpenCL 1.2 headers (eSharedVirtual buffers are flattened, see Buffer) */
+		inline bool getIsSVMSupported() const
+		{
+			return p_isSVMSupported;
+		}
+
+		/* device memory is host memory (cpu, integrated gpu), a mapped pointer is a zero-copy view */
+		inline bool getIsHostUnifiedMemory() const
+		{
+			return p_clDevice.getInfo<CL_DEVICE_HOST_UNIFIED_MEMORY>() == CL_TRUE;
+		}
+
 		inline cl::Context getContext() const
 		{
 			return p_clContext;
 		}
 
-		inline cl::CommandQueue getCmdQueue() const
+		inline cl::CommandQueue getCmdQueue(QueueType type = QueueType::eCompute) const
 		{
-			return p_clCmdQueue;
+			return p_clCmdQueues[static_cast<size_t>(type)];
 		}
 
 		inline ProgramHandle getProgram(std::string const& kernelnamespace) const
 		{
+			std::lock_guard<std::mutex> lock(p_programMutex);
 			return p_programs.at(std::hash<std::string>{}(kernelnamespace));
 		}
+
+		inline bool hasProgram(std::string const& kernelnamespace) const
+		{
+			std::lock_guard<std::mutex> lock(p_programMutex);
+			return p_programs.find(std::hash<std::string>{}(kernelnamespace)) != p_programs.end();
+		}
 		
 		inline void createContext(cl_context_properties* properties = nullptr)
 		{
 			p_clContext = cl::Context(p_clDevice, properties);
 		}
 
-		inline void createCmdQueue(cl_command_queue_properties properties = 0)
+		/*
+		* Commands on different queues touching the same resource are ordered with the resource
+		* sync events (see ResourceSync), so an out of order compute queue runs only hazard free dispatches concurrently
+		* (dispatches reading the same resource included).
+		*/
+		inline void createCmdQueues(cl_command_queue_properties properties = 0, bool outOfOrderCompute = false)
 		{
-			p_clCmdQueue = cl::CommandQueue(p_clContext, p_clDevice, properties);
+			cl_command_queue_properties computeProps = properties;
+			cl_command_queue_properties supported = p_clDevice.getInfo<CL_DEVICE_QUEUE_PROPERTIES>();
+			if (outOfOrderCompute && (supported & CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE))
+				computeProps |= CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE;
+
+			p_clCmdQueues[static_cast<size_t>(QueueType::eCompute)] = cl::CommandQueue(p_clContext, p_clDevice, computeProps);
+			p_clCmdQueues[static_cast<size_t>(QueueType::eTransfer)] = cl::CommandQueue(p_clContext, p_clDevice, properties);
 		}
 
 		ProgramHandle createProgram(std::string const& kernelnamespace, std::vector< std::pair<char const*, size_t> > const& sources);
 
+		cl_int createProgramFromBinary(std::string const& kernelnamespace, std::vector< unsigned char > const& binary);
+
+		cl_int createProgramFromIL(std::string const& kernelnamespace, std::vector< char > const& il);
+
 		cl_int buildProgram
 		(
 			std::string const& kernelnamespace,
@@ -86,11 +177,23 @@ namespace opencl
 
 		cl_int createKernels(std::string const& kernelnamespace);
 
+	protected:
+		/* nullptr if the namespace has no program, the handle keeps the program alive during a build */
+		ProgramHandle pFindProgram(std::string const& kernelnamespace) const;
+
 
 	protected:
 		DeviceProfile			p_deviceProfile{ DeviceProfile::eGPGPU };
 		cl::Device				p_clDevice;
-		cl::CommandQueue		p_clCmdQueue;
+		DeviceLimits			p_limits;
+		bool					p_isILSupported{ false };
+		bool					p_isPipeSupported{ false };
+		bool					p_isSVMSupported{ false };
+		std::array
+			<
+			cl::CommandQueue,
+			static_cast<size_t>(QueueType::eCount)
+			>					p_clCmdQueues;
 		cl::Context				p_clContext; /* one primary context per device, similar to cuda */
 
 		std::map
@@ -98,6 +201,7 @@ namespace opencl
 			size_t,
 			ProgramHandle
 			>					p_programs;
+		mutable std::mutex		p_programMutex;	/* namespaces are built concurrently, the builds run outside the lock */
 
 	};
 
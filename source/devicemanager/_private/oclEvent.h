@@ -0,0 +1,141 @@
+/*
+* ---------------------------------------------------------
+* Copyright 2018-present (c) Automatos Studios. All Rights Reserved.
+* ---------------------------------------------------------
+*/
+
+/**
+* @file			oclEvent.h
+* @author		cosmoplankton < cosmoplankton@automatos.studio >
+*/
+
+
+#ifndef OPENCL_EVENT
+#define OPENCL_EVENT
+
+#include "oclDefines.h"
+
+
+namespace opencl
+{
+
+	/**
+	* @class	SyncEvent
+	* @brief	Implementation of the compute::IEvent for a cl::Event.
+	*/
+	class SyncEvent final
+		: public compute::IEvent
+	{
+	public:
+		explicit SyncEvent(cl::Event const& event)
+			: p_clEvent(event)
+		{}
+
+		virtual ~SyncEvent()
+		{}
+
+		inline cl::Event getEvent() const
+		{
+			return p_clEvent;
+		}
+
+		virtual int wait() override
+		{
+			return p_clEvent.wait();
+		}
+
+		virtual bool isComplete() const override
+		{
+			/* negative status - command terminated with an error, nothing left to wait on */
+			cl_int status = CL_COMPLETE;
+			p_clEvent.getInfo(CL_EVENT_COMMAND_EXECUTION_STATUS, &status);
+			return status <= CL_COMPLETE;
+		}
+
+	protected:
+		cl::Event p_clEvent;
+	};
+
+
+	/* access of a resource by a device command */
+	enum class ResourceAccess : uint32_t
+	{
+		eRead = 0x0,
+		eWrite = 0x1
+	};
+
+
+	/**
+	* @class	ResourceSync
+	* @brief	Device accesses (transfers and dispatches) of a resource.
+	*--------------------------------------------------------------------------
+	* Keeps the last write and the reads issued after it. A read waits on the last write only and joins
+	* the readers, a write waits on the last write and all the readers and replaces them. Commands on
+	* different queues (or an out of order queue) are ordered per resource, concurrent reads overlap.
+	* Transfers and maps are writes, see ExecutionNode for the kernel args.
+	*--------------------------------------------------------------------------
+	*/
+	class ResourceSync
+	{
+	public:
+		/* last write */
+		inline cl::Event getSyncEvent() const
+		{
+			return p_syncEvent;
+		}
+
+		inline void setSyncEvent(cl::Event const& event, ResourceAccess access = ResourceAccess::eWrite) const
+		{
+			if (access == ResourceAccess::eWrite)
+			{
+				p_syncEvent = event;
+				p_readEvents.clear();
+				return;
+			}
+
+			if (p_readEvents.size() >= COMPUTE_RESOURCE_MAX_READERS)
+				pCollectReadEvents();
+
+			p_readEvents.push_back(event);
+		}
+
+		inline void appendSyncEvent(std::vector< cl::Event >& waitEvents, ResourceAccess access = ResourceAccess::eWrite) const
+		{
+			if (p_syncEvent())
+				waitEvents.push_back(p_syncEvent);
+
+			if (access == ResourceAccess::eWrite)
+				waitEvents.insert(waitEvents.end(), p_readEvents.begin(), p_readEvents.end());
+		}
+
+	protected:
+		/* drops the completed reads (a long read-only phase would grow the wait lists of the next write) */
+		inline void pCollectReadEvents() const
+		{
+			p_readEvents.erase(std::remove_if(p_readEvents.begin(), p_readEvents.end(), [](cl::Event const& event)
+			{
+				cl_int status = CL_COMPLETE;
+				event.getInfo(CL_EVENT_COMMAND_EXECUTION_STATUS, &status);
+				return status <= CL_COMPLETE;
+			}), p_readEvents.end());
+		}
+
+		/* blocks until the last write and every pending read have completed (before the memory is released or reused) */
+		inline void pWaitPending() const
+		{
+			std::vector< cl::Event > waitEvents;
+			appendSyncEvent(waitEvents, ResourceAccess::eWrite);
+			if (waitEvents.size())
+				cl::Event::waitForEvents(waitEvents);
+		}
+
+	protected:
+		/* sync state, not part of the resource state (reads update it as well) */
+		mutable cl::Event p_syncEvent;
+		mutable std::vector< cl::Event > p_readEvents;
+	};
+
+} // end namespace opencl
+
+
+#endif // !OPENCL_EVENT
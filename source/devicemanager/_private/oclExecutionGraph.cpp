@@ -0,0 +1,150 @@
+/*
+* ---------------------------------------------------------
+* Copyright 2018-present (c) Automatos Studios. All Rights Reserved.
+* ---------------------------------------------------------
+*/
+
+/**
+* @file			oclExecutionGraph.cpp
+* @author		cosmoplankton < cosmoplankton@automatos.studio >
+*/
+
+
+#include "oclExecutionGraph.h"
+
+
+namespace opencl
+{
+
+	void ExecutionGraph::addNode(size_t nodeKEY, ExecNodeHandle node)
+	{
+		p_vertices[nodeKEY].node = node;
+	}
+
+	void ExecutionGraph::removeNode(size_t nodeKEY)
+	{
+		auto pVertex = p_vertices.find(nodeKEY);
+		if (pVertex == p_vertices.end())
+			return;
+
+		for (auto upKEY : pVertex->second.upstream)
+		{
+			auto& downstream = p_vertices.at(upKEY).downstream;
+			downstream.erase(std::remove(downstream.begin(), downstream.end(), nodeKEY), downstream.end());
+		}
+
+		for (auto downKEY : pVertex->second.downstream)
+		{
+			auto& upstream = p_vertices.at(downKEY).upstream;
+			upstream.erase(std::remove(upstream.begin(), upstream.end(), nodeKEY), upstream.end());
+		}
+
+		p_vertices.erase(pVertex);
+	}
+
+	cl_int ExecutionGraph::addEdge(size_t upstreamKEY, size_t downstreamKEY)
+	{
+		if (!hasNode(upstreamKEY) || !hasNode(downstreamKEY) || upstreamKEY == downstreamKEY)
+			return CL_INVALID_VALUE;
+
+		p_vertices[upstreamKEY].downstream.push_back(downstreamKEY);
+		p_vertices[downstreamKEY].upstream.push_back(upstreamKEY);
+
+		return CL_SUCCESS;
+	}
+
+	bool ExecutionGraph::validate() const
+	{
+		std::map<size_t, size_t> inDegree;
+		std::vector<size_t> ready;
+		for (auto &pVertex : p_vertices)
+		{
+			inDegree[pVertex.first] = pVertex.second.upstream.size();
+			if (!inDegree[pVertex.first])
+				ready.push_back(pVertex.first);
+		}
+
+		size_t visited = 0;
+		while (ready.size())
+		{
+			size_t nodeKEY = ready.back();
+			ready.pop_back();
+			++visited;
+
+			for (auto downKEY : p_vertices.at(nodeKEY).downstream)
+			{
+				if (!--inDegree[downKEY])
+					ready.push_back(downKEY);
+			}
+		}
+
+		return visited == p_vertices.size();
+	}
+
+	cl_int ExecutionGraph::schedule(std::vector< compute::DispatchPayload > const& payloads, std::vector< ScheduledNode >& order) const
+	{
+		order.clear();
+
+		// nodes of this submission (node key -> payload index)
+		std::map<size_t, size_t> submitted;
+		for (size_t idx = 0; idx < payloads.size(); ++idx)
+		{
+			size_t nodeKEY = GET_EXECNODEKEY(payloads[idx].tag);
+			if (!hasNode(nodeKEY) || submitted.count(nodeKEY))
+				return CL_INVALID_VALUE;
+
+			submitted[nodeKEY] = idx;
+		}
+
+		// in-degree over the induced sub-graph, payload order is kept among the ready nodes
+		std::map<size_t, size_t> inDegree;
+		std::vector<size_t> ready;
+		for (auto &pPayload : payloads)
+		{
+			size_t nodeKEY = GET_EXECNODEKEY(pPayload.tag);
+			size_t degree = 0;
+			for (auto upKEY : p_vertices.at(nodeKEY).upstream)
+			{
+				if (submitted.count(upKEY))
+					++degree;
+			}
+
+			inDegree[nodeKEY] = degree;
+			if (!degree)
+				ready.push_back(nodeKEY);
+		}
+
+		std::map<size_t, size_t> scheduleIdx; // node key -> index in order
+		for (size_t head = 0; head < ready.size(); ++head)
+		{
+			size_t nodeKEY = ready[head];
+
+			ScheduledNode scheduled;
+			scheduled.nodeKEY = nodeKEY;
+			scheduled.payloadIdx = submitted[nodeKEY];
+			for (auto upKEY : p_vertices.at(nodeKEY).upstream)
+			{
+				if (submitted.count(upKEY))
+				{
+					scheduled.waitIdx.push_back(scheduleIdx.at(upKEY));
+					order[scheduleIdx.at(upKEY)].isSink = false;
+				}
+			}
+
+			scheduleIdx[nodeKEY] = order.size();
+			order.push_back(scheduled);
+
+			for (auto downKEY : p_vertices.at(nodeKEY).downstream)
+			{
+				if (submitted.count(downKEY) && !--inDegree[downKEY])
+					ready.push_back(downKEY);
+			}
+		}
+
+		if (order.size() != payloads.size())
+			return CL_INVALID_VALUE; // cycle, validate() at init should prevent this
+
+		return CL_SUCCESS;
+	}
+
+} // end namespace opencl
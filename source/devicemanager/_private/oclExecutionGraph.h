@@ -0,0 +1,88 @@
+/*
+* ---------------------------------------------------------
+* Copyright 2018-present (c) Automatos Studios. All Rights Reserved.
+* ---------------------------------------------------------
+*/
+
+/**
+* @file			oclExecutionGraph.h
+* @author		cosmoplankton < cosmoplankton@automatos.studio >
+*/
+
+
+#ifndef OPENCL_EXEC_GRAPH
+#define OPENCL_EXEC_GRAPH
+
+#include "oclDefines.h"
+
+
+namespace opencl
+{
+
+	/**
+	* @struct	ScheduledNode
+	* @brief	A node of a graph submission in execution order.
+	*/
+	struct ScheduledNode
+	{
+		size_t				nodeKEY;
+		size_t				payloadIdx;		/* index in GraphPayload::dispatches */
+		std::vector<size_t> waitIdx;		/* indices (in the schedule) of the upstream nodes */
+		bool				isSink{ true };	/* no downstream node in this submission */
+	};
+
+
+	/**
+	* @class	ExecutionGraph
+	* @brief	DAG of the ExecutionNodes. Edges are the DispatchDescription dependencies.
+	*--------------------------------------------------------------------------
+	* The graph owns the ExecutionNodes. A submission is scheduled over the sub-graph induced
+	* by the submitted dispatches, the ExecutionManager wires the schedule with cl::Event wait lists.
+	*--------------------------------------------------------------------------
+	*/
+	class ExecutionGraph
+	{
+	public:
+		struct Vertex
+		{
+			ExecNodeHandle		node;
+			std::vector<size_t> upstream;
+			std::vector<size_t> downstream;
+		};
+
+		inline ExecutionNode* getNode(size_t nodeKEY) const
+		{
+			return p_vertices.at(nodeKEY).node.get();
+		}
+
+		inline bool hasNode(size_t nodeKEY) const
+		{
+			return p_vertices.find(nodeKEY) != p_vertices.end();
+		}
+
+		void addNode(size_t nodeKEY, ExecNodeHandle node);
+
+		/* removes the node and its edges */
+		void removeNode(size_t nodeKEY);
+
+		inline std::map< size_t, Vertex > const& getVertices() const
+		{
+			return p_vertices;
+		}
+
+		cl_int addEdge(size_t upstreamKEY, size_t downstreamKEY);
+
+		/* returns false if the graph has a cycle */
+		bool validate() const;
+
+		/* topological order (Kahn) of the submitted dispatches */
+		cl_int schedule(std::vector< compute::DispatchPayload > const& payloads, std::vector< ScheduledNode >& order) const;
+
+	protected:
+		std::map< size_t, Vertex > p_vertices;
+	};
+
+} // end namespace opencl
+
+
+#endif // !OPENCL_EXEC_GRAPH
@@ -17,7 +17,10 @@
 #include "oclManager.h"
 #include "oclResourceManager.h"
 #include "oclExecutionNode.h"
+#include "oclExecutionGraph.h"
 #include "oclExecutionManager.h"
+#include "oclTuningDatabase.h"
+#include "oclProfiler.h"
 
 
 
@@ -26,6 +29,7 @@ namespace opencl
 
 	ExecutionManager::ExecutionManager(Manager* mgr)
 		: p_mgr(mgr)
+		, p_execGraph(std::make_shared<ExecutionGraph>())
 	{
 		ResourceIO::s_MGR = mgr;
 		ArgSlot::s_MGR = mgr;
@@ -35,6 +39,20 @@ namespace opencl
 	{
 		cl_int clResult = CL_SUCCESS;
 
+		// only the namespaces of this pipeline have to be built, the other namespaces keep building
+		std::set< std::string > kernelNamespaces;
+		for (auto &pDesc : appComputePipeline->getDispatchDescriptions())
+		{
+			kernelNamespaces.insert(pDesc.getKernelNamespace());
+		}
+
+		for (auto &pNamespace : kernelNamespaces)
+		{
+			clResult = getManager()->waitKernels(pNamespace);
+			if (clResult != CL_SUCCESS)
+				return clResult;
+		}
+
 		p_appComputePipeline = appComputePipeline;
 		p_appComputePipeline->initDataIO(std::make_shared<compute::DataIO>(new DataSlot()));
 		p_appComputePipeline->initDispatchIO(std::make_shared<compute::DispatchIO>(new DispatchSlot()));
@@ -48,16 +66,47 @@ namespace opencl
 			clResult = pAddBufferResource(pDesc);
 		}
 
+		if (bufferData.size())
+		{
+			MemoryPoolStats poolStats = getManager()->getResourceManager()->getMemoryPoolStats();
+			std::string _logInfo_ = "BUFFER POOL ALLOCATIONS: " + std::to_string(poolStats.allocationCount)
+				+ " SLABS: " + std::to_string(poolStats.slabCount)
+				+ " RESERVED: " + std::to_string(poolStats.reservedBytes)
+				+ " ALLOCATED: " + std::to_string(poolStats.allocatedBytes)
+				+ " FRAGMENTATION: " + std::to_string(poolStats.getFragmentation());
+			getManager()->LOG_MESSAGE(_logInfo_);
+		}
+
 		for (auto &pDesc : imageData)
 		{
 			clResult = pAddImageResource(pDesc);
 		}
 
+		for (auto &pDesc : p_appComputePipeline->getPipeDescriptions())
+		{
+			clResult = pAddPipeResource(pDesc);
+		}
+
 		for (auto &pDesc : dispatchData)
 		{
 			clResult = pAddExecutionNodes(pDesc);
 		}
 
+		// edges after all the nodes, a dispatch could depend on a dispatch described later
+		for (auto &pDesc : dispatchData)
+		{
+			clResult = pAddDependencies(pDesc);
+		}
+
+		if (!p_execGraph->validate())
+		{
+			std::string _logInfo_ = LOG_HEADER() + " EXECUTION GRAPH HAS A CYCLE.";
+			getManager()->LOG_ERROR(_logInfo_);
+			THROW_EXCEPTION(device::init_error("EXECUTION GRAPH HAS A CYCLE."));
+		}
+
+		pAddFusedChains();
+
 		ResourceIO::setGLock(false);
 		ArgSlot::setGLock(false);
 
@@ -77,12 +126,16 @@ namespace opencl
 		size_t bufKEY = GET_RESOURCEKEY<device::ResourceType::eBuffer>(bufDesc.getTag());
 
 		// create buffer
+		p_bufferDescs[bufKEY] = bufDesc;
 		p_buffers[bufKEY] = std::make_shared< Buffer >(getManager()->getPrimaryDevice());		
-		clResult = getManager()->getResourceManager()->createBuffer(p_buffers[bufKEY].get(), bufDesc);
+		clResult = getManager()->getResourceManager()->allocateBuffer(p_buffers[bufKEY].get(), bufDesc);
 
 		// create buffer io slot
 		DataSlot* dataslot = reinterpret_cast<DataSlot*>(p_appComputePipeline->getDataIO()->getImpl());
-		dataslot->addSlot<device::ResourceType::eBuffer>(bufKEY, std::make_shared<BufferIO>(bufKEY));
+		uint32_t bufferId = dataslot->addSlot<device::ResourceType::eBuffer>(bufKEY, std::make_shared<BufferIO>(bufKEY));
+		if (bufferId >= p_bufferTable.size())
+			p_bufferTable.resize(bufferId + 1);
+		p_bufferTable[bufferId] = std::make_pair(bufKEY, p_buffers[bufKEY].get());
 
 		return clResult;
 	}
@@ -100,11 +153,25 @@ namespace opencl
 
 		// create image io slot
 		DataSlot* dataslot = reinterpret_cast<DataSlot*>(p_appComputePipeline->getDataIO()->getImpl());
-		dataslot->addSlot<device::ResourceType::eImage>(imgKEY, std::make_shared<ImageIO>(imgKEY));
+		uint32_t imageId = dataslot->addSlot<device::ResourceType::eImage>(imgKEY, std::make_shared<ImageIO>(imgKEY));
+		if (imageId >= p_imageTable.size())
+			p_imageTable.resize(imageId + 1);
+		p_imageTable[imageId] = std::make_pair(imgKEY, p_images[imgKEY].get());
 
 		return clResult;
 	}
 
+	cl_int ExecutionManager::pAddPipeResource(compute::PipeDescription const& pipeDesc)
+	{
+		// unique resource key
+		size_t pipeKEY = GET_RESOURCEKEY<device::ResourceType::ePipe>(pipeDesc.getTag());
+
+		// no io slot, pipes are only accessed by the kernels
+		p_pipes[pipeKEY] = std::make_shared< Pipe >(getManager()->getPrimaryDevice());
+
+		return getManager()->getResourceManager()->createPipe(p_pipes[pipeKEY].get(), pipeDesc);
+	}
+
 	cl_int ExecutionManager::pAddExecutionNodes(compute::DispatchDescription const& dispatchDesc)
 	{
 		cl_int clResult = CL_SUCCESS;
@@ -114,33 +181,435 @@ namespace opencl
 		size_t execNodeKEY = GET_EXECNODEKEY(dispatchDesc.getTag());
 		auto& kernelName = dispatchDesc.getKernelName();
 		auto& kernelNamespace = dispatchDesc.getKernelNamespace();
-		p_execNodes[execNodeKEY] = std::make_shared<ExecutionNode>(device, kernelName, kernelNamespace);
+		p_execGraph->addNode(execNodeKEY, std::make_shared<ExecutionNode>(device, kernelName, kernelNamespace));
+		p_execGraph->getNode(execNodeKEY)->setIsAutotuned(dispatchDesc.getIsAutotuned());
+		if (getManager()->getProfiler())
+			p_execGraph->getNode(execNodeKEY)->setProfiler(getManager()->getProfiler(), dispatchDesc.getTag());
+
+		if (dispatchDesc.getIsSharded())
+		{
+			pAddShardReplicas(execNodeKEY, dispatchDesc);
+		}
 
 		// create kernel io slots
 		DispatchSlot* dispatchSlot = reinterpret_cast<DispatchSlot*>(p_appComputePipeline->getDispatchIO()->getImpl());
 		size_t kernelKEY = GET_KERNELKEY(kernelName, kernelNamespace);
 		compute::KernelIOHandle kernelIO = std::make_shared<compute::KernelIO>(new KernelSlot());
-		dispatchSlot->addKernelIO(kernelKEY, kernelIO);
+		dispatchSlot->addKernelIO(kernelKEY, kernelIO, execNodeKEY);
 
 		KernelSlot* slotData = reinterpret_cast<KernelSlot*>(kernelIO->getImpl());
 		auto prgramHandle = device->getProgram(kernelNamespace);
 		cl::Kernel kernelObj = prgramHandle->getKernel(kernelName);
 		int argCount = kernelObj.getInfo<CL_KERNEL_NUM_ARGS>();
+
+		// queried with the kernels or restored by the program cache, nullptr without arg info
+		std::vector< KernelArgInfo > const* argInfo = prgramHandle->getArgInfo(kernelName);
 		
 		// create arg io slots
 		for(int argIdx = 0; argIdx <argCount; ++argIdx)
 		{
-			std::string argName = kernelObj.getArgInfo<CL_KERNEL_ARG_NAME>(argIdx);
-			compute::ArgIOHandle argIO = std::make_shared<compute::ArgIO>(new ArgSlot(argIdx, execNodeKEY));
-			slotData->addArgIO(argName, argIO);
+			std::string argName;
+
+			// signature for the TypedKernel checks
+			ArgSignature signature;
+			if (argInfo)
+			{
+				KernelArgInfo const& info = argInfo->at(argIdx);
+				argName = info.name;
+				signature.addressQualifier = info.addressQualifier;
+				signature.typeName = info.typeName;
+			}
+
+			compute::ArgIOHandle argIO = std::make_shared<compute::ArgIO>(new ArgSlot(argIdx, execNodeKEY, p_execGraph->getNode(execNodeKEY)));
+			slotData->addArgIO(argName, argIO, signature);
+		}
+
+		return clResult;
+	}
+
+	cl_int ExecutionManager::pAddDependencies(compute::DispatchDescription const& dispatchDesc)
+	{
+		cl_int clResult = CL_SUCCESS;
+
+		size_t execNodeKEY = GET_EXECNODEKEY(dispatchDesc.getTag());
+		for (auto &pDependency : dispatchDesc.getDependencies())
+		{
+			size_t upstreamKEY = GET_EXECNODEKEY(pDependency.getTag());
+			if (p_execGraph->addEdge(upstreamKEY, execNodeKEY) != CL_SUCCESS)
+			{
+				std::string _logInfo_ = LOG_HEADER() + " INVALID DEPENDENCY: " + pDependency.getTag() + " -> " + dispatchDesc.getTag();
+				getManager()->LOG_ERROR(_logInfo_);
+				clResult = CL_INVALID_VALUE;
+			}
 		}
 
 		return clResult;
 	}
 
+	void ExecutionManager::pAddFusedChains()
+	{
+		auto const& dispatchData = p_appComputePipeline->getDispatchDescriptions();
+		auto const& vertices = p_execGraph->getVertices();
+
+		// sharded stages are excluded, a batch dispatches them split across the devices
+		std::map< size_t, compute::DispatchDescription const* > fusable;
+		for (auto &pDesc : dispatchData)
+		{
+			size_t execNodeKEY = GET_EXECNODEKEY(pDesc.getTag());
+			if (pDesc.getElementwiseFunction().size() && !pDesc.getIsSharded() && p_execGraph->hasNode(execNodeKEY))
+				fusable[execNodeKEY] = &pDesc;
+		}
+
+		// the next stage is the only downstream of the stage, with the stage as its only upstream
+		auto findNextStage = [&](size_t stageKEY, size_t& nextKEY) -> bool
+		{
+			auto const& downstream = vertices.at(stageKEY).downstream;
+			if (downstream.size() != 1)
+				return false;
+
+			auto pNext = fusable.find(downstream[0]);
+			if (pNext == fusable.end() || vertices.at(pNext->first).upstream.size() != 1)
+				return false;
+
+			if (pNext->second->getKernelNamespace() != fusable.at(stageKEY)->getKernelNamespace())
+				return false;
+
+			nextKEY = pNext->first;
+			return true;
+		};
+
+		// one fused program per namespace
+		std::map< std::string, std::vector< FusedChain > > chains;
+		std::map< std::string, std::string > fusedSources;
+		for (auto &pStage : fusable)
+		{
+			size_t headKEY = 0;
+			auto const& upstream = vertices.at(pStage.first).upstream;
+			if (upstream.size() == 1 && fusable.count(upstream[0]) && findNextStage(upstream[0], headKEY))
+				continue; // not the head of a chain
+
+			FusedChain chain;
+			std::vector< FusedStage > stages;
+			size_t stageKEY = pStage.first;
+			size_t nextKEY = 0;
+			while (true)
+			{
+				chain.stageKEYs.push_back(stageKEY);
+				stages.push_back(FusedStage{ fusable.at(stageKEY)->getElementwiseFunction(), p_execGraph->getNode(stageKEY)->getKernelArgInfo() });
+				if (!findNextStage(stageKEY, nextKEY))
+					break;
+
+				stageKEY = nextKEY;
+			}
+
+			if (chain.stageKEYs.size() < 2)
+				continue;
+
+			auto const& kernelNamespace = pStage.second->getKernelNamespace();
+			chain.tag = pStage.second->getTag() + COMPUTE_FUSED_NAMESPACE_SUFFIX;
+			chain.kernelName = "compute_fused_kernel_" + std::to_string(chains[kernelNamespace].size());
+			chain.fusedKEY = GET_EXECNODEKEY(chain.tag);
+			if (p_execGraph->hasNode(chain.fusedKEY))
+				continue;
+
+			std::string source = GENERATE_FUSED_KERNEL(chain.kernelName, stages, chain.paramCounts);
+			if (source.empty())
+			{
+				std::string _logInfo_ = LOG_HEADER() + " ELEMENTWISE CHAIN NOT FUSED (stage signature): " + pStage.second->getTag();
+				getManager()->LOG_MESSAGE(_logInfo_);
+				continue;
+			}
+
+			fusedSources[kernelNamespace] += source;
+			chains[kernelNamespace].push_back(chain);
+		}
+
+		Device* device = getManager()->getPrimaryDevice();
+		for (auto &pChains : chains)
+		{
+			// a failed build leaves the chains unfused
+			if (getManager()->buildFusedProgram(device, pChains.first, fusedSources[pChains.first]) != CL_SUCCESS)
+				continue;
+
+			std::string fusedNamespace = pChains.first + COMPUTE_FUSED_NAMESPACE_SUFFIX;
+			for (auto &pChain : pChains.second)
+			{
+				p_execGraph->addNode(pChain.fusedKEY, std::make_shared<ExecutionNode>(device, pChain.kernelName, fusedNamespace));
+				if (getManager()->getProfiler())
+					p_execGraph->getNode(pChain.fusedKEY)->setProfiler(getManager()->getProfiler(), pChain.tag);
+
+				// the fused node takes the place of the chain in the graph
+				std::vector< size_t > upstream = vertices.at(pChain.stageKEYs.front()).upstream;
+				std::vector< size_t > downstream = vertices.at(pChain.stageKEYs.back()).downstream;
+				for (auto upKEY : upstream)
+				{
+					p_execGraph->addEdge(upKEY, pChain.fusedKEY);
+				}
+				for (auto downKEY : downstream)
+				{
+					p_execGraph->addEdge(pChain.fusedKEY, downKEY);
+				}
+
+				for (auto stageKEY : pChain.stageKEYs)
+				{
+					p_fusedStageOf[stageKEY] = pChain.fusedKEY;
+				}
+				p_fusedChains[pChain.fusedKEY] = pChain;
+
+				std::string _logInfo_ = "ELEMENTWISE CHAIN FUSED: " + pChain.tag + " STAGES: " + std::to_string(pChain.stageKEYs.size());
+				getManager()->LOG_MESSAGE(_logInfo_);
+			}
+		}
+	}
+
+	void ExecutionManager::pRemoveFusedChain(size_t fusedKEY)
+	{
+		auto pChain = p_fusedChains.find(fusedKEY);
+		if (pChain == p_fusedChains.end())
+			return;
+
+		for (auto stageKEY : pChain->second.stageKEYs)
+		{
+			p_fusedStageOf.erase(stageKEY);
+		}
+
+		p_execGraph->removeNode(fusedKEY);
+		p_fusedChains.erase(pChain);
+	}
+
+	bool ExecutionManager::pFusePayloads(compute::DispatchPayload const* payloads, size_t count, bool ordered, std::vector< compute::DispatchPayload >& fused)
+	{
+		if (p_fusedChains.empty())
+			return false;
+
+		// payload index of the stages, a stage submitted more than once isn't fused
+		std::map< size_t, size_t > stageIdx;
+		for (size_t idx = 0; idx < count; ++idx)
+		{
+			size_t execNodeKEY = GET_EXECNODEKEY(payloads[idx].tag);
+			if (!p_fusedStageOf.count(execNodeKEY))
+				continue;
+
+			if (!stageIdx.emplace(execNodeKEY, idx).second)
+				return false;
+		}
+
+		if (stageIdx.size() < 2)
+			return false;
+
+		std::map< size_t, std::string > fusedHeads; /* payload index of the chain head -> fused tag */
+		std::vector< bool > isFusedStage(count, false);
+		for (auto &pChain : p_fusedChains)
+		{
+			FusedChain const& chain = pChain.second;
+
+			std::vector< size_t > indices;
+			for (auto stageKEY : chain.stageKEYs)
+			{
+				auto pIdx = stageIdx.find(stageKEY);
+				if (pIdx == stageIdx.end())
+					break;
+
+				indices.push_back(pIdx->second);
+			}
+
+			if (indices.size() != chain.stageKEYs.size())
+				continue;
+
+			bool isFusable = true;
+			for (size_t stage = 1; stage < indices.size() && isFusable; ++stage)
+			{
+				isFusable = payloads[indices[stage]].globalworksize == payloads[indices[0]].globalworksize
+					&& (!ordered || indices[stage] == indices[stage - 1] + 1);
+			}
+
+			if (!isFusable || pPrepareFusedChain(chain, payloads[indices[0]].globalworksize) != CL_SUCCESS)
+				continue;
+
+			fusedHeads[indices[0]] = chain.tag;
+			for (auto idx : indices)
+			{
+				isFusedStage[idx] = true;
+			}
+		}
+
+		if (fusedHeads.empty())
+			return false;
+
+		fused.clear();
+		for (size_t idx = 0; idx < count; ++idx)
+		{
+			auto pHead = fusedHeads.find(idx);
+			if (pHead != fusedHeads.end())
+			{
+				fused.push_back(payloads[idx]);
+				fused.back().tag = pHead->second;
+			}
+			else if (!isFusedStage[idx])
+			{
+				fused.push_back(payloads[idx]);
+			}
+		}
+
+		return true;
+	}
+
+	cl_int ExecutionManager::pPrepareFusedChain(FusedChain const& chain, size_t globalworksize)
+	{
+		cl_int clResult = CL_SUCCESS;
+
+		// equivalent to the chain only if every stage reads the buffer written by the previous stage
+		size_t outKEY = 0;
+		std::vector< ResourceSync const* > intermediates;
+		for (size_t stage = 0; stage < chain.stageKEYs.size(); ++stage)
+		{
+			auto const& records = p_execGraph->getNode(chain.stageKEYs[stage])->getArgRecords();
+			if (!records[0].isBuffer || !records[1].isBuffer || (stage && records[0].resourceKEY != outKEY))
+				return CL_INVALID_KERNEL_ARGS;
+
+			outKEY = records[1].resourceKEY;
+			if (stage + 1 < chain.stageKEYs.size())
+			{
+				auto pBuffer = p_buffers.find(outKEY);
+				if (pBuffer == p_buffers.end())
+					return CL_INVALID_MEM_OBJECT;
+
+				intermediates.push_back(pBuffer->second.get());
+			}
+		}
+
+		// the fused kernel doesn't write the intermediates, no other dispatch may read them
+		for (auto &pVertex : p_execGraph->getVertices())
+		{
+			if (pVertex.first == chain.fusedKEY || std::find(chain.stageKEYs.begin(), chain.stageKEYs.end(), pVertex.first) != chain.stageKEYs.end())
+				continue;
+
+			ExecutionNode* node = p_execGraph->getNode(pVertex.first);
+			for (auto intermediate : intermediates)
+			{
+				if (node->isResourceBound(intermediate))
+				{
+					std::string _logInfo_ = LOG_HEADER() + " ELEMENTWISE CHAIN NOT FUSED (intermediate buffer bound to another dispatch): " + chain.tag;
+					getManager()->LOG_MESSAGE(_logInfo_);
+					return CL_INVALID_KERNEL_ARGS;
+				}
+			}
+		}
+
+		ExecutionNode* fusedNode = p_execGraph->getNode(chain.fusedKEY);
+		auto bindBuffer = [&](cl_uint argIdx, size_t bufKEY) -> cl_int
+		{
+			auto pBuffer = p_buffers.find(bufKEY);
+			if (pBuffer == p_buffers.end())
+				return CL_INVALID_MEM_OBJECT;
+
+			cl_mem memPtr = pBuffer->second->getResource()();
+			fusedNode->bindResource(argIdx, pBuffer->second.get());
+			cl_int argResult = fusedNode->setArg(argIdx, sizeof(cl_mem), &memPtr);
+			fusedNode->recordResourceArg(argIdx, device::ResourceType::eBuffer, bufKEY);
+			return argResult;
+		};
+
+		clResult = bindBuffer(0, p_execGraph->getNode(chain.stageKEYs.front())->getArgRecords()[0].resourceKEY);
+		if (clResult == CL_SUCCESS)
+			clResult = bindBuffer(1, outKEY);
+		if (clResult != CL_SUCCESS)
+			return clResult;
+
+		// stage params in chain order, the values last set on the stage kernels
+		cl_uint fusedArgIdx = 2;
+		for (size_t stage = 0; stage < chain.stageKEYs.size(); ++stage)
+		{
+			auto const& records = p_execGraph->getNode(chain.stageKEYs[stage])->getArgRecords();
+			for (cl_uint paramIdx = 0; paramIdx < chain.paramCounts[stage]; ++paramIdx)
+			{
+				ArgRecord const& record = records[2 + paramIdx];
+				if (record.value.empty())
+					return CL_INVALID_KERNEL_ARGS;
+
+				clResult = fusedNode->setArg(fusedArgIdx++, record.size, record.value.data());
+				if (clResult != CL_SUCCESS)
+					return clResult;
+			}
+		}
+
+		cl_uint elementCount = static_cast<cl_uint>(globalworksize);
+		return fusedNode->setArg(fusedArgIdx, sizeof(cl_uint), &elementCount);
+	}
+
+	void ExecutionManager::pAddShardReplicas(size_t execNodeKEY, compute::DispatchDescription const& dispatchDesc)
+	{
+		ExecutionNode* node = p_execGraph->getNode(execNodeKEY);
+
+		// shards are 1D ranges, a 2D/3D __attribute__ workgroup can't be split by offsets
+		std::array<uint64_t, 3> compileWorkGroupSize;
+		if (node->hasCompileWorkGroup(compileWorkGroupSize.data()) && (compileWorkGroupSize[1] > 1 || compileWorkGroupSize[2] > 1))
+		{
+			std::string _logInfo_ = LOG_HEADER() + " DISPATCH NOT SHARDED (multi dimensional kernel workgroup): " + dispatchDesc.getTag();
+			getManager()->LOG_MESSAGE(_logInfo_);
+			return;
+		}
+
+		ShardSet shardSet;
+		for (auto &pDevice : getManager()->getDevicePool())
+		{
+			if (pDevice.get() == node->getDevice() || !pDevice->hasProgram(dispatchDesc.getKernelNamespace()))
+				continue;
+
+			if (!pDevice->getProgram(dispatchDesc.getKernelNamespace())->hasKernel(dispatchDesc.getKernelName()))
+				continue;
+
+			shardSet.replicas.push_back(std::make_shared<ExecutionNode>(pDevice.get(), dispatchDesc.getKernelName(), dispatchDesc.getKernelNamespace()));
+			if (getManager()->getProfiler())
+				shardSet.replicas.back()->setProfiler(getManager()->getProfiler(), dispatchDesc.getTag() + " [SHARD " + std::to_string(pDevice->GetId()) + "]");
+		}
+
+		if (!shardSet.replicas.size())
+		{
+			std::string _logInfo_ = LOG_HEADER() + " DISPATCH NOT SHARDED (single device): " + dispatchDesc.getTag();
+			getManager()->LOG_MESSAGE(_logInfo_);
+			return;
+		}
+
+		shardSet.balancer = ShardBalancer(shardSet.replicas.size() + 1);
+		p_shardSets[execNodeKEY] = shardSet;
+	}
+
+	uint64_t ExecutionManager::pGetShardLocalSize(ExecutionNode* node) const
+	{
+		std::array<uint64_t, 3> compileWorkGroupSize;
+		if (node->hasCompileWorkGroup(compileWorkGroupSize.data()))
+			return compileWorkGroupSize[0];
+
+		uint64_t localLimit = node->getDevice()->getProfile() == DeviceProfile::eGeneral ? COMPUTE_CPU_MAX_LOCAL_SIZE : COMPUTE_SHARD_MAX_LOCAL_SIZE;
+		uint64_t maxLocalSize = std::max<uint64_t>(std::min<uint64_t>(node->getKernelWorkGroupSize(), localLimit), 1);
+		uint64_t localSize = std::min<uint64_t>(std::max<uint64_t>(node->getKernelPreferredWorkGroupMultiple(), 1), maxLocalSize);
+		while (localSize * 2 <= maxLocalSize)
+		{
+			localSize *= 2;
+		}
+
+		return localSize;
+	}
+
+	Buffer* ExecutionManager::pGetBufferReplica(size_t bufKEY, Device* device)
+	{
+		auto replicaKEY = std::make_pair(bufKEY, device->GetId());
+		auto pReplica = p_bufferReplicas.find(replicaKEY);
+		if (pReplica != p_bufferReplicas.end())
+			return pReplica->second.get();
+
+		BufferHandle replica = std::make_shared< Buffer >(device);
+		if (getManager()->getResourceManager()->allocateBuffer(replica.get(), p_bufferDescs.at(bufKEY)) != CL_SUCCESS)
+			return nullptr;
+
+		p_bufferReplicas[replicaKEY] = replica;
+		return replica.get();
+	}
+
 	template<>
 	cl_int ExecutionManager::pDispatch<DeviceProfile::eGPGPU, WorkItemDistribution::eIncremental>
-		(ExecutionNode* node, compute::DispatchPayload const& payload)
+		(ExecutionNode* node, compute::DispatchPayload const& payload, DispatchSync* sync)
 	{
 		cl_int clResult = CL_SUCCESS;
 
@@ -166,8 +635,8 @@ namespace opencl
 
 				// return CL_INVALID_GLOBAL_WORK_SIZE;
 
-				// add idle padding.
-				globalworksize += globalworksize % localWorkitems;
+				// add idle padding, round up to the next multiple of the work-group.
+				globalworksize = ((globalworksize + localWorkitems - 1) / localWorkitems) * localWorkitems;
 			}
 
 			/* Distribute the work globally. For this no need for local distribution as local distribution is imposed by the __kernel using __attribute__ */
@@ -176,7 +645,7 @@ namespace opencl
 			DISTRIBUTE_WORKITEMS<WorkItemDistribution::eIncremental>
 				(
 					3,
-					payload.globalworksize,
+					globalworksize,
 					compileWorkGroupSize.data(),
 					globalWorkgroupLimit.data(),
 					globalWorkDist.data()
@@ -184,31 +653,25 @@ namespace opencl
 			cl::NDRange local(compileWorkGroupSize[0], compileWorkGroupSize[1], compileWorkGroupSize[2]);
 			cl::NDRange global(globalWorkDist[0], globalWorkDist[1], globalWorkDist[2]);
 
-			return node->dispatch(offset, global, local);
+			return node->dispatch(offset, global, local, sync);
 		}
 		else
 		{
 			/* set dimensions and max work size per dimension */
-			cl_uint maxDimensions = node->getDevice()->getLogicalDevice().getInfo<CL_DEVICE_MAX_WORK_ITEM_DIMENSIONS>();
-			std::vector<uint64_t> localWorkgroupLimit;
-			localWorkgroupLimit.resize(maxDimensions);
-			localWorkgroupLimit = node->getDevice()->getLogicalDevice().getInfo<CL_DEVICE_MAX_WORK_ITEM_SIZES>();
-			if (maxDimensions > 3)
-			{
-				maxDimensions = 3;
-				localWorkgroupLimit.resize(maxDimensions);
-			}
+			DeviceLimits const& deviceLimits = node->getDevice()->getLimits();
+			cl_uint maxDimensions = deviceLimits.maxWorkItemDimensions;
+			std::array<uint64_t, 3> localWorkgroupLimit = deviceLimits.maxWorkItemSizes;
 
 			/* set warp and local work size */
-			uint64_t maxWorkGroupSizeDEVICE = node->getDevice()->getLogicalDevice().getInfo<CL_DEVICE_MAX_WORK_GROUP_SIZE>();
+			uint64_t maxWorkGroupSizeDEVICE = deviceLimits.maxWorkGroupSize;
 			uint64_t maxWorkGroupSizeKERNEL = node->getKernelWorkGroupSize(); // maxWorkGroupSizeKERNEL will always be less than maxWorkGroupSizeDEVICE
 			uint64_t prefWorkGroupMultipleKERNEL = node->getKernelPreferredWorkGroupMultiple();
 
 			if (globalworksize % prefWorkGroupMultipleKERNEL)
 			{
 				// return CL_INVALID_GLOBAL_WORK_SIZE;
-				// add idle padding.
-				globalworksize += globalworksize % prefWorkGroupMultipleKERNEL;
+				// add idle padding, round up to the next multiple of the work-group.
+				globalworksize = ((globalworksize + prefWorkGroupMultipleKERNEL - 1) / prefWorkGroupMultipleKERNEL) * prefWorkGroupMultipleKERNEL;
 			}
 
 			/* distribute local work size */
@@ -228,7 +691,7 @@ namespace opencl
 			DISTRIBUTE_WORKITEMS<WorkItemDistribution::eIncremental>
 				(
 					maxDimensions,
-					payload.globalworksize,
+					globalworksize,
 					localWorkDist.data(),
 					globalWorkgroupLimit.data(),
 					globalWorkDist.data()
@@ -236,16 +699,53 @@ namespace opencl
 			cl::NDRange local(localWorkDist[0], localWorkDist[1], localWorkDist[2]);
 			cl::NDRange global(globalWorkDist[0], globalWorkDist[1], globalWorkDist[2]);
 
-			return node->dispatch(offset, global, local);
+			return node->dispatch(offset, global, local, sync);
 		}
 
 		return clResult;
 	}
 
 	template<>
-	cl_int ExecutionManager::pDispatch<DeviceProfile::eGeneral, WorkItemDistribution::eIncremental>(ExecutionNode* node, compute::DispatchPayload const& payload)
+	cl_int ExecutionManager::pDispatch<DeviceProfile::eGeneral, WorkItemDistribution::eIncremental>
+		(ExecutionNode* node, compute::DispatchPayload const& payload, DispatchSync* sync)
 	{
-		return CL_SUCCESS;
+		/*
+		*-------------------------------
+		* CPU runtimes run a work-group on a single hardware thread and vectorize the work-items
+		* across the SIMD lanes (CL_KERNEL_PREFERRED_WORK_GROUP_SIZE_MULTIPLE reports the vector width).
+		*-------------------------------
+		* 1. single dimension - consecutive work-items touch consecutive cache lines.
+		* 2. local size is a multiple of the SIMD width, grown only while every compute unit
+		*    still gets COMPUTE_CPU_GROUPS_PER_UNIT groups and capped by COMPUTE_CPU_MAX_LOCAL_SIZE.
+		* 3. global size is padded to the local size, __kernels should return for global_id >= globalworksize.
+		*-------------------------------
+		*/
+		if (!payload.globalworksize)
+			return CL_INVALID_GLOBAL_WORK_SIZE;
+
+		/* __kernel imposes the workgroup using __attribute__, the generic distribution already honors it */
+		if (node->hasCompileWorkGroup())
+			return pDispatch<DeviceProfile::eGPGPU, WorkItemDistribution::eIncremental>(node, payload, sync);
+
+		uint64_t simdWidth = std::max<uint64_t>(node->getKernelPreferredWorkGroupMultiple(), 1);
+		uint64_t maxLocalSize = std::min<uint64_t>(node->getKernelWorkGroupSize(), COMPUTE_CPU_MAX_LOCAL_SIZE);
+		if (maxLocalSize < simdWidth)
+			simdWidth = std::max<uint64_t>(maxLocalSize, 1);
+
+		uint64_t targetGroups = node->getDevice()->getLimits().computeUnits * COMPUTE_CPU_GROUPS_PER_UNIT;
+
+		uint64_t localWorkSize = simdWidth;
+		while ((localWorkSize * 2 <= maxLocalSize) && (payload.globalworksize / (localWorkSize * 2) >= targetGroups))
+		{
+			localWorkSize *= 2;
+		}
+
+		uint64_t globalworksize = ((payload.globalworksize + localWorkSize - 1) / localWorkSize) * localWorkSize;
+
+		cl::NDRange local(localWorkSize);
+		cl::NDRange global(globalworksize);
+
+		return node->dispatch(cl::NullRange, global, local, sync);
 	}
 
 
@@ -253,16 +753,34 @@ namespace opencl
 	/*
 	* This has to be at the end after the pDispatch explicit specializations.
 	*/
-	cl_int ExecutionManager::dispatch(compute::DispatchPayload const& payload)
+	cl_int ExecutionManager::pDispatchNode(ExecutionNode* node, compute::DispatchPayload const& payload, DispatchSync* sync)
+	{
+		if (node->getIsAutotuned())
+		{
+			TunedShape shape;
+			cl_int clResult = pGetTunedShape(node, payload, sync, shape);
+			if (clResult != CL_SUCCESS)
+				return clResult;
+
+			if (shape.dims == 1)
+				return pDispatchShape(node, payload, shape, sync);
+		}
+
+		return pDispatchDefault(node, payload, sync);
+	}
+
+	cl_int ExecutionManager::pDispatchDefault(ExecutionNode* node, compute::DispatchPayload const& payload, DispatchSync* sync)
 	{
 		cl_int clResult = CL_SUCCESS;
 
-		size_t execNodeKEY = GET_EXECNODEKEY(payload.tag);
-		ExecutionNode* node = p_execNodes[execNodeKEY].get(); // for now single __kernel
 		switch (node->getDevice()->getProfile())
 		{
 		case DeviceProfile::eGPGPU:
-			clResult = pDispatch<DeviceProfile::eGPGPU, WorkItemDistribution::eIncremental>(node, payload);
+			clResult = pDispatch<DeviceProfile::eGPGPU, WorkItemDistribution::eIncremental>(node, payload, sync);
+			break;
+		case DeviceProfile::eGeneral:
+			clResult = pDispatch<DeviceProfile::eGeneral, WorkItemDistribution::eIncremental>(node, payload, sync);
+			break;
 		default:
 			assert(0);
 		}
@@ -270,6 +788,766 @@ namespace opencl
 		return clResult;
 	}
 
+	cl_int ExecutionManager::pDispatchShape(ExecutionNode* node, compute::DispatchPayload const& payload, TunedShape const& shape, DispatchSync* sync)
+	{
+		if (!payload.globalworksize || !shape.local)
+			return CL_INVALID_GLOBAL_WORK_SIZE;
+
+		uint64_t globalworksize = ((payload.globalworksize + shape.local - 1) / shape.local) * shape.local;
+
+		cl::NDRange local(shape.local);
+		cl::NDRange global(globalworksize);
+
+		return node->dispatch(cl::NullRange, global, local, sync);
+	}
+
+	cl_int ExecutionManager::pGetTunedShape(ExecutionNode* node, compute::DispatchPayload const& payload, DispatchSync* sync, TunedShape& shape)
+	{
+		uint32_t bucket = TuningDatabase::getBucket(payload.globalworksize);
+		if (node->findTunedShape(bucket, shape))
+			return CL_SUCCESS;
+
+		TuningDatabase* tuningDb = getManager()->getTuningDatabase();
+		uint64_t sourceHash = node->getDevice()->getProgram(node->getKernelNamespace())->getSourceHash();
+		uint64_t tuningKEY = TuningDatabase::getKey(node->getKernelNamespace(), node->getKernelName(), sourceHash, node->getDevice()->getLogicalDevice(), bucket);
+
+		// a stored local size has to be valid for the kernel as built now (e.g. entries of a database edited by hand)
+		bool isStored = tuningDb->find(tuningKEY, shape);
+		if (isStored && shape.dims && (shape.local > node->getKernelWorkGroupSize() || node->hasCompileWorkGroup()))
+		{
+			std::string _logInfo_ = "AUTOTUNED SHAPE REJECTED: " + node->getKernelNamespace() + "::" + node->getKernelName()
+				+ " BUCKET: " + std::to_string(bucket)
+				+ " LOCAL: " + std::to_string(shape.local);
+			getManager()->LOG_MESSAGE(_logInfo_);
+			isStored = false;
+		}
+
+		if (!isStored)
+		{
+			cl_int clResult = pTuneNode(node, payload, sync, shape);
+			if (clResult != CL_SUCCESS)
+				return clResult;
+
+			tuningDb->store(tuningKEY, shape);
+
+			std::string _logInfo_ = "AUTOTUNED: " + node->getKernelNamespace() + "::" + node->getKernelName()
+				+ " BUCKET: " + std::to_string(bucket)
+				+ " LOCAL: " + (shape.dims ? std::to_string(shape.local) : std::string("DEFAULT"))
+				+ " MS: " + std::to_string(shape.milliseconds);
+			getManager()->LOG_MESSAGE(_logInfo_);
+		}
+
+		node->setTunedShape(bucket, shape);
+		return CL_SUCCESS;
+	}
+
+	cl_int ExecutionManager::pTuneNode(ExecutionNode* node, compute::DispatchPayload const& payload, DispatchSync* sync, TunedShape& shape)
+	{
+		/*
+		*-------------------------------
+		* candidates - the default distribution of the device profile (dims 0) and 1D local sizes
+		* from the preferred multiple doubling up to the kernel / device limit.
+		* every candidate runs once to warm up and COMPUTE_TUNING_REPETITIONS times timed (CL_PROFILING_COMMAND_START:END),
+		* the fastest run counts so a preempted run doesn't penalize a candidate.
+		*-------------------------------
+		*/
+		Device* device = node->getDevice();
+		cl::CommandQueue& profilingQueue = pGetProfilingQueue(device);
+
+		// the wait events could belong to commands not yet flushed on the compute queue
+		device->getCmdQueue(QueueType::eCompute).flush();
+
+		std::vector< TunedShape > candidates;
+		candidates.push_back(TunedShape{ 0, 0, 0.0 });
+
+		/* __kernel imposes the workgroup using __attribute__, nothing to search */
+		if (!node->hasCompileWorkGroup())
+		{
+			uint64_t maxLocalSize = std::min<uint64_t>(node->getKernelWorkGroupSize(), device->getLimits().maxWorkItemSizes[0]);
+			uint64_t localWorkSize = std::max<uint64_t>(node->getKernelPreferredWorkGroupMultiple(), 1);
+			for (; localWorkSize <= maxLocalSize; localWorkSize *= 2)
+			{
+				candidates.push_back(TunedShape{ 1, localWorkSize, 0.0 });
+				if (localWorkSize >= payload.globalworksize)
+					break;
+			}
+		}
+
+		bool tuned = false;
+		for (auto &pCandidate : candidates)
+		{
+			double bestMs = 0.0;
+			bool valid = true;
+			for (int run = 0; run <= COMPUTE_TUNING_REPETITIONS && valid; ++run)
+			{
+				cl::Event dispatchEvent;
+				DispatchSync tuningSync;
+				if (sync)
+					tuningSync.waitEvents = sync->waitEvents;
+				tuningSync.event = &dispatchEvent;
+				tuningSync.cmdQueue = &profilingQueue;
+
+				cl_int clResult = pCandidate.dims ? pDispatchShape(node, payload, pCandidate, &tuningSync) : pDispatchDefault(node, payload, &tuningSync);
+				if (clResult == CL_SUCCESS)
+					clResult = dispatchEvent.wait();
+
+				// a candidate the runtime rejects (e.g. CL_OUT_OF_RESOURCES for the local size) is skipped
+				if (clResult != CL_SUCCESS)
+				{
+					valid = false;
+					break;
+				}
+
+				// run 0 warms up
+				if (!run)
+					continue;
+
+				cl_ulong start = dispatchEvent.getProfilingInfo<CL_PROFILING_COMMAND_START>();
+				cl_ulong end = dispatchEvent.getProfilingInfo<CL_PROFILING_COMMAND_END>();
+				double ms = static_cast<double>(end - start) * 1e-6;
+				if (run == 1 || ms < bestMs)
+					bestMs = ms;
+			}
+
+			if (!valid)
+				continue;
+
+			pCandidate.milliseconds = bestMs;
+			if (!tuned || bestMs < shape.milliseconds)
+			{
+				shape = pCandidate;
+				tuned = true;
+			}
+		}
+
+		return tuned ? CL_SUCCESS : CL_INVALID_WORK_GROUP_SIZE;
+	}
+
+	cl::CommandQueue& ExecutionManager::pGetProfilingQueue(Device* device)
+	{
+		auto pQueue = p_profilingQueues.find(device->GetId());
+		if (pQueue != p_profilingQueues.end())
+			return pQueue->second;
+
+		cl::CommandQueue& cmdQueue = p_profilingQueues[device->GetId()];
+		cmdQueue = cl::CommandQueue(device->getContext(), device->getLogicalDevice(), CL_QUEUE_PROFILING_ENABLE);
+		return cmdQueue;
+	}
+
+	/* shard completion time, set from the runtime callback thread */
+	struct ShardCompletion
+	{
+		std::chrono::steady_clock::time_point	time;
+		std::atomic<size_t>*					pending;
+	};
+
+	static void CL_CALLBACK SHARD_COMPLETE_CALLBACK(cl_event, cl_int, void* data)
+	{
+		ShardCompletion* completion = reinterpret_cast<ShardCompletion*>(data);
+		completion->time = std::chrono::steady_clock::now();
+		--(*completion->pending);
+	}
+
+	cl_int ExecutionManager::pDispatchSharded(ExecutionNode* node, ShardSet& shardSet, compute::DispatchPayload const& payload)
+	{
+		/*
+		*-------------------------------
+		* 1. split the global work by the measured throughput, shard boundaries are multiples of every shard local size.
+		* 2. scatter - the unit slice of each bound buffer of a shard is staged through the host to the buffer replica.
+		* 3. dispatch every shard with its work offset, the replicas replay the recorded args of the node.
+		* 4. gather - the slices are staged back into the primary buffers.
+		* The primary shard works in place on the primary buffers.
+		*-------------------------------
+		*/
+		using clock = std::chrono::steady_clock;
+
+		cl_int clResult = CL_SUCCESS;
+		if (!payload.globalworksize)
+			return CL_INVALID_GLOBAL_WORK_SIZE;
+
+		std::vector< ExecutionNode* > shardNodes(1, node);
+		for (auto &pReplica : shardSet.replicas)
+		{
+			shardNodes.push_back(pReplica.get());
+		}
+
+		std::vector< uint64_t > localSizes(shardNodes.size());
+		uint64_t granularity = 1;
+		for (size_t shardIdx = 0; shardIdx < shardNodes.size(); ++shardIdx)
+		{
+			localSizes[shardIdx] = pGetShardLocalSize(shardNodes[shardIdx]);
+			granularity = GET_LCM(granularity, localSizes[shardIdx]);
+		}
+
+		std::vector< uint64_t > shardSizes;
+		shardSet.balancer.split(payload.globalworksize, granularity, shardSizes);
+
+		struct ShardSlice
+		{
+			Buffer*							primary;
+			Buffer*							replica;
+			size_t							offset;
+			size_t							size;
+			std::vector< unsigned char >	staging;	/* lives till the end of the dispatch (non-blocking transfers) */
+			bool							isRead;		/* read-only arg, scattered but not gathered */
+			cl::Event						gatherEvent;
+		};
+		// a buffer arg could yield several slices per shard, a deque keeps the slices in place while the
+		// non-blocking transfers of the earlier ones are in flight
+		std::deque< ShardSlice > slices;
+		std::vector< std::pair<size_t, size_t> > unitRanges;
+
+		std::atomic<size_t> pendingCompletions{ 0 };
+		std::vector< ShardCompletion > completions(shardNodes.size());
+		std::vector< clock::time_point > submitTimes(shardNodes.size());
+		std::vector< cl::Event > completeEvents(shardNodes.size());
+
+		std::vector< uint64_t > shardBegins(shardNodes.size(), 0);
+		for (size_t shardIdx = 1; shardIdx < shardNodes.size(); ++shardIdx)
+		{
+			shardBegins[shardIdx] = shardBegins[shardIdx - 1] + shardSizes[shardIdx - 1];
+		}
+
+		// replicas first, the scatter reads the primary buffers before the primary shard writes them
+		auto const& argRecords = node->getArgRecords();
+		for (size_t step = 1; step <= shardNodes.size(); ++step)
+		{
+			size_t shardIdx = step % shardNodes.size();
+			uint64_t shardBegin = shardBegins[shardIdx];
+			uint64_t shardSize = shardSizes[shardIdx];
+			if (!shardSize)
+				continue;
+
+			ExecutionNode* shardNode = shardNodes[shardIdx];
+			Device* device = shardNode->getDevice();
+			size_t firstSlice = slices.size();
+			submitTimes[shardIdx] = clock::now();
+
+			// replay the args on the replica, scatter the buffer slices
+			for (cl_uint argIdx = 0; shardIdx && argIdx < argRecords.size(); ++argIdx)
+			{
+				auto const& record = argRecords[argIdx];
+				if (!record.isBuffer)
+				{
+					if (record.size)
+						clResult = shardNode->setArg(argIdx, record.size, record.value.size() ? record.value.data() : nullptr);
+					continue;
+				}
+
+				Buffer* primary = getBuffer(record.resourceKEY);
+				Buffer* replica = pGetBufferReplica(record.resourceKEY, device);
+				if (!replica)
+				{
+					clResult = CL_MEM_OBJECT_ALLOCATION_FAILURE;
+					break;
+				}
+
+				cl_mem memPtr = replica->getResource()();
+				shardNode->bindResource(argIdx, replica);
+				clResult = shardNode->setArg(argIdx, sizeof(cl_mem), &memPtr);
+				shardNode->recordResourceArg(argIdx, device::ResourceType::eBuffer, record.resourceKEY);
+
+				uint64_t unitCount = primary->getMaxUnitCount();
+				uint64_t beginUnit = std::min<uint64_t>(shardBegin, unitCount);
+				uint64_t endUnit = std::min<uint64_t>(shardBegin + shardSize, unitCount);
+				if (endUnit == beginUnit)
+					continue;
+
+				// a slice per attribute stream of the SoA buffers
+				primary->getDataLayout().getUnitRanges(static_cast<size_t>(beginUnit), static_cast<size_t>(endUnit), primary->getMaxUnitCount(), unitRanges);
+				for (auto &pRange : unitRanges)
+				{
+					slices.push_back(ShardSlice{ primary, replica, pRange.first, pRange.second, {}, node->getArgAccess(argIdx) == ResourceAccess::eRead });
+					ShardSlice& slice = slices.back();
+					slice.staging.resize(slice.size);
+
+					clResult = getManager()->getResourceManager()->readBuffer(primary, slice.staging.data(), slice.size, slice.offset, true);
+					if (clResult == CL_SUCCESS)
+						clResult = getManager()->getResourceManager()->writeBuffer(replica, slice.staging.data(), slice.size, slice.offset, false);
+					if (clResult != CL_SUCCESS)
+						break;
+				}
+
+				if (clResult != CL_SUCCESS)
+					break;
+			}
+
+			if (clResult != CL_SUCCESS)
+				break;
+
+			// the last shard is padded to its local size, __kernels should return for global_id >= globalworksize
+			uint64_t localSize = localSizes[shardIdx];
+			uint64_t globalSize = ((shardSize + localSize - 1) / localSize) * localSize;
+
+			DispatchSync sync;
+			sync.event = &completeEvents[shardIdx];
+			clResult = shardNode->dispatch(cl::NDRange(shardBegin), cl::NDRange(globalSize), cl::NDRange(localSize), &sync);
+			if (clResult != CL_SUCCESS)
+				break;
+
+			device->getCmdQueue(QueueType::eCompute).flush();
+
+			// gather on the in-order transfer queue, the last read completes the shard (the replica of a read-only arg is unchanged)
+			for (size_t sliceIdx = firstSlice; sliceIdx < slices.size(); ++sliceIdx)
+			{
+				ShardSlice& slice = slices[sliceIdx];
+				if (slice.isRead)
+					continue;
+
+				clResult = getManager()->getResourceManager()->readBuffer(slice.replica, slice.staging.data(), slice.size, slice.offset, false, &slice.gatherEvent);
+				if (clResult != CL_SUCCESS)
+					break;
+
+				completeEvents[shardIdx] = slice.gatherEvent;
+			}
+
+			if (clResult != CL_SUCCESS)
+				break;
+
+			completions[shardIdx].pending = &pendingCompletions;
+			++pendingCompletions;
+			if (completeEvents[shardIdx].setCallback(CL_COMPLETE, SHARD_COMPLETE_CALLBACK, &completions[shardIdx]) != CL_SUCCESS)
+			{
+				--pendingCompletions;
+				completions[shardIdx].pending = nullptr;
+			}
+		}
+
+		// everything enqueued has to complete before the staging memory goes out of scope
+		for (auto &pEvent : completeEvents)
+		{
+			if (pEvent())
+				pEvent.wait();
+		}
+
+		for (auto &pSlice : slices)
+		{
+			if (clResult != CL_SUCCESS)
+				break;
+
+			if (pSlice.gatherEvent())
+				clResult = getManager()->getResourceManager()->writeBuffer(pSlice.primary, pSlice.staging.data(), pSlice.size, pSlice.offset, true);
+		}
+
+		// callbacks run right after the event completes
+		while (pendingCompletions.load())
+		{
+			std::this_thread::yield();
+		}
+
+		if (clResult != CL_SUCCESS)
+		{
+			std::string _logInfo_ = LOG_HEADER() + " SHARDED DISPATCH FAILED: " + payload.tag;
+			getManager()->LOG_ERROR(_logInfo_);
+			return clResult;
+		}
+
+		for (size_t shardIdx = 0; shardIdx < shardNodes.size(); ++shardIdx)
+		{
+			if (shardSizes[shardIdx] && completions[shardIdx].pending)
+			{
+				double milliseconds = std::chrono::duration<double, std::milli>(completions[shardIdx].time - submitTimes[shardIdx]).count();
+				shardSet.balancer.record(shardIdx, shardSizes[shardIdx], milliseconds);
+			}
+		}
+
+		return clResult;
+	}
+
+	cl_int ExecutionManager::addBuffer(compute::BufferDescription const& bufDesc)
+	{
+		size_t bufKEY = GET_RESOURCEKEY<device::ResourceType::eBuffer>(bufDesc.getTag());
+		if (p_buffers.count(bufKEY))
+		{
+			std::string _logInfo_ = LOG_HEADER() + " BUFFER ALREADY EXISTS: " + bufDesc.getTag();
+			getManager()->LOG_ERROR(_logInfo_);
+			return CL_INVALID_VALUE;
+		}
+
+		return pAddBufferResource(bufDesc);
+	}
+
+	cl_int ExecutionManager::removeBuffer(std::string const& tag)
+	{
+		size_t bufKEY = GET_RESOURCEKEY<device::ResourceType::eBuffer>(tag);
+		auto pBuffer = p_buffers.find(bufKEY);
+		if (pBuffer == p_buffers.end())
+			return CL_INVALID_VALUE;
+
+		if (pIsResourceBound(pBuffer->second.get()))
+		{
+			std::string _logInfo_ = LOG_HEADER() + " BUFFER STILL BOUND TO A KERNEL ARG: " + tag;
+			getManager()->LOG_ERROR(_logInfo_);
+			return CL_INVALID_OPERATION;
+		}
+
+		DataSlot* dataslot = reinterpret_cast<DataSlot*>(p_appComputePipeline->getDataIO()->getImpl());
+		uint32_t bufferId = dataslot->removeSlot<device::ResourceType::eBuffer>(bufKEY);
+		if (bufferId < p_bufferTable.size())
+			p_bufferTable[bufferId] = std::pair<size_t, Buffer*>();
+
+		for (auto pReplica = p_bufferReplicas.begin(); pReplica != p_bufferReplicas.end();)
+		{
+			if (pReplica->first.first == bufKEY)
+				pReplica = p_bufferReplicas.erase(pReplica);
+			else
+				++pReplica;
+		}
+
+		// pooled memory returns to the pool after the pending commands on the buffer complete
+		p_bufferDescs.erase(bufKEY);
+		p_buffers.erase(pBuffer);
+
+		return CL_SUCCESS;
+	}
+
+	cl_int ExecutionManager::addImage(compute::ImageDescription const& imgDesc)
+	{
+		size_t imgKEY = GET_RESOURCEKEY<device::ResourceType::eImage>(imgDesc.getTag());
+		if (p_images.count(imgKEY))
+		{
+			std::string _logInfo_ = LOG_HEADER() + " IMAGE ALREADY EXISTS: " + imgDesc.getTag();
+			getManager()->LOG_ERROR(_logInfo_);
+			return CL_INVALID_VALUE;
+		}
+
+		return pAddImageResource(imgDesc);
+	}
+
+	cl_int ExecutionManager::removeImage(std::string const& tag)
+	{
+		size_t imgKEY = GET_RESOURCEKEY<device::ResourceType::eImage>(tag);
+		auto pImage = p_images.find(imgKEY);
+		if (pImage == p_images.end())
+			return CL_INVALID_VALUE;
+
+		if (pIsResourceBound(pImage->second.get()))
+		{
+			std::string _logInfo_ = LOG_HEADER() + " IMAGE STILL BOUND TO A KERNEL ARG: " + tag;
+			getManager()->LOG_ERROR(_logInfo_);
+			return CL_INVALID_OPERATION;
+		}
+
+		DataSlot* dataslot = reinterpret_cast<DataSlot*>(p_appComputePipeline->getDataIO()->getImpl());
+		uint32_t imageId = dataslot->removeSlot<device::ResourceType::eImage>(imgKEY);
+		if (imageId < p_imageTable.size())
+			p_imageTable[imageId] = std::pair<size_t, Image*>();
+
+		p_images.erase(pImage);
+
+		return CL_SUCCESS;
+	}
+
+	cl_int ExecutionManager::addDispatch(compute::DispatchDescription const& dispatchDesc)
+	{
+		size_t execNodeKEY = GET_EXECNODEKEY(dispatchDesc.getTag());
+		if (p_execGraph->hasNode(execNodeKEY))
+		{
+			std::string _logInfo_ = LOG_HEADER() + " DISPATCH ALREADY EXISTS: " + dispatchDesc.getTag();
+			getManager()->LOG_ERROR(_logInfo_);
+			return CL_INVALID_VALUE;
+		}
+
+		cl_int clResult = getManager()->waitKernels(dispatchDesc.getKernelNamespace());
+		if (clResult != CL_SUCCESS)
+			return clResult;
+
+		clResult = pAddExecutionNodes(dispatchDesc);
+		if (clResult != CL_SUCCESS)
+			return clResult;
+
+		clResult = pAddDependencies(dispatchDesc);
+
+		// dispatches described earlier could depend on this one
+		for (auto &pDesc : p_appComputePipeline->getDispatchDescriptions())
+		{
+			size_t downstreamKEY = GET_EXECNODEKEY(pDesc.getTag());
+			if (downstreamKEY == execNodeKEY || !p_execGraph->hasNode(downstreamKEY))
+				continue;
+
+			for (auto &pDependency : pDesc.getDependencies())
+			{
+				if (GET_EXECNODEKEY(pDependency.getTag()) == execNodeKEY)
+					p_execGraph->addEdge(execNodeKEY, downstreamKEY);
+			}
+		}
+
+		if (!p_execGraph->validate())
+		{
+			std::string _logInfo_ = LOG_HEADER() + " DISPATCH CREATES A CYCLE: " + dispatchDesc.getTag();
+			getManager()->LOG_ERROR(_logInfo_);
+			removeDispatch(dispatchDesc.getTag());
+			return CL_INVALID_VALUE;
+		}
+
+		// chains are fused at init only, a chain linked to the new dispatch runs unfused
+		auto const& vertex = p_execGraph->getVertices().at(execNodeKEY);
+		std::vector< size_t > linkedKEYs(vertex.upstream);
+		linkedKEYs.insert(linkedKEYs.end(), vertex.downstream.begin(), vertex.downstream.end());
+		for (auto linkedKEY : linkedKEYs)
+		{
+			auto pFused = p_fusedStageOf.find(linkedKEY);
+			if (pFused != p_fusedStageOf.end())
+				pRemoveFusedChain(pFused->second);
+		}
+
+		return clResult;
+	}
+
+	cl_int ExecutionManager::removeDispatch(std::string const& tag)
+	{
+		size_t execNodeKEY = GET_EXECNODEKEY(tag);
+		if (!p_execGraph->hasNode(execNodeKEY) || p_fusedChains.count(execNodeKEY))
+			return CL_INVALID_VALUE;
+
+		auto pFused = p_fusedStageOf.find(execNodeKEY);
+		if (pFused != p_fusedStageOf.end())
+			pRemoveFusedChain(pFused->second);
+
+		// in flight dispatches hold their own reference to the cl kernel
+		ExecutionNode* node = p_execGraph->getNode(execNodeKEY);
+		DispatchSlot* dispatchSlot = reinterpret_cast<DispatchSlot*>(p_appComputePipeline->getDispatchIO()->getImpl());
+		dispatchSlot->removeKernelIO(GET_KERNELKEY(node->getKernelName(), node->getKernelNamespace()), execNodeKEY);
+
+		p_shardSets.erase(execNodeKEY);
+		p_execGraph->removeNode(execNodeKEY);
+
+		return CL_SUCCESS;
+	}
+
+	bool ExecutionManager::pIsResourceBound(ResourceSync const* resource) const
+	{
+		for (auto &pVertex : p_execGraph->getVertices())
+		{
+			// fused nodes rebind from the stage args on every dispatch
+			if (p_fusedChains.count(pVertex.first))
+				continue;
+
+			if (pVertex.second.node->isResourceBound(resource))
+				return true;
+		}
+
+		return false;
+	}
+
+	cl_int ExecutionManager::dispatch(compute::DispatchPayload const& payload)
+	{
+		size_t execNodeKEY = GET_EXECNODEKEY(payload.tag);
+		if (!p_execGraph->hasNode(execNodeKEY))
+		{
+			std::string _logInfo_ = LOG_HEADER() + " DISPATCH UNKNOWN TAG: " + payload.tag;
+			getManager()->LOG_ERROR(_logInfo_);
+			return CL_INVALID_VALUE;
+		}
+
+		ExecutionNode* node = p_execGraph->getNode(execNodeKEY);
+
+		auto pShardSet = p_shardSets.find(execNodeKEY);
+		if (pShardSet != p_shardSets.end() && !node->hasUnshardableArgs())
+			return pDispatchSharded(node, pShardSet->second, payload);
+
+		cl_int clResult = pDispatchNode(node, payload);
+
+		/* transfers could wait on this dispatch, so it has to reach the device */
+		node->getDevice()->getCmdQueue(QueueType::eCompute).flush();
+
+		return clResult;
+	}
+
+	cl_int ExecutionManager::dispatchBatch(compute::DispatchPayload const* payloads, size_t count, bool fuseElementwise)
+	{
+		cl_int clResult = CL_SUCCESS;
+
+		// consecutive stages of a fused chain run as the fused dispatch (opt-in)
+		std::vector< compute::DispatchPayload > fusedPayloads;
+		if (fuseElementwise && pFusePayloads(payloads, count, true, fusedPayloads))
+		{
+			payloads = fusedPayloads.data();
+			count = fusedPayloads.size();
+		}
+
+		struct BatchEntry
+		{
+			ExecutionNode*	node{ nullptr };
+			ShardSet*		shardSet{ nullptr };
+		};
+
+		// resolve all the nodes first, an unknown tag fails the batch before anything is enqueued
+		std::vector< BatchEntry > entries(count);
+		for (size_t idx = 0; idx < count; ++idx)
+		{
+			size_t execNodeKEY = GET_EXECNODEKEY(payloads[idx].tag);
+			if (!p_execGraph->hasNode(execNodeKEY))
+			{
+				std::string _logInfo_ = LOG_HEADER() + " BATCH DISPATCH UNKNOWN TAG: " + payloads[idx].tag;
+				getManager()->LOG_ERROR(_logInfo_);
+				return CL_INVALID_VALUE;
+			}
+
+			entries[idx].node = p_execGraph->getNode(execNodeKEY);
+
+			auto pShardSet = p_shardSets.find(execNodeKEY);
+			if (pShardSet != p_shardSets.end() && !entries[idx].node->hasUnshardableArgs())
+				entries[idx].shardSet = &pShardSet->second;
+		}
+
+		// devices with dispatches not yet flushed
+		std::vector< Device* > devices;
+		auto flushDevices = [&devices]()
+		{
+			for (auto pDevice : devices)
+			{
+				pDevice->getCmdQueue(QueueType::eCompute).flush();
+			}
+			devices.clear();
+		};
+
+		for (size_t idx = 0; idx < count; ++idx)
+		{
+			ExecutionNode* node = entries[idx].node;
+			if (entries[idx].shardSet)
+			{
+				// blocking, the scatter reads could wait on the batch dispatches queued so far
+				flushDevices();
+				clResult = pDispatchSharded(node, *entries[idx].shardSet, payloads[idx]);
+			}
+			else
+			{
+				clResult = pDispatchNode(node, payloads[idx]);
+				if (std::find(devices.begin(), devices.end(), node->getDevice()) == devices.end())
+					devices.push_back(node->getDevice());
+			}
+
+			if (clResult != CL_SUCCESS)
+			{
+				std::string _logInfo_ = LOG_HEADER() + " BATCH DISPATCH FAILED: " + payloads[idx].tag;
+				getManager()->LOG_ERROR(_logInfo_);
+				break;
+			}
+		}
+
+		/* one flush per device for the complete batch, transfers could wait on these dispatches */
+		flushDevices();
+
+		return clResult;
+	}
+
+	cl_int ExecutionManager::dispatchGraph(compute::GraphPayload const& payload)
+	{
+		cl_int clResult = CL_SUCCESS;
+
+		// complete fused chains run as the fused dispatch (opt-in)
+		std::vector< compute::DispatchPayload > fusedPayloads;
+		bool isFused = payload.fuseElementwise && pFusePayloads(payload.dispatches.data(), payload.dispatches.size(), false, fusedPayloads);
+		auto const& dispatches = isFused ? fusedPayloads : payload.dispatches;
+
+		std::vector< ScheduledNode > order;
+		clResult = p_execGraph->schedule(dispatches, order);
+		if (clResult != CL_SUCCESS)
+		{
+			std::string _logInfo_ = LOG_HEADER() + " INVALID GRAPH SUBMISSION (unknown/duplicate dispatch tag).";
+			getManager()->LOG_ERROR(_logInfo_);
+			return clResult;
+		}
+
+		/*
+		*-------------------------------
+		* Nodes are enqueued in topological order on the compute queue of their device, each node waits
+		* on the events of its upstream nodes (and the sync events of its bound resources), so with an
+		* out of order compute queue the independent branches run concurrently.
+		*-------------------------------
+		*/
+		std::vector< cl::Event > events(order.size());
+		std::set< Device* > devices;
+
+		size_t enqueued = 0;
+		for (; enqueued < order.size(); ++enqueued)
+		{
+			auto &scheduled = order[enqueued];
+			ExecutionNode* node = p_execGraph->getNode(scheduled.nodeKEY);
+			devices.insert(node->getDevice());
+
+			DispatchSync sync;
+			sync.event = &events[enqueued];
+			for (auto waitIdx : scheduled.waitIdx)
+			{
+				sync.waitEvents.push_back(events[waitIdx]);
+			}
+
+			clResult = pDispatchNode(node, dispatches[scheduled.payloadIdx], &sync);
+			if (clResult != CL_SUCCESS)
+			{
+				std::string _logInfo_ = LOG_HEADER() + " GRAPH DISPATCH FAILED: " + dispatches[scheduled.payloadIdx].tag;
+				getManager()->LOG_ERROR(_logInfo_);
+				break;
+			}
+		}
+
+		// on failure every enqueued node is treated as a sink, its downstream was never enqueued
+		p_pendingGraphEvents.clear();
+		for (size_t idx = 0; idx < enqueued; ++idx)
+		{
+			if (order[idx].isSink || clResult != CL_SUCCESS)
+			{
+				p_pendingGraphEvents.push_back(events[idx]);
+			}
+		}
+
+		for (auto pDevice : devices)
+		{
+			pDevice->getCmdQueue(QueueType::eCompute).flush();
+		}
+
+		if (payload.sync.getIsHostBlocking())
+		{
+			cl_int waitResult = waitGraph();
+			if (clResult == CL_SUCCESS)
+				clResult = waitResult;
+		}
+
+		return clResult;
+	}
+
+	cl_int ExecutionManager::waitGraph()
+	{
+		cl_int clResult = CL_SUCCESS;
+
+		// events could belong to different device contexts, so these are waited individually.
+		for (auto &pEvent : p_pendingGraphEvents)
+		{
+			cl_int waitResult = pEvent.wait();
+			if (waitResult != CL_SUCCESS)
+				clResult = waitResult;
+		}
+		p_pendingGraphEvents.clear();
+
+		cl_int overflowResult = pCheckPipeOverflow();
+		if (clResult == CL_SUCCESS)
+			clResult = overflowResult;
+
+		return clResult;
+	}
+
+	cl_int ExecutionManager::pCheckPipeOverflow()
+	{
+		cl_int clResult = CL_SUCCESS;
+
+		for (auto &pPipe : p_pipes)
+		{
+			cl_int pipeResult = pPipe.second->checkOverflow();
+			if (pipeResult == CL_OUT_OF_RESOURCES)
+			{
+				std::string _logInfo_ = LOG_HEADER() + " PIPE OVERFLOW, PACKETS DROPPED (ring buffer pipe, see PipeDescription::setMaxPackets).";
+				getManager()->LOG_ERROR(_logInfo_);
+			}
+
+			if (pipeResult != CL_SUCCESS)
+				clResult = pipeResult;
+		}
+
+		return clResult;
+	}
+
 } // end namespace opencl
 
 
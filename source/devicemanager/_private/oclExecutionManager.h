@@ -14,6 +14,9 @@
 
 #include "oclDefines.h"
 #include "oclDevice.h"
+#include "oclExecutionGraph.h"
+#include "oclShardBalancer.h"
+#include "oclKernelFusion.h"
 
 
 namespace opencl
@@ -51,22 +54,120 @@ namespace opencl
 			return p_images.at(key).get();
 		}
 
+		/* (key, buffer) of an interned buffer id, see DataSlot::resolveBuffer */
+		inline std::pair<size_t, Buffer*> const& getBufferEntry(compute::BufferId bufferId) const
+		{
+			assert(bufferId.index < p_bufferTable.size());
+			return p_bufferTable[bufferId.index];
+		}
+
+		inline std::pair<size_t, Image*> const& getImageEntry(compute::ImageId imageId) const
+		{
+			assert(imageId.index < p_imageTable.size());
+			return p_imageTable[imageId.index];
+		}
+
+		/* nullptr for an unknown pipe */
+		inline Pipe* getPipe(size_t key) const
+		{
+			auto pPipe = p_pipes.find(key);
+			return pPipe != p_pipes.end() ? pPipe->second.get() : nullptr;
+		}
+
 		inline ExecutionNode* getExecNode(size_t key) const
 		{
-			return p_execNodes.at(key).get();
+			return p_execGraph->getNode(key);
+		}
+
+		inline ExecutionGraph* getExecGraph() const
+		{
+			return p_execGraph.get();
 		}
 
 		cl_int initAppComputePipeline(compute::AppComputePipelineHandle& appComputePipeline);
 
 		cl_int dispatch(compute::DispatchPayload const& payload);
 
+		/* nodes resolved upfront, a single compute queue flush per device */
+		cl_int dispatchBatch(compute::DispatchPayload const* payloads, size_t count, bool fuseElementwise);
+
+		/* single host sync (if blocking) for the complete graph */
+		cl_int dispatchGraph(compute::GraphPayload const& payload);
+
+		cl_int waitGraph();
+
+		/*
+		* runtime changes of the pipeline, only the added/removed resources and nodes are (de)allocated.
+		* resources bound to a kernel arg can't be removed (rebind the arg or remove the dispatch first).
+		*/
+		cl_int addBuffer(compute::BufferDescription const& bufDesc);
+		cl_int removeBuffer(std::string const& tag);
+		cl_int addImage(compute::ImageDescription const& imgDesc);
+		cl_int removeImage(std::string const& tag);
+		cl_int addDispatch(compute::DispatchDescription const& dispatchDesc);
+		cl_int removeDispatch(std::string const& tag);
+
 	protected:
 		cl_int pAddBufferResource(compute::BufferDescription const& bufDesc);
 		cl_int pAddImageResource(compute::ImageDescription const& imgDesc);
+		cl_int pAddPipeResource(compute::PipeDescription const& pipeDesc);
 		cl_int pAddExecutionNodes(compute::DispatchDescription const& dispatchDesc);
+		cl_int pAddDependencies(compute::DispatchDescription const& dispatchDesc);
+
+		/* bound to a kernel arg of any execution node */
+		bool pIsResourceBound(ResourceSync const* resource) const;
+
+		/* blocking | CL_OUT_OF_RESOURCES if a ring buffer pipe dropped a write since the last check, see Pipe::checkOverflow */
+		cl_int pCheckPipeOverflow();
+
+		/* fused kernels of the linear elementwise chains, see DispatchDescription::setElementwiseFunction */
+		void pAddFusedChains();
+		void pRemoveFusedChain(size_t fusedKEY);
+
+		/*
+		* the payloads with every complete chain replaced by its fused dispatch (at the position of the chain head),
+		* ordered - the stages have to be consecutive in the payloads (batch submission order).
+		* false if no chain is fused, the payloads are dispatched as they are.
+		*/
+		bool pFusePayloads(compute::DispatchPayload const* payloads, size_t count, bool ordered, std::vector< compute::DispatchPayload >& fused);
+
+		/*
+		* fused kernel args from the args of the stages, fails if the stages don't pass the data through one buffer each
+		* or an intermediate buffer is bound to a dispatch outside the chain (the fused kernel doesn't write it).
+		*/
+		cl_int pPrepareFusedChain(FusedChain const& chain, size_t globalworksize);
 
 		template<DeviceProfile __PROFILE, WorkItemDistribution __DISTRIBUTION>
-		cl_int pDispatch(ExecutionNode* node, compute::DispatchPayload const& payload);
+		cl_int pDispatch(ExecutionNode* node, compute::DispatchPayload const& payload, DispatchSync* sync = nullptr);
+
+		/* tuned shape of autotuned nodes, else pDispatchDefault */
+		cl_int pDispatchNode(ExecutionNode* node, compute::DispatchPayload const& payload, DispatchSync* sync = nullptr);
+
+		/* selects the pDispatch specialization for the device profile of the node */
+		cl_int pDispatchDefault(ExecutionNode* node, compute::DispatchPayload const& payload, DispatchSync* sync = nullptr);
+
+		/* 1D dispatch with the local size of the shape, global padded to the local size */
+		cl_int pDispatchShape(ExecutionNode* node, compute::DispatchPayload const& payload, TunedShape const& shape, DispatchSync* sync = nullptr);
+
+		/* node cache -> tuning database -> pTuneNode, see DispatchDescription::setIsAutotuned */
+		cl_int pGetTunedShape(ExecutionNode* node, compute::DispatchPayload const& payload, DispatchSync* sync, TunedShape& shape);
+
+		/* blocking, times the candidate shapes on the profiling queue of the device and returns the fastest */
+		cl_int pTuneNode(ExecutionNode* node, compute::DispatchPayload const& payload, DispatchSync* sync, TunedShape& shape);
+
+		cl::CommandQueue& pGetProfilingQueue(Device* device);
+
+		/* replicas of a sharded node on every other device with the kernel built */
+		void pAddShardReplicas(size_t execNodeKEY, compute::DispatchDescription const& dispatchDesc);
+
+		/* blocking, see DispatchDescription::setIsSharded */
+		cl_int pDispatchSharded(ExecutionNode* node, ShardSet& shardSet, compute::DispatchPayload const& payload);
+
+		/* 1D local size of a shard, shard boundaries are multiples of the local sizes of all the shards */
+		uint64_t pGetShardLocalSize(ExecutionNode* node) const;
+
+		/* copy of the buffer on another device, created on first use */
+		Buffer* pGetBufferReplica(size_t bufKEY, Device* device);
 
 	protected:
 		Manager * p_mgr;
@@ -74,9 +175,20 @@ namespace opencl
 
 		std::map < size_t, BufferHandle > p_buffers;
 		std::map < size_t, ImageHandle > p_images;
+		std::map < size_t, PipeHandle > p_pipes;
+		std::map < size_t, compute::BufferDescription > p_bufferDescs;
+		std::vector < std::pair<size_t, Buffer*> > p_bufferTable; /* interned buffer id -> (key, buffer) */
+		std::vector < std::pair<size_t, Image*> > p_imageTable; /* interned image id -> (key, image) */
+
+		std::map < size_t, ShardSet > p_shardSets;
+		std::map < std::pair<size_t, size_t>, BufferHandle > p_bufferReplicas; /* (buffer key, device id) -> replica */
+		std::map < size_t, cl::CommandQueue > p_profilingQueues; /* device id -> CL_QUEUE_PROFILING_ENABLE queue for autotuning */
+
+		std::map < size_t, FusedChain > p_fusedChains; /* fused node key -> chain */
+		std::map < size_t, size_t > p_fusedStageOf; /* stage node key -> fused node key */
 
-		/* this will be replaced by the ExecGraph */
-		std::map < size_t, ExecNodeHandle > p_execNodes;
+		ExecGraphHandle p_execGraph;
+		std::vector< cl::Event > p_pendingGraphEvents; /* events of the last graph submission */
 	};
 
 	
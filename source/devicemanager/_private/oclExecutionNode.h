@@ -16,11 +16,43 @@
 #include <array>
 
 #include "oclDefines.h"
+#include "oclEvent.h"
+#include "oclProgram.h"
+#include "oclTuningDatabase.h"
+#include "oclProfiler.h"
 
 
 namespace opencl
 {
 
+	/**
+	* @struct	DispatchSync
+	* @brief	Event dependencies of a dispatch submitted as part of the ExecutionGraph.
+	*/
+	struct DispatchSync
+	{
+		std::vector< cl::Event >	waitEvents;
+		cl::Event*					event{ nullptr };
+		cl::CommandQueue*			cmdQueue{ nullptr };	/* overrides the compute queue (autotuning profiling queue) */
+	};
+
+
+	/**
+	* @struct	ArgRecord
+	* @brief	Last value or resource set on a kernel arg, replayed on the shard replicas of the node.
+	*/
+	struct ArgRecord
+	{
+		std::vector< unsigned char >	value;
+		size_t							size{ 0 };			/* __local args have a size and no value */
+		size_t							resourceKEY{ 0 };
+		bool							isBuffer{ false };
+		bool							isImage{ false };
+		bool							isPipe{ false };
+		bool							isSharedVirtual{ false };	/* eSharedVirtual buffer, links of the data are device addresses or offsets of the primary */
+	};
+
+
 	class ExecutionNode
 	{
 	public:
@@ -34,7 +66,9 @@ namespace opencl
 
 		inline void initKernelWorkGroupInfo()
 		{
-			cl::Kernel kernelObj = p_device->getProgram(p_kernelNamespace)->getKernel(p_kernelName);
+			// resolved once, setArg and dispatch use the cached kernel
+			p_clKernel = p_device->getProgram(p_kernelNamespace)->getKernel(p_kernelName);
+			cl::Kernel& kernelObj = p_clKernel;
 
 			p_kernelWorkGroupSize = kernelObj.getWorkGroupInfo<CL_KERNEL_WORK_GROUP_SIZE>(p_device->getLogicalDevice());
 			p_KernelPreferredWorkGroupMultiple = kernelObj.getWorkGroupInfo<CL_KERNEL_PREFERRED_WORK_GROUP_SIZE_MULTIPLE>(p_device->getLogicalDevice());			
@@ -42,6 +76,16 @@ namespace opencl
 			p_kernelCompileWorkGroupSize[0] = wgSizes[0];
 			p_kernelCompileWorkGroupSize[1] = wgSizes[1];
 			p_kernelCompileWorkGroupSize[2] = wgSizes[2];
+
+			p_boundResources.assign(kernelObj.getInfo<CL_KERNEL_NUM_ARGS>(), nullptr);
+			p_argRecords.assign(p_boundResources.size(), ArgRecord());
+
+			std::vector< KernelArgInfo > const* argInfo = getKernelArgInfo();
+			p_argAccess.resize(p_boundResources.size());
+			for (cl_uint argIdx = 0; argIdx < p_argAccess.size(); ++argIdx)
+			{
+				p_argAccess[argIdx] = pGetArgAccess(argInfo ? &argInfo->at(argIdx) : nullptr);
+			}
 		}
 
 		inline Device* getDevice() const
@@ -78,33 +122,231 @@ namespace opencl
 		template<typename T>
 		inline cl_int setArg(cl_uint argIdx, const T &argVal)
 		{
-			cl::Kernel kernelObj = p_device->getProgram(p_kernelNamespace)->getKernel(p_kernelName);
-			return kernelObj.setArg<T>(argIdx, argVal);
+			return p_clKernel.setArg<T>(argIdx, argVal);
 		}
 
-		inline cl_int setArg(cl_uint argIdx, size_t argSize, void* argValPtr)
+		inline cl_int setArg(cl_uint argIdx, size_t argSize, const void* argValPtr)
 		{
-			cl::Kernel kernelObj = p_device->getProgram(p_kernelNamespace)->getKernel(p_kernelName);
-			return kernelObj.setArg(argIdx, argSize, argValPtr);
+			// the record keeps its value storage, resetting an arg of the same size doesn't allocate
+			ArgRecord& record = p_argRecords.at(argIdx);
+			record.size = argSize;
+			record.resourceKEY = 0;
+			record.isBuffer = false;
+			record.isImage = false;
+			record.isPipe = false;
+			record.isSharedVirtual = false;
+			if (argValPtr)
+				record.value.assign(reinterpret_cast<const unsigned char*>(argValPtr), reinterpret_cast<const unsigned char*>(argValPtr) + argSize);
+			else
+				record.value.clear();
+
+			return p_clKernel.setArg(argIdx, argSize, argValPtr);
+		}
+
+		/* marks the last setArg as a resource binding (after setArg) */
+		inline void recordResourceArg(cl_uint argIdx, device::ResourceType type, size_t resourceKEY)
+		{
+			ArgRecord& record = p_argRecords.at(argIdx);
+			record.resourceKEY = resourceKEY;
+			record.isBuffer = type == device::ResourceType::eBuffer;
+			record.isImage = type == device::ResourceType::eImage;
+			record.isPipe = type == device::ResourceType::ePipe;
+		}
+
+#ifdef CL_VERSION_2_0
+		/* svm buffer arg (clSetKernelArgSVMPointer), the kernel may follow the pointers stored in the allocation */
+		inline cl_int setArgSVMPointer(cl_uint argIdx, const void* svmPtr)
+		{
+			ArgRecord& record = p_argRecords.at(argIdx);
+			record = ArgRecord();
+			record.isSharedVirtual = true;
+
+			return clSetKernelArgSVMPointer(p_clKernel(), argIdx, svmPtr);
+		}
+#endif
+
+		/* flattened eSharedVirtual buffer arg (after setArg) */
+		inline void setIsSharedVirtualArg(cl_uint argIdx)
+		{
+			p_argRecords.at(argIdx).isSharedVirtual = true;
 		}
 
-		inline cl_int dispatch(cl::NDRange const& offset, cl::NDRange const& global, cl::NDRange const& local = cl::NullRange)
+		inline std::vector< ArgRecord > const& getArgRecords() const
 		{
-			cl::CommandQueue cmdQueueObj = p_device->getCmdQueue();
-			cl::Kernel kernelObj = p_device->getProgram(p_kernelNamespace)->getKernel(p_kernelName);
+			return p_argRecords;
+		}
 
-			/* #improvement - add the synchronization slots */
-			return cmdQueueObj.enqueueNDRangeKernel(kernelObj, offset, global, local);
+		/* access of the resource bound to the arg, see pGetArgAccess */
+		inline ResourceAccess getArgAccess(size_t argIdx) const
+		{
+			return pGetBoundAccess(argIdx);
+		}
+
+		/* images, pipes and shared virtual buffers live on the primary device only, these nodes run unsharded */
+		inline bool hasUnshardableArgs() const
+		{
+			return std::any_of(p_argRecords.begin(), p_argRecords.end(), [](ArgRecord const& record) { return record.isImage || record.isPipe || record.isSharedVirtual; });
+		}
+
+		/* resource bound to the kernel arg (nullptr for value args), dispatches are ordered with its sync events */
+		inline void bindResource(cl_uint argIdx, ResourceSync const* resource)
+		{
+			p_boundResources.at(argIdx) = resource;
+		}
+
+		inline bool isResourceBound(ResourceSync const* resource) const
+		{
+			return std::find(p_boundResources.begin(), p_boundResources.end(), resource) != p_boundResources.end();
+		}
+
+		inline bool getIsAutotuned() const
+		{
+			return p_autotuned;
+		}
+
+		inline void setIsAutotuned(bool autotuned)
+		{
+			p_autotuned = autotuned;
+		}
+
+		/* tuned shapes of the node by problem size bucket, filled from the TuningDatabase */
+		inline bool findTunedShape(uint32_t bucket, TunedShape& shape) const
+		{
+			auto pShape = p_tunedShapes.find(bucket);
+			if (pShape == p_tunedShapes.end())
+				return false;
+
+			shape = pShape->second;
+			return true;
+		}
+
+		inline void setTunedShape(uint32_t bucket, TunedShape const& shape)
+		{
+			p_tunedShapes[bucket] = shape;
+		}
+
+		/* dispatches are recorded under the tag, see ContextDescription::setIsProfiling */
+		inline void setProfiler(Profiler* profiler, std::string const& tag)
+		{
+			p_profiler = profiler;
+			p_profileTag = tag;
+		}
+
+		inline std::string const& getKernelName() const
+		{
+			return p_kernelName;
+		}
+
+		inline std::string const& getKernelNamespace() const
+		{
+			return p_kernelNamespace;
+		}
+
+		inline cl::Kernel const& getKernel() const
+		{
+			return p_clKernel;
+		}
+
+		/* nullptr if the kernel has no arg info, see Program::getArgInfo */
+		inline std::vector< KernelArgInfo > const* getKernelArgInfo() const
+		{
+			return p_device->getProgram(p_kernelNamespace)->getArgInfo(p_kernelName);
+		}
+
+		inline cl_int dispatch(cl::NDRange const& offset, cl::NDRange const& global, cl::NDRange const& local = cl::NullRange, DispatchSync* sync = nullptr)
+		{
+			cl::CommandQueue cmdQueueObj = (sync && sync->cmdQueue) ? *sync->cmdQueue : p_device->getCmdQueue(QueueType::eCompute);
+
+			// the wait list keeps its capacity across the dispatches of the node
+			p_waitEvents.clear();
+			if (sync)
+				p_waitEvents.insert(p_waitEvents.end(), sync->waitEvents.begin(), sync->waitEvents.end());
+
+			for (size_t argIdx = 0; argIdx < p_boundResources.size(); ++argIdx)
+			{
+				if (p_boundResources[argIdx])
+					p_boundResources[argIdx]->appendSyncEvent(p_waitEvents, pGetBoundAccess(argIdx));
+			}
+
+			cl::Event dispatchEvent;
+			cl_int clResult = cmdQueueObj.enqueueNDRangeKernel(p_clKernel, offset, global, local, p_waitEvents.size() ? &p_waitEvents : nullptr, &dispatchEvent);
+			if (clResult != CL_SUCCESS)
+				return clResult;
+
+			// reads first, a resource bound to a read and a written arg ends up written
+			for (ResourceAccess access : { ResourceAccess::eRead, ResourceAccess::eWrite })
+			{
+				for (size_t argIdx = 0; argIdx < p_boundResources.size(); ++argIdx)
+				{
+					if (p_boundResources[argIdx] && pGetBoundAccess(argIdx) == access)
+						p_boundResources[argIdx]->setSyncEvent(dispatchEvent, access);
+				}
+			}
+
+			if (sync && sync->event)
+				*sync->event = dispatchEvent;
+
+			// the autotuning runs on its own queue are not part of the application timings
+			if (p_profiler && !(sync && sync->cmdQueue))
+				p_profiler->record(p_profileTag, dispatchEvent);
+
+			return clResult;
+		}
+
+	protected:
+		/*
+		* __constant pointers, const __global pointers and read_only images are reads. Pipes (a read moves the
+		* read index) and args without arg info (IL without the names) are writes.
+		*/
+		static inline ResourceAccess pGetArgAccess(KernelArgInfo const* argInfo)
+		{
+			if (!argInfo)
+				return ResourceAccess::eWrite;
+
+#ifdef CL_VERSION_2_0
+			if (argInfo->typeQualifier & CL_KERNEL_ARG_TYPE_PIPE)
+				return ResourceAccess::eWrite;
+#endif
+
+			if (argInfo->addressQualifier == CL_KERNEL_ARG_ADDRESS_CONSTANT)
+				return ResourceAccess::eRead;
+
+			if (argInfo->addressQualifier == CL_KERNEL_ARG_ADDRESS_GLOBAL && (argInfo->typeQualifier & CL_KERNEL_ARG_TYPE_CONST))
+				return ResourceAccess::eRead;
+
+			if (argInfo->accessQualifier == CL_KERNEL_ARG_ACCESS_READ_ONLY)
+				return ResourceAccess::eRead;
+
+			return ResourceAccess::eWrite;
+		}
+
+		/* the ring of a fallback pipe is a plain buffer, the kernels may follow the links of shared virtual buffers */
+		inline ResourceAccess pGetBoundAccess(size_t argIdx) const
+		{
+			ArgRecord const& record = p_argRecords[argIdx];
+			return (record.isPipe || record.isSharedVirtual) ? ResourceAccess::eWrite : p_argAccess[argIdx];
 		}
 
 	protected:
 		Device * p_device;
 		std::string p_kernelName;
 		std::string p_kernelNamespace;
+		cl::Kernel p_clKernel;
 
 		uint64_t p_kernelWorkGroupSize;
 		uint64_t p_KernelPreferredWorkGroupMultiple;
 		std::array<uint64_t, 3> p_kernelCompileWorkGroupSize = { 0 };
+
+		std::vector< ResourceSync const* > p_boundResources;
+		std::vector< ArgRecord > p_argRecords;
+		std::vector< ResourceAccess > p_argAccess;
+		std::vector< cl::Event > p_waitEvents;
+
+		bool p_autotuned{ false };
+		std::unordered_map< uint32_t, TunedShape > p_tunedShapes;
+
+		Profiler* p_profiler{ nullptr };
+		std::string p_profileTag;
 	};
 
 }
@@ -0,0 +1,109 @@
+/*
+* ---------------------------------------------------------
+* Copyright 2018-present (c) Automatos Studios. All Rights Reserved.
+* ---------------------------------------------------------
+*/
+
+/**
+* @file			oclKernelFusion.cpp
+* @author		cosmoplankton < cosmoplankton@automatos.studio >
+*/
+
+
+#include <sstream>
+
+#include "oclKernelFusion.h"
+
+
+namespace opencl
+{
+	/* arg type name without the pointer */
+	static bool GET_ARG_TYPE(KernelArgInfo const& argInfo, cl_kernel_arg_address_qualifier addressQualifier, bool isPointer, std::string& typeName)
+	{
+		if (argInfo.addressQualifier != addressQualifier)
+			return false;
+
+		typeName = argInfo.typeName;
+		if (typeName.empty() || (typeName.back() == '*') != isPointer)
+			return false;
+
+		if (isPointer)
+			typeName.pop_back();
+
+		return !typeName.empty();
+	}
+
+	std::string GENERATE_FUSED_KERNEL(std::string const& kernelName, std::vector< FusedStage > const& stages, std::vector< cl_uint >& paramCounts)
+	{
+		paramCounts.clear();
+
+		std::string elementType;
+		std::vector< std::vector< std::string > > paramTypes(stages.size());
+		for (size_t stageIdx = 0; stageIdx < stages.size(); ++stageIdx)
+		{
+			if (!stages[stageIdx].argInfo)
+				return std::string();
+
+			std::vector< KernelArgInfo > const& argInfo = *stages[stageIdx].argInfo;
+			cl_uint argCount = static_cast<cl_uint>(argInfo.size()); // #safecast
+			if (argCount < 2)
+				return std::string();
+
+			std::string inType, outType;
+			if (!GET_ARG_TYPE(argInfo[0], CL_KERNEL_ARG_ADDRESS_GLOBAL, true, inType) ||
+				!GET_ARG_TYPE(argInfo[1], CL_KERNEL_ARG_ADDRESS_GLOBAL, true, outType) ||
+				inType != outType)
+				return std::string();
+
+			// the element type is the same through the chain, no implicit conversions between the stages
+			if (stageIdx == 0)
+				elementType = inType;
+			else if (inType != elementType)
+				return std::string();
+
+			for (cl_uint argIdx = 2; argIdx < argCount; ++argIdx)
+			{
+				std::string paramType;
+				if (!GET_ARG_TYPE(argInfo[argIdx], CL_KERNEL_ARG_ADDRESS_PRIVATE, false, paramType))
+					return std::string();
+
+				paramTypes[stageIdx].push_back(paramType);
+			}
+			paramCounts.push_back(argCount - 2);
+		}
+
+		/*
+		*-------------------------------
+		* Work item i applies the stage functions to element i in chain order, which is what the
+		* unfused chain computes through the intermediate buffers. The linear id covers the work
+		* distribution of pDispatch in any dimension count.
+		*-------------------------------
+		*/
+		std::ostringstream source;
+		source << "\n__kernel void " << kernelName << "(__global const " << elementType << "* fused_in, __global " << elementType << "* fused_out";
+		for (size_t stageIdx = 0; stageIdx < stages.size(); ++stageIdx)
+		{
+			for (size_t paramIdx = 0; paramIdx < paramTypes[stageIdx].size(); ++paramIdx)
+			{
+				source << ", " << paramTypes[stageIdx][paramIdx] << " fused_s" << stageIdx << "_p" << paramIdx;
+			}
+		}
+		source << ", uint fused_count)\n{\n";
+		source << "\tsize_t fused_gid = get_global_id(0) + get_global_size(0) * (get_global_id(1) + get_global_size(1) * get_global_id(2));\n";
+		source << "\tif (fused_gid >= fused_count)\n\t\treturn;\n\n";
+		source << "\t" << elementType << " fused_v = fused_in[fused_gid];\n";
+		for (size_t stageIdx = 0; stageIdx < stages.size(); ++stageIdx)
+		{
+			source << "\tfused_v = " << stages[stageIdx].function << "(fused_v";
+			for (size_t paramIdx = 0; paramIdx < paramTypes[stageIdx].size(); ++paramIdx)
+			{
+				source << ", fused_s" << stageIdx << "_p" << paramIdx;
+			}
+			source << ");\n";
+		}
+		source << "\tfused_out[fused_gid] = fused_v;\n}\n";
+
+		return source.str();
+	}
+
+} // end namespace opencl
@@ -0,0 +1,68 @@
+/*
+* ---------------------------------------------------------
+* Copyright 2018-present (c) Automatos Studios. All Rights Reserved.
+* ---------------------------------------------------------
+*/
+
+/**
+* @file			oclKernelFusion.h
+* @author		cosmoplankton < cosmoplankton@automatos.studio >
+*/
+
+
+#ifndef OPENCL_KERNEL_FUSION
+#define OPENCL_KERNEL_FUSION
+
+#include "oclDefines.h"
+#include "oclProgram.h"
+
+
+namespace opencl
+{
+
+	/**
+	* @struct	FusedStage
+	* @brief	Elementwise dispatch of a fused chain, see DispatchDescription::setElementwiseFunction.
+	*/
+	struct FusedStage
+	{
+		std::string							function;	/* OpenCL C element function "T function(T x, params...)" */
+		std::vector< KernelArgInfo > const*	argInfo;	/* args of the stage kernel, signature source of the fused kernel (nullptr without arg info) */
+	};
+
+
+	/**
+	* @struct	FusedChain
+	* @brief	Linear chain of elementwise dispatches replaced by a single fused dispatch.
+	*--------------------------------------------------------------------------
+	* Fused kernel args: stage 0 in, last stage out, the params of every stage in chain order,
+	* and the element count (work items past the count are idle).
+	*--------------------------------------------------------------------------
+	*/
+	struct FusedChain
+	{
+		std::string				tag;			/* payload tag of the fused dispatch */
+		std::string				kernelName;
+		size_t					fusedKEY{ 0 };
+		std::vector< size_t >	stageKEYs;		/* execution node keys in chain order */
+		std::vector< cl_uint >	paramCounts;	/* scalar args after (in, out) of every stage */
+	};
+
+
+	/**
+	* @name GENERATE_FUSED_KERNEL
+	*-------------------------------
+	* @param kernelName -	__kernel entrypoint of the generated source.
+	* @param stages -		Stages in chain order.
+	* @param paramCounts -	Filled with the scalar param count of every stage.
+	* @return -				OpenCL C source, empty if a stage doesn't have the elementwise
+	*						signature (global T* in, global T* out, private scalars) or the
+	*						element types of the stages don't match.
+	*-------------------------------
+	*/
+	std::string GENERATE_FUSED_KERNEL(std::string const& kernelName, std::vector< FusedStage > const& stages, std::vector< cl_uint >& paramCounts);
+
+} // end namespace opencl
+
+
+#endif // !OPENCL_KERNEL_FUSION
@@ -29,30 +29,149 @@ namespace opencl
 
 	int ArgSlot::argSet(compute::ArgPayload const& payload)
 	{
-		ExecutionNode* node = getManager()->getExecManager()->getExecNode(p_execNodeKEY);
-		return node->setArg(p_argIdx, payload.size, payload.data.get());
+		p_execNode->bindResource(static_cast<cl_uint>(p_argIdx), nullptr);
+		return p_execNode->setArg(p_argIdx, payload.size, payload.data);
 	}
 
 	int ArgSlot::argBindBuffer(std::string const& bufferTag)
 	{
-		ExecutionNode* node = getManager()->getExecManager()->getExecNode(p_execNodeKEY);
 		size_t bufKEY = GET_RESOURCEKEY<device::ResourceType::eBuffer>(bufferTag);
+		return pBindBuffer(getManager()->getExecManager()->getBuffer(bufKEY), bufKEY);
+	}
+
+	int ArgSlot::argBindImage(std::string const& imageTag)
+	{
+		size_t imgKEY = GET_RESOURCEKEY<device::ResourceType::eImage>(imageTag);
+		return pBindImage(getManager()->getExecManager()->getImage(imgKEY), imgKEY);
+	}
+
+	int ArgSlot::argBindBuffer(compute::BufferId bufferId)
+	{
+		// a removed buffer leaves an empty entry behind
+		auto const& entry = getManager()->getExecManager()->getBufferEntry(bufferId);
+		if (!entry.second)
+			return CL_INVALID_MEM_OBJECT;
+
+		return pBindBuffer(entry.second, entry.first);
+	}
 
-		Buffer* resource = getManager()->getExecManager()->getBuffer(bufKEY);
+	int ArgSlot::argBindImage(compute::ImageId imageId)
+	{
+		auto const& entry = getManager()->getExecManager()->getImageEntry(imageId);
+		if (!entry.second)
+			return CL_INVALID_MEM_OBJECT;
+
+		return pBindImage(entry.second, entry.first);
+	}
+
+	int ArgSlot::pBindBuffer(Buffer* resource, size_t bufKEY)
+	{
 		cl_mem memPtr = resource->getResource()();
+		p_execNode->bindResource(static_cast<cl_uint>(p_argIdx), resource);
 
-		return node->setArg(p_argIdx, sizeof(cl_mem), memPtr);
+		cl_int clResult = CL_SUCCESS;
+#ifdef CL_VERSION_2_0
+		if (resource->getSVMPointer())
+			clResult = p_execNode->setArgSVMPointer(static_cast<cl_uint>(p_argIdx), resource->getSVMPointer());
+		else
+#endif
+			clResult = p_execNode->setArg(p_argIdx, sizeof(cl_mem), &memPtr);
+		p_execNode->recordResourceArg(static_cast<cl_uint>(p_argIdx), device::ResourceType::eBuffer, bufKEY);
+
+		// the links of the flattened fallback are offsets into the whole buffer, no slicing either
+		if (resource->getIsSharedVirtual())
+			p_execNode->setIsSharedVirtualArg(static_cast<cl_uint>(p_argIdx));
+
+		return clResult;
 	}
 
-	int ArgSlot::argBindImage(std::string const& imageTag)
+	/* size of a built-in scalar/vector type name (0 for the types not known e.g. structs), 3 component vectors are sized as 4 */
+	static size_t GET_CL_TYPE_SIZE(std::string const& typeName)
 	{
-		ExecutionNode* node = getManager()->getExecManager()->getExecNode(p_execNodeKEY);
-		size_t imgKEY = GET_RESOURCEKEY<device::ResourceType::eImage>(imageTag);
+		size_t digitPos = typeName.find_first_of("0123456789");
+		std::string baseName = typeName.substr(0, digitPos);
+		size_t components = digitPos == std::string::npos ? 1 : std::stoul(typeName.substr(digitPos));
+		if (components == 3)
+			components = 4;
 
-		Image* resource = getManager()->getExecManager()->getImage(imgKEY);
+		size_t baseSize = 0;
+		if (baseName == "char" || baseName == "uchar" || baseName == "bool")
+			baseSize = 1;
+		else if (baseName == "short" || baseName == "ushort" || baseName == "half")
+			baseSize = 2;
+		else if (baseName == "int" || baseName == "uint" || baseName == "float")
+			baseSize = 4;
+		else if (baseName == "long" || baseName == "ulong" || baseName == "double")
+			baseSize = 8;
+
+		return baseSize * components;
+	}
+
+	int KernelSlot::checkArg(size_t argIdx, compute::ArgKind kind, size_t valueSize) const
+	{
+		if (argIdx >= p_argSignatures.size())
+			return CL_INVALID_ARG_INDEX;
+
+		ArgSignature const& signature = p_argSignatures[argIdx];
+		if (signature.typeName.empty())
+			return CL_SUCCESS;
+
+		bool isPointer = signature.typeName.back() == '*';
+		bool isImage = signature.typeName.compare(0, 5, "image") == 0;
+
+		switch (kind)
+		{
+		case compute::ArgKind::eBuffer:
+			if (!isPointer || (signature.addressQualifier != CL_KERNEL_ARG_ADDRESS_GLOBAL && signature.addressQualifier != CL_KERNEL_ARG_ADDRESS_CONSTANT))
+				return CL_INVALID_ARG_VALUE;
+			break;
+		case compute::ArgKind::eImage:
+			if (!isImage)
+				return CL_INVALID_ARG_VALUE;
+			break;
+		case compute::ArgKind::eValue:
+		{
+			if (isPointer || isImage || signature.addressQualifier != CL_KERNEL_ARG_ADDRESS_PRIVATE)
+				return CL_INVALID_ARG_VALUE;
+
+			size_t typeSize = GET_CL_TYPE_SIZE(signature.typeName);
+			if (typeSize && typeSize != valueSize)
+				return CL_INVALID_ARG_SIZE;
+			break;
+		}
+		default:
+			return CL_INVALID_ARG_VALUE;
+		}
+
+		return CL_SUCCESS;
+	}
+
+	int ArgSlot::argBindPipe(std::string const& pipeTag)
+	{
+		size_t pipeKEY = GET_RESOURCEKEY<device::ResourceType::ePipe>(pipeTag);
+		Pipe* pipe = getManager()->getExecManager()->getPipe(pipeKEY);
+		if (!pipe)
+			return CL_INVALID_MEM_OBJECT;
+
+		// native pipe or ring buffer, both are bound as a cl_mem
+		cl_mem memPtr = pipe->getResource()();
+		p_execNode->bindResource(static_cast<cl_uint>(p_argIdx), pipe);
+
+		cl_int clResult = p_execNode->setArg(p_argIdx, sizeof(cl_mem), &memPtr);
+		p_execNode->recordResourceArg(static_cast<cl_uint>(p_argIdx), device::ResourceType::ePipe, pipeKEY);
+
+		return clResult;
+	}
+
+	int ArgSlot::pBindImage(Image* resource, size_t imgKEY)
+	{
 		cl_mem memPtr = (*resource->getResource())();
+		p_execNode->bindResource(static_cast<cl_uint>(p_argIdx), resource);
+
+		cl_int clResult = p_execNode->setArg(p_argIdx, sizeof(cl_mem), &memPtr);
+		p_execNode->recordResourceArg(static_cast<cl_uint>(p_argIdx), device::ResourceType::eImage, imgKEY);
 
-		return node->setArg(p_argIdx, sizeof(cl_mem), memPtr);
+		return clResult;
 	}
 
 }
@@ -23,9 +23,10 @@ namespace opencl
 		: public compute::IArgSlot
 	{
 	public:
-		ArgSlot(size_t idx, size_t nodeKey)
+		ArgSlot(size_t idx, size_t nodeKey, ExecutionNode* node)
 			: p_argIdx(idx)
 			, p_execNodeKEY(nodeKey)
+			, p_execNode(node)
 		{}
 
 		friend class ExecutionManager;
@@ -48,10 +49,18 @@ namespace opencl
 		virtual int argSet(compute::ArgPayload const& payload) override;
 		virtual int argBindBuffer(std::string const& bufferTag) override;
 		virtual int argBindImage(std::string const& imageTag) override;
+		virtual int argBindBuffer(compute::BufferId bufferId) override;
+		virtual int argBindImage(compute::ImageId imageId) override;
+		virtual int argBindPipe(std::string const& pipeTag) override;
+
+	protected:
+		int pBindBuffer(Buffer* resource, size_t bufKEY);
+		int pBindImage(Image* resource, size_t imgKEY);
 
 	protected:
 		size_t p_argIdx;
 		size_t p_execNodeKEY;
+		ExecutionNode* p_execNode;	/* resolved once, the node lives as long as the execution graph */
 
 	private:
 		static Manager* s_MGR;
@@ -59,6 +68,14 @@ namespace opencl
 	};
 
 
+	/* CL_KERNEL_ARG_* info of a kernel arg (see Program::getArgInfo), resolved once when the kernel io is created */
+	struct ArgSignature
+	{
+		cl_kernel_arg_address_qualifier	addressQualifier{ CL_KERNEL_ARG_ADDRESS_PRIVATE };
+		std::string						typeName;	/* empty if the arg info isn't available (e.g. program from IL) */
+	};
+
+
 	class KernelSlot
 		: public compute::IKernelSlot
 	{
@@ -73,15 +90,45 @@ namespace opencl
 			return p_argIOs.at(p_argNameToIdx.at(argName)).get();
 		}
 
-		void addArgIO(std::string const& argName, compute::ArgIOHandle argio)
+		virtual compute::ArgIO* getArgSlot(compute::ArgId argId) const override
+		{
+			assert(argId.index < p_argIOs.size());
+			return p_argIOs[argId.index].get();
+		}
+
+		/* the arg index is the interned id */
+		virtual compute::ArgId resolveArg(std::string const& argName) const override
+		{
+			compute::ArgId argId;
+			auto pIdx = p_argNameToIdx.find(argName);
+			if (pIdx != p_argNameToIdx.end())
+				argId.index = static_cast<uint32_t>(pIdx->second);
+			return argId;
+		}
+
+		virtual size_t getArgCount() const override
+		{
+			return p_argIOs.size();
+		}
+
+		virtual int checkArg(size_t argIdx, compute::ArgKind kind, size_t valueSize) const override;
+
+		void addArgIO(std::string const& argName, compute::ArgIOHandle argio, ArgSignature const& signature)
 		{
 			size_t idx = (reinterpret_cast<ArgSlot*>(argio->getImpl()))->getIdx();
+			if (idx >= p_argIOs.size())
+			{
+				p_argIOs.resize(idx + 1);
+				p_argSignatures.resize(idx + 1);
+			}
 			p_argIOs[idx] = argio;
+			p_argSignatures[idx] = signature;
 			p_argNameToIdx[argName] = idx;
 		}
 
 	protected:
-		std::map<size_t, compute::ArgIOHandle> p_argIOs;
+		std::vector<compute::ArgIOHandle> p_argIOs;
+		std::vector<ArgSignature> p_argSignatures;
 		std::map<std::string, size_t> p_argNameToIdx;
 	};
 
@@ -97,13 +144,26 @@ namespace opencl
 			return m_kernelIOs.at(kernelKEY).get();
 		}
 
-		void addKernelIO(size_t key, compute::KernelIOHandle handle)
+		void addKernelIO(size_t key, compute::KernelIOHandle handle, size_t execNodeKEY)
 		{
 			m_kernelIOs[key] = handle;
+			m_kernelNodeKEYs[key] = execNodeKEY;
+		}
+
+		/* only if the kernel io still belongs to the node (dispatches of the same kernel share the kernel io key) */
+		void removeKernelIO(size_t key, size_t execNodeKEY)
+		{
+			auto pNodeKEY = m_kernelNodeKEYs.find(key);
+			if (pNodeKEY == m_kernelNodeKEYs.end() || pNodeKEY->second != execNodeKEY)
+				return;
+
+			m_kernelNodeKEYs.erase(pNodeKEY);
+			m_kernelIOs.erase(key);
 		}
 
 	protected:
 		std::map<size_t, compute::KernelIOHandle> m_kernelIOs;
+		std::map<size_t, size_t> m_kernelNodeKEYs;	/* kernel io key -> execution node the arg slots are bound to */
 	};
 
 }
@@ -14,12 +14,115 @@
 #include "oclManager.h"
 #include "oclExecutionManager.h"
 #include "oclResourceManager.h"
+#include "oclProgramCache.h"
+#include "oclTuningDatabase.h"
+#include "oclProfiler.h"
+#include "oclProgram.h"
 
 
 namespace opencl
 {
 	uint32_t Manager::s_deviceIdxCounter = 0;
 
+	/*
+	*-------------------------------
+	* COMPUTE_PIPE_PRELUDE - prepended to the sources of the namespaces using pipes (see USES_PIPES), the pipe
+	* args and accesses of the kernels build with native pipes (COMPUTE_PIPES_NATIVE) and with the ring buffers
+	* of opencl::Pipe. Ring header (COMPUTE_PIPE_RING_HEADER uints): [0] read count, [1] write count,
+	* [2] capacity (power of two), [3] packet size, [4] overflow (COMPUTE_PIPE_RING_OVERFLOW), packets follow.
+	* Both offsets are build options (see pGetBuildOptions), oclDefines.h is their only definition.
+	*-------------------------------
+	*/
+	static const char* COMPUTE_PIPE_PRELUDE = R"CLC(
+#ifdef COMPUTE_PIPES_NATIVE
+#define COMPUTE_PIPE_IN(T, name) __read_only pipe T name
+#define COMPUTE_PIPE_OUT(T, name) __write_only pipe T name
+#define compute_write_pipe(name, packet) write_pipe(name, packet)
+#define compute_read_pipe(name, packet) read_pipe(name, packet)
+#else
+#define COMPUTE_PIPE_IN(T, name) __global uint* name
+#define COMPUTE_PIPE_OUT(T, name) __global uint* name
+#define compute_write_pipe(name, packet) compute_ring_write(name, (const uchar*)(packet), sizeof(*(packet)))
+#define compute_read_pipe(name, packet) compute_ring_read(name, (uchar*)(packet), sizeof(*(packet)))
+
+int compute_ring_write(__global uint* ring, const uchar* packet, uint size)
+{
+	uint idx = atomic_inc(&ring[1]);
+	if (idx - ring[0] >= ring[2])
+	{
+		atomic_dec(&ring[1]);
+		atomic_or(&ring[COMPUTE_PIPE_RING_OVERFLOW], 1u);
+		return -1;
+	}
+
+	__global uchar* slot = (__global uchar*)(ring + COMPUTE_PIPE_RING_HEADER) + (size_t)(idx & (ring[2] - 1)) * ring[3];
+	for (uint i = 0; i < size; ++i)
+		slot[i] = packet[i];
+	return 0;
+}
+
+int compute_ring_read(__global uint* ring, uchar* packet, uint size)
+{
+	uint idx = atomic_inc(&ring[0]);
+	if ((int)(idx - ring[1]) >= 0)
+	{
+		atomic_dec(&ring[0]);
+		return -1;
+	}
+
+	__global const uchar* slot = (__global const uchar*)(ring + COMPUTE_PIPE_RING_HEADER) + (size_t)(idx & (ring[2] - 1)) * ring[3];
+	for (uint i = 0; i < size; ++i)
+		packet[i] = slot[i];
+	return 0;
+}
+#endif
+)CLC";
+
+	/*
+	*-------------------------------
+	* COMPUTE_SVM_PRELUDE - links of the eSharedVirtual buffers, device addresses with svm (COMPUTE_SVM_NATIVE)
+	* else byte offsets into the flattened buffer, see compute::BufferSlot::getSharedVirtualRef.
+	*-------------------------------
+	*/
+	static const char* COMPUTE_SVM_PRELUDE = R"CLC(
+#ifdef COMPUTE_SVM_NATIVE
+#define compute_svm_ptr(T, base, ref) ((__global T*)(ref))
+#else
+#define compute_svm_ptr(T, base, ref) ((__global T*)((__global uchar*)(base) + (ref)))
+#endif
+)CLC";
+
+	/*
+	*-------------------------------
+	* COMPUTE_HALF_PRELUDE - eFloat16 buffers (__global half*), stored as 16 bit and widened to float in
+	* registers only, no cl_khr_fp16 needed. Stores round to nearest even.
+	*-------------------------------
+	*/
+	static const char* COMPUTE_HALF_PRELUDE = R"CLC(
+#define compute_load_half(ptr, idx) vload_half((idx), (ptr))
+#define compute_store_half(ptr, idx, value) vstore_half_rte((value), (idx), (ptr))
+#define compute_load_half4(ptr, idx) vload_half4((idx), (ptr))
+#define compute_store_half4(ptr, idx, value) vstore_half4_rte((value), (idx), (ptr))
+)CLC";
+
+	/* pipe args are declared with the prelude macros, the other namespaces build without the pipe prelude and OpenCL C 2.0 */
+	static bool USES_PIPES(std::vector< std::string > const& sources)
+	{
+		return std::any_of(sources.begin(), sources.end(), [](std::string const& source) { return source.find("COMPUTE_PIPE_") != std::string::npos; });
+	}
+
+	/* preludes ahead of the namespace sources */
+	static void APPEND_KERNEL_PRELUDES(std::vector< std::pair<char const*, size_t> >& progSources, bool usesPipes)
+	{
+		if (usesPipes)
+			progSources.push_back(std::pair<char const*, size_t>(COMPUTE_PIPE_PRELUDE, strlen(COMPUTE_PIPE_PRELUDE)));
+
+		for (char const* prelude : { COMPUTE_SVM_PRELUDE, COMPUTE_HALF_PRELUDE })
+		{
+			progSources.push_back(std::pair<char const*, size_t>(prelude, strlen(prelude)));
+		}
+	}
+
 	
 	Manager::Manager(compute::I_ComputeAppManager* cAppManager, device::HostPtr hostPtr)
 		: p_cAppManager(cAppManager)
@@ -33,56 +136,187 @@ namespace opencl
 		return static_cast<int>(p_devicePool.size()); // #safecast
 	}
 
-	int Manager::initContextandDevices()
+	int Manager::getPrimaryDeviceInfo(compute::DeviceInfo& info) const
+	{
+		if (p_devicePool.empty())
+			return CL_DEVICE_NOT_FOUND;
+
+		Device* device = getPrimaryDevice();
+		info.name = device->getLogicalDevice().getInfo<CL_DEVICE_NAME>();
+		info.type = device->GetType();
+		info.computeUnits = static_cast<uint32_t>(device->getLimits().computeUnits); // #safecast
+		info.maxWorkGroupSize = device->getLimits().maxWorkGroupSize;
+		return CL_SUCCESS;
+	}
+
+	int Manager::initContextandDevices(compute::ContextDescription const& contextDesc)
 	{
 		cl_int clResult = 0;
 
-		// get the first available platform
-		clResult = cl::Platform::get(&p_clPlatform);
-		CHECK_STATUS(clResult, CL_SUCCESS);
+		p_contextDesc = contextDesc;
+		p_programCache = std::make_shared<ProgramCache>(p_contextDesc.getProgramCacheDirectory());
+		p_tuningDb = std::make_shared<TuningDatabase>(p_contextDesc.getTuningDatabasePath());
+		if (p_contextDesc.getIsProfiling())
+			p_profiler = std::make_shared<Profiler>();
 
-		// get the devicelist
-		std::vector< cl::Device > devices;
-		clResult = p_clPlatform.getDevices(CL_DEVICE_TYPE_GPU, &devices);
+		// get all the available platforms (gpu drivers and cpu runtimes e.g. PoCL are usually separate platforms)
+		clResult = cl::Platform::get(&p_clPlatforms);
 		CHECK_STATUS(clResult, CL_SUCCESS);
 
-		if (!devices.size())
+		// gpus are added first so that a gpu (if available) becomes the primary device
+		pAddDevices(CL_DEVICE_TYPE_GPU, device::DeviceType::eGPU, DeviceProfile::eGPGPU);
+		pAddDevices(CL_DEVICE_TYPE_CPU, device::DeviceType::eCPU, DeviceProfile::eGeneral);
+
+		if (!p_devicePool.size())
 		{
-			std::string _logInfo_ = LOG_HEADER() + " NO OPENCL COMPATIBLE GPU FOUND.";
+			std::string _logInfo_ = LOG_HEADER() + " NO OPENCL COMPATIBLE DEVICE FOUND.";
 			LOG_ERROR(_logInfo_);
-			THROW_EXCEPTION(device::init_error("NO OPENCL COMPATIBLE GPU FOUND."));
+			THROW_EXCEPTION(device::init_error("NO OPENCL COMPATIBLE DEVICE FOUND."));
 		}
 
-		// create a single primary context and command queue per device
-		for (auto &pDevice : devices)
+		// the primary device is the n-th device of the requested type (of all the devices by default, gpus first)
+		device::DeviceType primaryType = p_contextDesc.getPrimaryDeviceType();
+		uint32_t typeIdx = 0;
+		p_primaryDeviceIdx = static_cast<uint32_t>(p_devicePool.size()); // #safecast
+		for (uint32_t deviceIdx = 0; deviceIdx < p_devicePool.size(); ++deviceIdx)
 		{
-			if (pCheckDeviceMinRequirements(&pDevice, DeviceProfile::eGPGPU))
-			{
-				p_devicePool.push_back(std::make_shared< Device >(s_deviceIdxCounter, device::DeviceType::eGPU, pDevice, DeviceProfile::eGPGPU));
-				++s_deviceIdxCounter;
-				cl_context_properties contextProps[] = { CL_CONTEXT_PLATFORM, (cl_context_properties)p_clPlatform(), 0 };
-				p_devicePool.back()->createContext(contextProps);
+			if (primaryType != device::DeviceType::eUndefined && p_devicePool[deviceIdx]->GetType() != primaryType)
+				continue;
 
-				cl_command_queue_properties cmdProps = 0;
-				p_devicePool.back()->createCmdQueue(cmdProps);
+			if (typeIdx++ == p_contextDesc.getPrimaryDeviceIndex())
+			{
+				p_primaryDeviceIdx = deviceIdx;
+				break;
 			}
 		}
 
+		if (p_primaryDeviceIdx == p_devicePool.size())
+		{
+			p_primaryDeviceIdx = 0;
+			std::string _logInfo_ = LOG_HEADER() + " NO OPENCL DEVICE FOR THE REQUESTED PRIMARY DEVICE TYPE/INDEX.";
+			LOG_ERROR(_logInfo_);
+			return CL_DEVICE_NOT_FOUND;
+		}
+
 		return clResult;
 	}
 
 	int Manager::initKernelsFromSource(std::vector< char const* > const& sources, std::string const& kernelnamespace /*= "global"*/)
 	{
-		cl_int clResult = CL_SUCCESS;
-		
-		std::vector< std::pair<char const*, size_t> > progSources;
+		return pQueueProgramBuild(kernelnamespace, sources, std::string());
+	}
+
+	int Manager::initKernelsFromIL(std::string const& ilFile, std::vector< char const* > const& fallbackSources, std::string const& kernelnamespace /*= "global"*/)
+	{
+		return pQueueProgramBuild(kernelnamespace, fallbackSources, ilFile);
+	}
+
+	std::shared_future<int> Manager::getKernelsReady(std::string const& kernelnamespace)
+	{
+		std::lock_guard<std::mutex> lock(p_buildMutex);
+		auto pBuild = p_programBuilds.find(kernelnamespace);
+		if (pBuild != p_programBuilds.end())
+			return pBuild->second;
+
+		std::promise<int> unknown;
+		unknown.set_value(CL_INVALID_VALUE);
+		return unknown.get_future().share();
+	}
+
+	cl_int Manager::waitKernels(std::string const& kernelnamespace)
+	{
+		std::shared_future<int> build = getKernelsReady(kernelnamespace);
+		cl_int clResult = build.get();
+		if (clResult != CL_SUCCESS)
+		{
+			std::string _logInfo_ = LOG_HEADER() + " KERNELS NOT AVAILABLE FOR NAMESPACE: " + kernelnamespace + " (error " + std::to_string(clResult) + ")";
+			LOG_ERROR(_logInfo_);
+		}
+
+		return clResult;
+	}
+
+	cl_int Manager::pQueueProgramBuild(std::string const& kernelnamespace, std::vector< char const* > const& sources, std::string const& ilFile)
+	{
+		// the inputs are validated before the call returns, only the device builds run on the worker thread
+		std::vector< std::string > programSources;
+		for (char const* pSource : sources)
+		{
+			if (pSource && *pSource)
+				programSources.push_back(pSource);
+		}
+
+		std::vector< char > il;
+		if (ilFile.size())
+		{
+			std::ifstream fileStream(ilFile, std::ios::ate | std::ios::binary);
+			if (fileStream.is_open())
+			{
+				il.resize(static_cast<size_t>(fileStream.tellg()));
+				fileStream.seekg(0);
+				fileStream.read(il.data(), il.size());
+				fileStream.close();
+			}
 
-		for (auto pSource : sources)
+			if (il.empty())
+			{
+				std::string _logInfo_ = LOG_HEADER() + " IL MODULE NOT FOUND: " + ilFile;
+				if (programSources.empty())
+				{
+					_logInfo_ += " (no fallback sources for namespace: " + kernelnamespace + ")";
+					LOG_ERROR(_logInfo_);
+					return CL_INVALID_PROGRAM;
+				}
+				LOG_MESSAGE(_logInfo_);
+			}
+		}
+		else if (programSources.empty())
 		{
-			progSources.push_back(std::pair<char const*, size_t>(pSource, strlen(pSource)));
+			std::string _logInfo_ = LOG_HEADER() + " NO KERNEL SOURCES FOR NAMESPACE: " + kernelnamespace;
+			LOG_ERROR(_logInfo_);
+			return CL_INVALID_VALUE;
 		}
 
-		p_devicePool.back()->createProgram(kernelnamespace, progSources);
+		// a namespace initialized again replaces its program. The lookup and the swap are one critical
+		// section, the new build is chained after the pending one (builds of a namespace run in call order).
+		std::lock_guard<std::mutex> lock(p_buildMutex);
+		std::shared_future<int> pending;
+		auto pBuild = p_programBuilds.find(kernelnamespace);
+		if (pBuild != p_programBuilds.end())
+			pending = pBuild->second;
+
+		p_programBuilds[kernelnamespace] = std::async(std::launch::async,
+			[this, kernelnamespace, pending, programSources = std::move(programSources), il = std::move(il)]()
+		{
+			if (pending.valid())
+				pending.wait();
+
+			{
+				std::lock_guard<std::mutex> sourcesLock(p_buildMutex);
+				p_programSources[kernelnamespace] = programSources;
+			}
+
+			return static_cast<int>(pBuildNamespace(kernelnamespace, programSources, il));
+		}).share();
+
+		return CL_SUCCESS;
+	}
+
+	cl_int Manager::pBuildNamespace(std::string const& kernelnamespace, std::vector< std::string > const& sources, std::vector< char > const& il)
+	{
+		using clock = std::chrono::steady_clock;
+
+		cl_int clResult = CL_SUCCESS;
+
+		// the sources are the fallback of the devices without IL support and the base of the fused programs
+		bool usesPipes = USES_PIPES(sources);
+		std::vector< std::pair<char const*, size_t> > progSources;
+		if (sources.size())
+			APPEND_KERNEL_PRELUDES(progSources, usesPipes);
+		for (auto &pSource : sources)
+		{
+			progSources.push_back(std::pair<char const*, size_t>(pSource.c_str(), pSource.size()));
+		}
 
 		/*
 		---------------------------------------------
@@ -92,10 +326,182 @@ namespace opencl
 		-cl-unsafe-math-optimizations -cl-finite-math-only -cl-fast-relaxed-math
 		---------------------------------------------
 		*/
-		std::string buildOptions = "-cl-mad-enable";
-		clResult = p_devicePool.back()->buildProgram(kernelnamespace, buildOptions.c_str());
+		// every device has its own context, so the program is built once per device.
+		for (auto &pDevice : p_devicePool)
+		{
+			auto start = clock::now();
+			std::string buildOptions = pGetBuildOptions(pDevice.get(), usesPipes);
+
+			bool isBuiltFromIL = false;
+			if (il.size() && pDevice->getIsILSupported())
+			{
+				cl_int ilResult = pDevice->createProgramFromIL(kernelnamespace, il);
+				if (ilResult == CL_SUCCESS)
+					ilResult = pDevice->buildProgram(kernelnamespace, buildOptions.c_str());
+				if (ilResult == CL_SUCCESS)
+					ilResult = pDevice->createKernels(kernelnamespace);
+				if (ilResult == CL_SUCCESS)
+					pDevice->getProgram(kernelnamespace)->setSourceHash(ProgramCache::getSourceHash({ { il.data(), il.size() } }, buildOptions));
+
+				isBuiltFromIL = ilResult == CL_SUCCESS;
+				if (!isBuiltFromIL)
+				{
+					std::string _logInfo_ = LOG_HEADER() + " IL PROGRAM BUILD FAILED FOR NAMESPACE: " + kernelnamespace + " (error " + std::to_string(ilResult) + ")";
+					LOG_MESSAGE(_logInfo_);
+				}
+			}
+
+			if (!isBuiltFromIL)
+			{
+				if (progSources.empty())
+				{
+					std::string _logInfo_ = LOG_HEADER() + " NO IL SUPPORT AND NO FALLBACK SOURCES FOR NAMESPACE: " + kernelnamespace;
+					LOG_ERROR(_logInfo_);
+					clResult = CL_INVALID_PROGRAM;
+					continue;
+				}
+
+				cl_int buildResult = pBuildProgram(pDevice.get(), kernelnamespace, progSources, buildOptions);
+				if (buildResult != CL_SUCCESS)
+				{
+					std::string _logInfo_ = LOG_HEADER() + " PROGRAM BUILD FAILED FOR NAMESPACE: " + kernelnamespace;
+					LOG_ERROR(_logInfo_);
+					clResult = buildResult;
+					continue;
+				}
+			}
+
+			pLogProgramStartup(pDevice.get(), kernelnamespace, isBuiltFromIL ? "IL" : "SOURCE", std::chrono::duration<double, std::milli>(clock::now() - start).count());
+		}
+
+		if (p_programCache->isEnabled())
+		{
+			std::string _logInfo_ = "PROGRAM CACHE [" + kernelnamespace + "] HITS: " + std::to_string(p_programCache->getHitCount())
+				+ " MISSES: " + std::to_string(p_programCache->getMissCount())
+				+ " STARTUP TIME SAVED: " + std::to_string(p_programCache->getSavedMilliseconds()) + " ms";
+			LOG_MESSAGE(_logInfo_);
+		}
+
+		return clResult;
+	}
+
+	void Manager::pLogProgramStartup(Device* device, std::string const& kernelnamespace, std::string const& format, double milliseconds)
+	{
+		std::string _logInfo_ = "PROGRAM [" + kernelnamespace + "] FROM " + format
+			+ " DEVICE: " + device->getLogicalDevice().getInfo<CL_DEVICE_NAME>()
+			+ " STARTUP TIME: " + std::to_string(milliseconds) + " ms";
+		LOG_MESSAGE(_logInfo_);
+	}
+
+	cl_int Manager::buildFusedProgram(Device* device, std::string const& kernelnamespace, std::string const& fusedSource)
+	{
+		std::vector< std::string > sources;
+		{
+			std::lock_guard<std::mutex> lock(p_buildMutex);
+			auto pSources = p_programSources.find(kernelnamespace);
+			if (pSources == p_programSources.end())
+				return CL_INVALID_PROGRAM;
+
+			sources = pSources->second;
+		}
+
+		// the element functions are defined in the namespace sources
+		bool usesPipes = USES_PIPES(sources);
+		std::vector< std::pair<char const*, size_t> > progSources;
+		APPEND_KERNEL_PRELUDES(progSources, usesPipes);
+		for (auto &pSource : sources)
+		{
+			progSources.push_back(std::pair<char const*, size_t>(pSource.c_str(), pSource.size()));
+		}
+		progSources.push_back(std::pair<char const*, size_t>(fusedSource.c_str(), fusedSource.size()));
 
-		p_devicePool.back()->createKernels(kernelnamespace);
+		std::string fusedNamespace = kernelnamespace + COMPUTE_FUSED_NAMESPACE_SUFFIX;
+		cl_int clResult = pBuildProgram(device, fusedNamespace, progSources, pGetBuildOptions(device, usesPipes));
+		if (clResult != CL_SUCCESS)
+		{
+			std::string _logInfo_ = LOG_HEADER() + " FUSED PROGRAM BUILD FAILED FOR NAMESPACE: " + kernelnamespace;
+			LOG_ERROR(_logInfo_);
+			return clResult;
+		}
+
+		return clResult;
+	}
+
+	std::string Manager::pGetBuildOptions(Device* device, bool usesPipes) const
+	{
+		std::string options = COMPUTE_PROGRAM_BUILD_OPTIONS;
+
+		// native pipes are OpenCL C 2.0, else the ring buffer header layout, see COMPUTE_PIPE_PRELUDE
+		if (usesPipes && device->getIsPipeSupported())
+			options += " -cl-std=CL2.0 -D COMPUTE_PIPES_NATIVE";
+		else if (usesPipes)
+			options += " -D COMPUTE_PIPE_RING_HEADER=" + std::to_string(COMPUTE_PIPE_RING_HEADER) + " -D COMPUTE_PIPE_RING_OVERFLOW=" + std::to_string(COMPUTE_PIPE_RING_OVERFLOW);
+
+		// same predicate as the svm allocation of the eSharedVirtual buffers
+		if (device->getIsSVMSupported())
+			options += " -D COMPUTE_SVM_NATIVE";
+
+		return options;
+	}
+
+	cl_int Manager::pBuildProgram(Device* device, std::string const& kernelnamespace, std::vector< std::pair<char const*, size_t> > const& sources, std::string const& options)
+	{
+		using clock = std::chrono::steady_clock;
+
+		// identifies the program for the tuning database, the same for a cached and a source build
+		uint64_t sourceHash = ProgramCache::getSourceHash(sources, options);
+
+		uint64_t cacheKey = 0;
+		if (p_programCache->isEnabled())
+		{
+			cacheKey = p_programCache->getKey(sources, device->getLogicalDevice(), options);
+
+			std::vector<unsigned char> binary;
+			KernelArgInfoMap argInfo;
+			double buildMilliseconds = 0.0;
+			if (p_programCache->load(cacheKey, binary, argInfo, buildMilliseconds))
+			{
+				auto start = clock::now();
+				if (device->createProgramFromBinary(kernelnamespace, binary) == CL_SUCCESS &&
+					device->buildProgram(kernelnamespace, options.c_str()) == CL_SUCCESS &&
+					device->createKernels(kernelnamespace) == CL_SUCCESS)
+				{
+					// the arg names and qualifiers of the source build (kernel io, arg access, fusion)
+					device->getProgram(kernelnamespace)->setArgInfo(argInfo);
+					device->getProgram(kernelnamespace)->setSourceHash(sourceHash);
+
+					double loadMilliseconds = std::chrono::duration<double, std::milli>(clock::now() - start).count();
+					p_programCache->recordHit(std::max(buildMilliseconds - loadMilliseconds, 0.0));
+					return CL_SUCCESS;
+				}
+
+				// rejected binary (e.g. runtime update with the same version string), rebuilt from the sources
+				std::string _logInfo_ = LOG_HEADER() + " PROGRAM CACHE BINARY REJECTED FOR NAMESPACE: " + kernelnamespace;
+				LOG_MESSAGE(_logInfo_);
+			}
+
+			p_programCache->recordMiss();
+		}
+
+		auto start = clock::now();
+		device->createProgram(kernelnamespace, sources);
+		cl_int clResult = device->buildProgram(kernelnamespace, options.c_str());
+		double buildMilliseconds = std::chrono::duration<double, std::milli>(clock::now() - start).count();
+		if (clResult == CL_SUCCESS)
+			clResult = device->createKernels(kernelnamespace);
+		if (clResult == CL_SUCCESS)
+			device->getProgram(kernelnamespace)->setSourceHash(sourceHash);
+
+		if (clResult == CL_SUCCESS && p_programCache->isEnabled())
+		{
+			ProgramHandle program = device->getProgram(kernelnamespace);
+			std::vector<unsigned char> binary;
+			if (program->getBinary(binary) != CL_SUCCESS || !p_programCache->store(cacheKey, binary, program->getArgInfo(), buildMilliseconds))
+			{
+				std::string _logInfo_ = LOG_HEADER() + " PROGRAM CACHE STORE FAILED FOR NAMESPACE: " + kernelnamespace;
+				LOG_MESSAGE(_logInfo_);
+			}
+		}
 
 		return clResult;
 	}
@@ -115,6 +521,68 @@ namespace opencl
 		return p_execMgr->dispatch(payload);
 	}
 
+	int Manager::dispatchBatch(compute::DispatchPayload const* payloads, size_t count, bool fuseElementwise)
+	{
+		return p_execMgr->dispatchBatch(payloads, count, fuseElementwise);
+	}
+
+	int Manager::dispatchGraph(compute::GraphPayload const& payload)
+	{
+		return p_execMgr->dispatchGraph(payload);
+	}
+
+	int Manager::waitGraph()
+	{
+		return p_execMgr->waitGraph();
+	}
+
+	int Manager::addBuffer(compute::BufferDescription const& bufDesc)
+	{
+		return p_execMgr->addBuffer(bufDesc);
+	}
+
+	int Manager::removeBuffer(std::string const& tag)
+	{
+		return p_execMgr->removeBuffer(tag);
+	}
+
+	int Manager::addImage(compute::ImageDescription const& imgDesc)
+	{
+		return p_execMgr->addImage(imgDesc);
+	}
+
+	int Manager::removeImage(std::string const& tag)
+	{
+		return p_execMgr->removeImage(tag);
+	}
+
+	int Manager::addDispatch(compute::DispatchDescription const& dispatchDesc)
+	{
+		return p_execMgr->addDispatch(dispatchDesc);
+	}
+
+	int Manager::removeDispatch(std::string const& tag)
+	{
+		return p_execMgr->removeDispatch(tag);
+	}
+
+	int Manager::getTimingStats(std::vector< compute::TimingStats >& stats)
+	{
+		if (!p_profiler)
+			return CL_INVALID_OPERATION;
+
+		p_profiler->getStats(stats);
+		return CL_SUCCESS;
+	}
+
+	int Manager::dumpTimingStats(std::string const& path)
+	{
+		if (!p_profiler)
+			return CL_INVALID_OPERATION;
+
+		return p_profiler->dumpJson(path);
+	}
+
 	bool Manager::pCheckDeviceMinRequirements(cl::Device* oclDevice, DeviceProfile profile /*= DeviceProfile::eGPGPU*/)
 	{
 		bool reqAvailable = true;
@@ -135,6 +603,24 @@ namespace opencl
 				return false;
 		}
 		break;
+		case DeviceProfile::eGeneral:
+		{
+			/* cpu runtimes (e.g. PoCL) - image support is optional, kernels without images still run */
+			std::string profile = oclDevice->getInfo<CL_DEVICE_PROFILE>();
+			if (strcmp(profile.c_str(), "FULL_PROFILE"))
+				return false;
+
+			if (!oclDevice->getInfo<CL_DEVICE_AVAILABLE>())
+				return false;
+
+			if (!oclDevice->getInfo<CL_DEVICE_COMPILER_AVAILABLE>())
+				return false;
+
+			uint64_t addressbit = oclDevice->getInfo<CL_DEVICE_ADDRESS_BITS>();
+			if (addressbit != 64)
+				return false;
+		}
+		break;
 		default:
 			assert(0);
 		}
@@ -142,4 +628,71 @@ namespace opencl
 		return reqAvailable;
 	}
 
+	void Manager::pAddDevices(cl_device_type clDeviceType, device::DeviceType deviceType, DeviceProfile profile)
+	{
+		for (auto &pPlatform : p_clPlatforms)
+		{
+			// CL_DEVICE_NOT_FOUND is a valid result here, platforms rarely expose both device types.
+			std::vector< cl::Device > devices;
+			if (pPlatform.getDevices(clDeviceType, &devices) != CL_SUCCESS)
+				continue;
+
+			// create a single primary context and the command queues per device
+			for (auto &pDevice : devices)
+			{
+				if (!pCheckDeviceMinRequirements(&pDevice, profile))
+					continue;
+
+				// numa sub-devices are independent devices (context, queues, memory pools)
+				std::vector< cl::Device > logicalDevices;
+				if (!(profile == DeviceProfile::eGeneral && p_contextDesc.getIsNumaFission() && pPartitionNuma(pDevice, logicalDevices)))
+					logicalDevices.assign(1, pDevice);
+
+				for (size_t idx = 0; idx < logicalDevices.size(); ++idx)
+				{
+					p_devicePool.push_back(std::make_shared< Device >(s_deviceIdxCounter, deviceType, logicalDevices[idx], profile));
+					++s_deviceIdxCounter;
+					cl_context_properties contextProps[] = { CL_CONTEXT_PLATFORM, (cl_context_properties)pPlatform(), 0 };
+					p_devicePool.back()->createContext(contextProps);
+
+					cl_command_queue_properties cmdProps = p_contextDesc.getIsProfiling() ? CL_QUEUE_PROFILING_ENABLE : 0;
+					p_devicePool.back()->createCmdQueues(cmdProps, p_contextDesc.getIsOutOfOrderCompute());
+
+					std::string deviceName = pDevice.getInfo<CL_DEVICE_NAME>();
+					if (logicalDevices.size() > 1)
+						deviceName += " [NUMA NODE " + std::to_string(idx) + "]";
+
+					LOG_MESSAGE("OPENCL DEVICE ADDED: " + deviceName);
+				}
+			}
+		}
+	}
+
+	bool Manager::pPartitionNuma(cl::Device& clDevice, std::vector< cl::Device >& subDevices)
+	{
+		if (clDevice.getInfo<CL_DEVICE_PARTITION_MAX_SUB_DEVICES>() < 2)
+			return false;
+
+		cl_device_affinity_domain domains = clDevice.getInfo<CL_DEVICE_PARTITION_AFFINITY_DOMAIN>();
+		if (!(domains & CL_DEVICE_AFFINITY_DOMAIN_NUMA))
+			return false;
+
+		const cl_device_partition_property partitionProps[] =
+		{
+			CL_DEVICE_PARTITION_BY_AFFINITY_DOMAIN,
+			CL_DEVICE_AFFINITY_DOMAIN_NUMA,
+			0
+		};
+
+		if (clDevice.createSubDevices(partitionProps, &subDevices) != CL_SUCCESS)
+		{
+			std::string _logInfo_ = LOG_HEADER() + " NUMA PARTITION FAILED FOR DEVICE: " + clDevice.getInfo<CL_DEVICE_NAME>();
+			LOG_ERROR(_logInfo_);
+			return false;
+		}
+
+		// a single numa node, nothing to split
+		return subDevices.size() > 1;
+	}
+
 } // end namespace opencl
\ No newline at end of file
@@ -35,16 +35,44 @@ namespace opencl
 
         COMPUTE_API virtual int getDeviceCount(size_t& count) const override;
 
-        COMPUTE_API virtual int initContextandDevices() override;
+        COMPUTE_API virtual int getPrimaryDeviceInfo(compute::DeviceInfo& info) const override;
+
+        COMPUTE_API virtual int initContextandDevices(compute::ContextDescription const& contextDesc = compute::ContextDescription()) override;
 
         COMPUTE_API virtual int initKernelsFromSource(std::vector< char const* > const& sources, std::string const& kernelnamespace = "global") override;
 
+        COMPUTE_API virtual int initKernelsFromIL(std::string const& ilFile, std::vector< char const* > const& fallbackSources, std::string const& kernelnamespace = "global") override;
+
+        COMPUTE_API virtual std::shared_future<int> getKernelsReady(std::string const& kernelnamespace) override;
+
         COMPUTE_API virtual int initKernel(std::string const& kernelCode, std::string const& kernelName) override;
 
         COMPUTE_API virtual int initApplicationComputePipeline(compute::AppComputePipelineHandle& appComputePipeline) override;
 
         COMPUTE_API virtual int dispatch(compute::DispatchPayload const& payload) override;
 
+        COMPUTE_API virtual int dispatchBatch(compute::DispatchPayload const* payloads, size_t count, bool fuseElementwise = false) override;
+
+        COMPUTE_API virtual int dispatchGraph(compute::GraphPayload const& payload) override;
+
+        COMPUTE_API virtual int waitGraph() override;
+
+        COMPUTE_API virtual int addBuffer(compute::BufferDescription const& bufDesc) override;
+
+        COMPUTE_API virtual int removeBuffer(std::string const& tag) override;
+
+        COMPUTE_API virtual int addImage(compute::ImageDescription const& imgDesc) override;
+
+        COMPUTE_API virtual int removeImage(std::string const& tag) override;
+
+        COMPUTE_API virtual int addDispatch(compute::DispatchDescription const& dispatchDesc) override;
+
+        COMPUTE_API virtual int removeDispatch(std::string const& tag) override;
+
+        COMPUTE_API virtual int getTimingStats(std::vector< compute::TimingStats >& stats) override;
+
+        COMPUTE_API virtual int dumpTimingStats(std::string const& path) override;
+
 		inline ExecutionManager* getExecManager() const
 		{
 			return p_execMgr.get();
@@ -60,6 +88,31 @@ namespace opencl
 			return p_devicePool.at(p_primaryDeviceIdx).get();
 		}
 
+		inline DevicePool const& getDevicePool() const
+		{
+			return p_devicePool;
+		}
+
+		inline TuningDatabase* getTuningDatabase() const
+		{
+			return p_tuningDb.get();
+		}
+
+		/* blocks till the namespace is built, logs a failed build */
+		cl_int waitKernels(std::string const& kernelnamespace);
+
+		/*
+		* program of the namespace sources + the generated fused kernels (see DispatchDescription::setElementwiseFunction),
+		* built with the same options as the namespace so the fused kernels compute the same results.
+		*/
+		cl_int buildFusedProgram(Device* device, std::string const& kernelnamespace, std::string const& fusedSource);
+
+		/* nullptr if profiling is disabled, see ContextDescription::setIsProfiling */
+		inline Profiler* getProfiler() const
+		{
+			return p_profiler.get();
+		}
+
 		inline void LOG_ERROR(std::string const& trace)
 		{
 			p_cAppManager->COMPUTE_LOGERROR(trace);
@@ -74,19 +127,53 @@ namespace opencl
 
 		bool pCheckDeviceMinRequirements(cl::Device* oclDevice, DeviceProfile profile = DeviceProfile::eGPGPU);
 
+		/* enumerate devices of the given type on all platforms and add the ones meeting the profile requirements */
+		void pAddDevices(cl_device_type clDeviceType, device::DeviceType deviceType, DeviceProfile profile);
+
+		/* sub-devices per numa node (CL_DEVICE_AFFINITY_DOMAIN_NUMA), false if the device can't be or needn't be split */
+		bool pPartitionNuma(cl::Device& clDevice, std::vector< cl::Device >& subDevices);
+
+		/*
+		* the sources and the IL module are read and validated synchronously (CL_INVALID_VALUE - no sources,
+		* CL_INVALID_PROGRAM - IL module unreadable and no fallback), the namespace is then built on a worker
+		* thread chained after its pending build, see getKernelsReady
+		*/
+		cl_int pQueueProgramBuild(std::string const& kernelnamespace, std::vector< char const* > const& sources, std::string const& ilFile);
+
+		/* worker thread | IL module (if any and supported) or the sources on every device */
+		cl_int pBuildNamespace(std::string const& kernelnamespace, std::vector< std::string > const& sources, std::vector< char > const& il);
+
+		/* COMPUTE_PROGRAM_BUILD_OPTIONS + OpenCL C 2.0 and native pipes or the ring header layout (usesPipes) / svm links on the devices supporting them */
+		std::string pGetBuildOptions(Device* device, bool usesPipes) const;
+
+		/* program and kernels for the device from the program cache (if valid, with the cached arg info) or from the sources */
+		cl_int pBuildProgram(Device* device, std::string const& kernelnamespace, std::vector< std::pair<char const*, size_t> > const& sources, std::string const& options);
+
+		/* build + kernel creation time of a program, source vs IL startup comparison */
+		void pLogProgramStartup(Device* device, std::string const& kernelnamespace, std::string const& format, double milliseconds);
+
 	protected:
 		compute::I_ComputeAppManager*	p_cAppManager;
 		device::HostPtr				p_hostPtr;
 		device::DeviceApiType			p_apiType{ device::DeviceApiType::eOPENCL };
 
+		compute::ContextDescription	p_contextDesc;
+
 		ExecMgrHandle					p_execMgr;
 		ResourceMgrHandle				p_resourceMgr;
+		ProgramCacheHandle				p_programCache;
+		TuningDbHandle					p_tuningDb;
+		ProfilerHandle					p_profiler;
 
-		cl::Platform					p_clPlatform;
+		std::vector< cl::Platform >		p_clPlatforms;
+		std::map< std::string, std::vector< std::string > >	p_programSources; /* namespace -> sources, for the fused programs */
 
 		static uint32_t					s_deviceIdxCounter;
 		uint32_t						p_primaryDeviceIdx{ 0 };
 		DevicePool						p_devicePool;
+
+		std::mutex						p_buildMutex; /* p_programSources, p_programBuilds */
+		std::map< std::string, std::shared_future<int> >	p_programBuilds; /* last member, pending builds finish before the devices are released */
 	};
 
 
@@ -0,0 +1,175 @@
+/*
+* ---------------------------------------------------------
+* Copyright 2018-present (c) Automatos Studios. All Rights Reserved.
+* ---------------------------------------------------------
+*/
+
+/**
+* @file			oclMemoryPool.cpp
+* @author		cosmoplankton < cosmoplankton@automatos.studio >
+*/
+
+
+#include "oclDevice.h"
+#include "oclMemoryPool.h"
+
+
+namespace opencl
+{
+	static inline size_t ALIGN_UP(size_t size, size_t alignment)
+	{
+		return ((size + alignment - 1) / alignment) * alignment;
+	}
+
+
+	MemoryPool::MemoryPool(Device* device, cl_mem_flags flags)
+		: p_device(device)
+		, p_flags(flags)
+	{
+		cl::Device clDevice = p_device->getLogicalDevice();
+
+		// CL_DEVICE_MEM_BASE_ADDR_ALIGN is in bits
+		p_alignment = std::max<size_t>(clDevice.getInfo<CL_DEVICE_MEM_BASE_ADDR_ALIGN>() / 8, 1);
+		p_slabSize = ALIGN_UP(std::min<size_t>(COMPUTE_BUFFER_POOL_SLAB_SIZE, clDevice.getInfo<CL_DEVICE_MAX_MEM_ALLOC_SIZE>()), p_alignment);
+	}
+
+	cl_int MemoryPool::allocate(size_t size, cl::Buffer& subBuffer, PoolAllocation& allocation)
+	{
+		cl_int clResult = CL_SUCCESS;
+
+		std::lock_guard<std::mutex> lock(p_mutex);
+
+		size_t alignedSize = ALIGN_UP(std::max<size_t>(size, 1), p_alignment);
+
+		// first fit over the existing slabs
+		size_t slabIdx = 0;
+		size_t offset = 0;
+		for (; slabIdx < p_slabs.size(); ++slabIdx)
+		{
+			if (pAllocateFromSlab(slabIdx, alignedSize, offset))
+				break;
+		}
+
+		if (slabIdx == p_slabs.size())
+		{
+			clResult = pAddSlab(alignedSize);
+			if (clResult != CL_SUCCESS)
+				return clResult;
+
+			pAllocateFromSlab(slabIdx, alignedSize, offset);
+		}
+
+		// the access flags only, host ptr flags are inherited from the slab
+		cl_buffer_region region = { offset, alignedSize };
+		cl_mem_flags accessFlags = p_flags & (CL_MEM_READ_WRITE | CL_MEM_WRITE_ONLY | CL_MEM_READ_ONLY);
+		subBuffer = p_slabs[slabIdx].buffer.createSubBuffer(accessFlags, CL_BUFFER_CREATE_TYPE_REGION, &region, &clResult);
+		if (clResult != CL_SUCCESS)
+		{
+			pRelease(PoolAllocation{ slabIdx, offset, alignedSize });
+			return clResult;
+		}
+
+		allocation.slabIdx = slabIdx;
+		allocation.offset = offset;
+		allocation.size = alignedSize;
+		++p_allocationCount;
+
+		return clResult;
+	}
+
+	void MemoryPool::release(PoolAllocation const& allocation)
+	{
+		std::lock_guard<std::mutex> lock(p_mutex);
+
+		pRelease(allocation);
+		--p_allocationCount;
+	}
+
+	void MemoryPool::pRelease(PoolAllocation const& allocation)
+	{
+		auto& freeBlocks = p_slabs.at(allocation.slabIdx).freeBlocks;
+		size_t offset = allocation.offset;
+		size_t size = allocation.size;
+
+		// coalesce with the next free block
+		auto next = freeBlocks.lower_bound(offset);
+		if (next != freeBlocks.end() && offset + size == next->first)
+		{
+			size += next->second;
+			next = freeBlocks.erase(next);
+		}
+
+		// coalesce with the previous free block
+		if (next != freeBlocks.begin())
+		{
+			auto prev = std::prev(next);
+			if (prev->first + prev->second == offset)
+			{
+				prev->second += size;
+				return;
+			}
+		}
+
+		freeBlocks[offset] = size;
+	}
+
+	MemoryPoolStats MemoryPool::getStats() const
+	{
+		std::lock_guard<std::mutex> lock(p_mutex);
+
+		MemoryPoolStats stats;
+		stats.slabCount = p_slabs.size();
+		stats.allocationCount = p_allocationCount;
+		for (auto &pSlab : p_slabs)
+		{
+			stats.reservedBytes += pSlab.size;
+			for (auto &pBlock : pSlab.freeBlocks)
+			{
+				stats.freeBytes += pBlock.second;
+				stats.largestFreeBlock = std::max(stats.largestFreeBlock, pBlock.second);
+				++stats.freeBlockCount;
+			}
+		}
+		stats.allocatedBytes = stats.reservedBytes - stats.freeBytes;
+
+		return stats;
+	}
+
+	cl_int MemoryPool::pAddSlab(size_t minSize)
+	{
+		cl_int clResult = CL_SUCCESS;
+
+		Slab slab;
+		slab.size = std::max(p_slabSize, minSize);
+		slab.buffer = cl::Buffer(p_device->getContext(), p_flags, slab.size, nullptr, &clResult);
+		if (clResult != CL_SUCCESS)
+			return clResult;
+
+		slab.freeBlocks[0] = slab.size;
+		p_slabs.push_back(slab);
+
+		return clResult;
+	}
+
+	bool MemoryPool::pAllocateFromSlab(size_t slabIdx, size_t size, size_t& offset)
+	{
+		auto& freeBlocks = p_slabs[slabIdx].freeBlocks;
+		for (auto pBlock = freeBlocks.begin(); pBlock != freeBlocks.end(); ++pBlock)
+		{
+			if (pBlock->second < size)
+				continue;
+
+			// block offsets and sizes are multiples of the alignment, the remainder stays aligned
+			offset = pBlock->first;
+			size_t remainder = pBlock->second - size;
+			freeBlocks.erase(pBlock);
+			if (remainder)
+				freeBlocks[offset + size] = remainder;
+
+			return true;
+		}
+
+		return false;
+	}
+
+} // end namespace opencl
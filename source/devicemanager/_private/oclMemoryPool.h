@@ -0,0 +1,128 @@
+/*
+* ---------------------------------------------------------
+* Copyright 2018-present (c) Automatos Studios. All Rights Reserved.
+* ---------------------------------------------------------
+*/
+
+/**
+* @file			oclMemoryPool.h
+* @author		cosmoplankton < cosmoplankton@automatos.studio >
+*/
+
+
+#ifndef OPENCL_MEMORY_POOL
+#define OPENCL_MEMORY_POOL
+
+#include "oclDefines.h"
+
+
+namespace opencl
+{
+
+	/**
+	* @struct	PoolAllocation
+	* @brief	Region of a pool slab assigned to a buffer.
+	*/
+	struct PoolAllocation
+	{
+		size_t slabIdx{ 0 };
+		size_t offset{ 0 };
+		size_t size{ 0 };
+	};
+
+
+	/**
+	* @struct	MemoryPoolStats
+	* @brief	Occupancy and fragmentation of the pool slabs.
+	*/
+	struct MemoryPoolStats
+	{
+		size_t slabCount{ 0 };
+		size_t allocationCount{ 0 };
+		size_t reservedBytes{ 0 };		/* total size of the slabs */
+		size_t allocatedBytes{ 0 };		/* aligned size of the live allocations */
+		size_t freeBytes{ 0 };
+		size_t freeBlockCount{ 0 };
+		size_t largestFreeBlock{ 0 };
+
+		/* 0 - all the free memory is one block, -> 1 free memory is scattered in small blocks */
+		inline double getFragmentation() const
+		{
+			return freeBytes ? 1.0 - static_cast<double>(largestFreeBlock) / static_cast<double>(freeBytes) : 0.0;
+		}
+
+		inline MemoryPoolStats& operator += (MemoryPoolStats const& other)
+		{
+			slabCount += other.slabCount;
+			allocationCount += other.allocationCount;
+			reservedBytes += other.reservedBytes;
+			allocatedBytes += other.allocatedBytes;
+			freeBytes += other.freeBytes;
+			freeBlockCount += other.freeBlockCount;
+			largestFreeBlock = std::max(largestFreeBlock, other.largestFreeBlock);
+			return *this;
+		}
+	};
+
+
+	/**
+	* @class	MemoryPool
+	* @brief	Slab allocator of the buffers of a device (one pool per device and cl_mem_flags).
+	*--------------------------------------------------------------------------
+	* Buffers are sub-buffers carved out of a few large device buffers (slabs), so many small
+	* buffers don't pay the per allocation driver cost. Regions are aligned to CL_DEVICE_MEM_BASE_ADDR_ALIGN
+	* (required for the sub-buffer origin), free regions are kept in a per slab first-fit free list
+	* and coalesced with their neighbours on release.
+	*--------------------------------------------------------------------------
+	*/
+	class MemoryPool
+	{
+	public:
+		MemoryPool(Device* device, cl_mem_flags flags);
+
+		inline size_t getAlignment() const
+		{
+			return p_alignment;
+		}
+
+		/* allocations above this size should get a standalone buffer */
+		inline size_t getMaxAllocationSize() const
+		{
+			return p_slabSize / COMPUTE_BUFFER_POOL_MAX_ALLOCATION_DIVISOR;
+		}
+
+		cl_int allocate(size_t size, cl::Buffer& subBuffer, PoolAllocation& allocation);
+
+		void release(PoolAllocation const& allocation);
+
+		MemoryPoolStats getStats() const;
+
+	protected:
+		struct Slab
+		{
+			cl::Buffer					buffer;
+			size_t						size{ 0 };
+			std::map<size_t, size_t>	freeBlocks;		/* offset -> size, ordered by offset for coalescing */
+		};
+
+		cl_int pAddSlab(size_t minSize);
+
+		bool pAllocateFromSlab(size_t slabIdx, size_t size, size_t& offset);
+
+		/* returns the region to the slab free list (coalesced), the caller holds the lock */
+		void pRelease(PoolAllocation const& allocation);
+
+	protected:
+		Device*					p_device{ nullptr };
+		cl_mem_flags			p_flags{ 0 };
+		size_t					p_alignment{ 1 };
+		size_t					p_slabSize{ 0 };
+		size_t					p_allocationCount{ 0 };
+		std::vector< Slab >		p_slabs;
+		mutable std::mutex		p_mutex;
+	};
+
+} // end namespace opencl
+
+
+#endif // !OPENCL_MEMORY_POOL
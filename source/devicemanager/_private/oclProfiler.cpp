@@ -0,0 +1,201 @@
+/*
+* ---------------------------------------------------------
+* Copyright 2018-present (c) Automatos Studios. All Rights Reserved.
+* ---------------------------------------------------------
+*/
+
+/**
+* @file			oclProfiler.cpp
+* @author		cosmoplankton < cosmoplankton@automatos.studio >
+*/
+
+
+#include <fstream>
+
+#include "oclProfiler.h"
+
+
+namespace opencl
+{
+	static char const* GET_TRANSFER_NAME(cl_command_type commandType)
+	{
+		switch (commandType)
+		{
+		case CL_COMMAND_READ_BUFFER:		return "READ_BUFFER";
+		case CL_COMMAND_WRITE_BUFFER:		return "WRITE_BUFFER";
+		case CL_COMMAND_COPY_BUFFER:		return "COPY_BUFFER";
+		case CL_COMMAND_READ_IMAGE:			return "READ_IMAGE";
+		case CL_COMMAND_WRITE_IMAGE:		return "WRITE_IMAGE";
+		case CL_COMMAND_COPY_IMAGE:			return "COPY_IMAGE";
+		case CL_COMMAND_MAP_BUFFER:			return "MAP_BUFFER";
+		case CL_COMMAND_MAP_IMAGE:			return "MAP_IMAGE";
+		case CL_COMMAND_UNMAP_MEM_OBJECT:	return "UNMAP_MEM_OBJECT";
+		default:							return "TRANSFER";
+		}
+	}
+
+	/* nearest rank percentiles of the window */
+	static compute::TimingPercentiles GET_PERCENTILES(std::vector< double > samples)
+	{
+		compute::TimingPercentiles percentiles;
+		if (samples.empty())
+			return percentiles;
+
+		std::sort(samples.begin(), samples.end());
+		auto rank = [&samples](double p) { return samples[static_cast<size_t>(p * (samples.size() - 1) + 0.5)]; };
+		percentiles.p50 = rank(0.50);
+		percentiles.p95 = rank(0.95);
+		percentiles.p99 = rank(0.99);
+		percentiles.max = samples.back();
+
+		return percentiles;
+	}
+
+	static void PUSH_SAMPLE(std::vector< double >& window, size_t count, double sample)
+	{
+		if (window.size() < COMPUTE_PROFILING_WINDOW)
+			window.push_back(sample);
+		else
+			window[count % COMPUTE_PROFILING_WINDOW] = sample;
+	}
+
+	static std::string JSON_ESCAPE(std::string const& text)
+	{
+		std::string escaped;
+		for (char c : text)
+		{
+			if (c == '"' || c == '\\')
+				escaped += '\\';
+			escaped += c;
+		}
+		return escaped;
+	}
+
+	static void JSON_PERCENTILES(std::ofstream& out, char const* name, compute::TimingPercentiles const& percentiles)
+	{
+		out << "\"" << name << "\": { \"p50\": " << percentiles.p50
+			<< ", \"p95\": " << percentiles.p95
+			<< ", \"p99\": " << percentiles.p99
+			<< ", \"max\": " << percentiles.max << " }";
+	}
+
+
+	void Profiler::record(std::string const& tag, cl::Event const& event)
+	{
+		pRecord(tag, false, event);
+	}
+
+	void Profiler::recordTransfer(cl::Event const& event)
+	{
+		pRecord(GET_TRANSFER_NAME(event.getInfo<CL_EVENT_COMMAND_TYPE>()), true, event);
+	}
+
+	void Profiler::pRecord(std::string const& tag, bool isTransfer, cl::Event const& event)
+	{
+		std::lock_guard<std::mutex> lock(p_mutex);
+
+		PendingSample sample;
+		sample.tag = tag;
+		sample.isTransfer = isTransfer;
+		sample.event = event;
+		p_pending.push_back(sample);
+
+		if (p_pending.size() >= COMPUTE_PROFILING_MAX_PENDING)
+			pCollect(false);
+	}
+
+	void Profiler::pCollect(bool wait)
+	{
+		std::vector< PendingSample > stillPending;
+
+		for (auto &pSample : p_pending)
+		{
+			if (wait)
+				pSample.event.wait();
+
+			cl_int status = pSample.event.getInfo<CL_EVENT_COMMAND_EXECUTION_STATUS>();
+			if (status > CL_COMPLETE)
+			{
+				stillPending.push_back(pSample);
+				continue;
+			}
+
+			// failed commands (negative status) have no timestamps
+			if (status < CL_COMPLETE)
+				continue;
+
+			cl_ulong queued = 0, submit = 0, start = 0, end = 0;
+			if (pSample.event.getProfilingInfo(CL_PROFILING_COMMAND_QUEUED, &queued) != CL_SUCCESS
+				|| pSample.event.getProfilingInfo(CL_PROFILING_COMMAND_SUBMIT, &submit) != CL_SUCCESS
+				|| pSample.event.getProfilingInfo(CL_PROFILING_COMMAND_START, &start) != CL_SUCCESS
+				|| pSample.event.getProfilingInfo(CL_PROFILING_COMMAND_END, &end) != CL_SUCCESS)
+				continue;
+
+			// timestamps are in nanoseconds
+			Timing& timing = p_timings[pSample.tag];
+			timing.isTransfer = pSample.isTransfer;
+			PUSH_SAMPLE(timing.queuedMs, timing.count, static_cast<double>(submit - queued) * 1e-6);
+			PUSH_SAMPLE(timing.submitMs, timing.count, static_cast<double>(start - submit) * 1e-6);
+			PUSH_SAMPLE(timing.executionMs, timing.count, static_cast<double>(end - start) * 1e-6);
+			timing.totalMs += static_cast<double>(end - start) * 1e-6;
+			++timing.count;
+		}
+
+		p_pending.swap(stillPending);
+	}
+
+	void Profiler::getStats(std::vector< compute::TimingStats >& stats)
+	{
+		std::lock_guard<std::mutex> lock(p_mutex);
+
+		pCollect(true);
+
+		stats.clear();
+		for (auto &pTiming : p_timings)
+		{
+			compute::TimingStats timingStats;
+			timingStats.tag = pTiming.first;
+			timingStats.isTransfer = pTiming.second.isTransfer;
+			timingStats.count = pTiming.second.count;
+			timingStats.totalMs = pTiming.second.totalMs;
+			timingStats.queuedMs = GET_PERCENTILES(pTiming.second.queuedMs);
+			timingStats.submitMs = GET_PERCENTILES(pTiming.second.submitMs);
+			timingStats.executionMs = GET_PERCENTILES(pTiming.second.executionMs);
+			stats.push_back(timingStats);
+		}
+
+		// the dominating commands first
+		std::sort(stats.begin(), stats.end(), [](compute::TimingStats const& a, compute::TimingStats const& b) { return a.totalMs > b.totalMs; });
+	}
+
+	cl_int Profiler::dumpJson(std::string const& path)
+	{
+		std::vector< compute::TimingStats > stats;
+		getStats(stats);
+
+		std::ofstream out(path, std::ios::trunc);
+		if (!out)
+			return CL_INVALID_VALUE;
+
+		out << "{\n  \"timings\": [";
+		for (size_t idx = 0; idx < stats.size(); ++idx)
+		{
+			auto const& timingStats = stats[idx];
+			out << (idx ? ",\n" : "\n")
+				<< "    { \"tag\": \"" << JSON_ESCAPE(timingStats.tag) << "\""
+				<< ", \"transfer\": " << (timingStats.isTransfer ? "true" : "false")
+				<< ", \"count\": " << timingStats.count
+				<< ", \"totalMs\": " << timingStats.totalMs << ", ";
+			JSON_PERCENTILES(out, "queuedMs", timingStats.queuedMs);
+			out << ", ";
+			JSON_PERCENTILES(out, "submitMs", timingStats.submitMs);
+			out << ", ";
+			JSON_PERCENTILES(out, "executionMs", timingStats.executionMs);
+			out << " }";
+		}
+		out << "\n  ]\n}\n";
+
+		return out.good() ? CL_SUCCESS : CL_INVALID_VALUE;
+	}
+
+} // end namespace opencl
@@ -0,0 +1,81 @@
+/*
+* ---------------------------------------------------------
+* Copyright 2018-present (c) Automatos Studios. All Rights Reserved.
+* ---------------------------------------------------------
+*/
+
+/**
+* @file			oclProfiler.h
+* @author		cosmoplankton < cosmoplankton@automatos.studio >
+*/
+
+
+#ifndef OPENCL_PROFILER
+#define OPENCL_PROFILER
+
+#include "oclDefines.h"
+
+
+namespace opencl
+{
+
+	/**
+	* @class	Profiler
+	* @brief	Timings of the profiled dispatches and transfers (queues created with CL_QUEUE_PROFILING_ENABLE).
+	*--------------------------------------------------------------------------
+	* Commands are recorded with their event and collected once complete (the event
+	* timestamps QUEUED/SUBMIT/START/END), so recording never blocks the submission.
+	* Every timing keeps the last COMPUTE_PROFILING_WINDOW samples for the percentiles.
+	*--------------------------------------------------------------------------
+	*/
+	class Profiler
+	{
+	public:
+		Profiler()
+		{}
+
+		/* dispatch of the tagged execution node */
+		void record(std::string const& tag, cl::Event const& event);
+
+		/* transfer, tagged with the command type of the event (e.g. WRITE_BUFFER) */
+		void recordTransfer(cl::Event const& event);
+
+		/* blocks till the recorded commands complete */
+		void getStats(std::vector< compute::TimingStats >& stats);
+
+		cl_int dumpJson(std::string const& path);
+
+	protected:
+		struct PendingSample
+		{
+			std::string	tag;
+			bool		isTransfer{ false };
+			cl::Event	event;
+		};
+
+		/* rolling window of the samples of a timing */
+		struct Timing
+		{
+			bool					isTransfer{ false };
+			size_t					count{ 0 };
+			double					totalMs{ 0.0 };
+			std::vector< double >	queuedMs;
+			std::vector< double >	submitMs;
+			std::vector< double >	executionMs;
+		};
+
+		void pRecord(std::string const& tag, bool isTransfer, cl::Event const& event);
+
+		/* moves the completed (all if wait) pending samples to the timings, the caller holds the lock */
+		void pCollect(bool wait);
+
+	protected:
+		std::vector< PendingSample >		p_pending;
+		std::map< std::string, Timing >		p_timings;
+		std::mutex							p_mutex;
+	};
+
+} // end namespace opencl
+
+
+#endif // !OPENCL_PROFILER
@@ -21,6 +21,58 @@ namespace opencl
 		p_clProgram = cl::Program(p_Device->getContext(), sources);
 	}
 
+	cl_int Program::initProgramFromBinary(std::vector< unsigned char > const& binary)
+	{
+		cl_int clResult = CL_SUCCESS;
+		cl_int binaryStatus = CL_SUCCESS;
+
+		std::vector<cl_int> binaryStatusList;
+		cl::Program::Binaries binaries(1, std::make_pair(static_cast<const void*>(binary.data()), binary.size()));
+		p_clProgram = cl::Program(p_Device->getContext(), { p_Device->getLogicalDevice() }, binaries, &binaryStatusList, &clResult);
+
+		if (binaryStatusList.size())
+			binaryStatus = binaryStatusList[0];
+
+		return clResult != CL_SUCCESS ? clResult : binaryStatus;
+	}
+
+	/* cl_khr_il_program entrypoint, not declared by the OpenCL 1.2 headers */
+	typedef cl_program(CL_API_CALL *CREATE_PROGRAM_WITH_IL_KHR_FN)(cl_context, const void*, size_t, cl_int*);
+
+	cl_int Program::initProgramFromIL(std::vector< char > const& il)
+	{
+		cl_int clResult = CL_SUCCESS;
+
+		cl_platform_id platform = p_Device->getLogicalDevice().getInfo<CL_DEVICE_PLATFORM>();
+		auto createProgramWithIL = reinterpret_cast<CREATE_PROGRAM_WITH_IL_KHR_FN>(clGetExtensionFunctionAddressForPlatform(platform, "clCreateProgramWithILKHR"));
+		if (!createProgramWithIL)
+			return CL_INVALID_OPERATION;
+
+		cl_program program = createProgramWithIL(p_Device->getContext()(), il.data(), il.size(), &clResult);
+		if (clResult != CL_SUCCESS)
+			return clResult;
+
+		// the wrapper takes the ownership of the created program
+		p_clProgram = cl::Program(program);
+
+		return clResult;
+	}
+
+	cl_int Program::getBinary(std::vector< unsigned char >& binary) const
+	{
+		/* single device program | query through the C API, the cl.hpp CL_PROGRAM_BINARIES helper expects preallocated pointers */
+		size_t binarySize = 0;
+		cl_int clResult = clGetProgramInfo(p_clProgram(), CL_PROGRAM_BINARY_SIZES, sizeof(size_t), &binarySize, nullptr);
+		if (clResult != CL_SUCCESS || !binarySize)
+			return clResult != CL_SUCCESS ? clResult : CL_INVALID_PROGRAM_EXECUTABLE;
+
+		binary.resize(binarySize);
+		unsigned char* binaryPtr = binary.data();
+		clResult = clGetProgramInfo(p_clProgram(), CL_PROGRAM_BINARIES, sizeof(unsigned char*), &binaryPtr, nullptr);
+
+		return clResult;
+	}
+
 
 	cl_int Program::build
 	(
@@ -45,8 +97,31 @@ namespace opencl
 
 		for (auto &pKernel : kernels)
 		{
-			size_t _kernelHash = std::hash<std::string>{}(pKernel.getInfo<CL_KERNEL_FUNCTION_NAME>());
+			// some runtimes keep the null terminator in the info strings
+			std::string kernelName = pKernel.getInfo<CL_KERNEL_FUNCTION_NAME>().c_str();
+			size_t _kernelHash = std::hash<std::string>{}(kernelName);
 			p_clKernels[_kernelHash] = pKernel;
+
+			// no entry without the arg info (CL_KERNEL_ARG_INFO_NOT_AVAILABLE)
+			cl_uint argCount = pKernel.getInfo<CL_KERNEL_NUM_ARGS>();
+			std::vector< KernelArgInfo > argInfo(argCount);
+			cl_int infoResult = CL_SUCCESS;
+			for (cl_uint argIdx = 0; argIdx < argCount && infoResult == CL_SUCCESS; ++argIdx)
+			{
+				KernelArgInfo& info = argInfo[argIdx];
+				info.name = pKernel.getArgInfo<CL_KERNEL_ARG_NAME>(argIdx, &infoResult).c_str();
+				if (infoResult == CL_SUCCESS)
+					infoResult = pKernel.getArgInfo(argIdx, CL_KERNEL_ARG_ADDRESS_QUALIFIER, &info.addressQualifier);
+				if (infoResult == CL_SUCCESS)
+					infoResult = pKernel.getArgInfo(argIdx, CL_KERNEL_ARG_ACCESS_QUALIFIER, &info.accessQualifier);
+				if (infoResult == CL_SUCCESS)
+					infoResult = pKernel.getArgInfo(argIdx, CL_KERNEL_ARG_TYPE_QUALIFIER, &info.typeQualifier);
+				if (infoResult == CL_SUCCESS)
+					info.typeName = pKernel.getArgInfo<CL_KERNEL_ARG_TYPE_NAME>(argIdx, &infoResult).c_str();
+			}
+
+			if (infoResult == CL_SUCCESS)
+				p_argInfo[kernelName] = argInfo;
 		}
 
 		return clResult;
@@ -18,6 +18,20 @@
 namespace opencl
 {
 
+	/* CL_KERNEL_ARG_* info of a kernel arg (-cl-kernel-arg-info, a source build), the strings without a trailing null terminator */
+	struct KernelArgInfo
+	{
+		std::string							name;
+		cl_kernel_arg_address_qualifier		addressQualifier{ CL_KERNEL_ARG_ADDRESS_PRIVATE };
+		cl_kernel_arg_access_qualifier		accessQualifier{ CL_KERNEL_ARG_ACCESS_NONE };
+		cl_kernel_arg_type_qualifier		typeQualifier{ CL_KERNEL_ARG_TYPE_NONE };
+		std::string							typeName;
+	};
+
+	/* (kernel name, arg info of every arg) */
+	using KernelArgInfoMap = std::map< std::string, std::vector< KernelArgInfo > >;
+
+
 	class Program
 	{
 	public:
@@ -31,7 +45,21 @@ namespace opencl
 			return p_clKernels.at(std::hash<std::string>{}(kernelName));
 		}
 
+		inline bool hasKernel(std::string const& kernelName) const
+		{
+			return p_clKernels.find(std::hash<std::string>{}(kernelName)) != p_clKernels.end();
+		}
+
 		void initProgram(std::vector< std::pair<char const*, size_t> > const& sources);
+
+		/* program from a device binary (see ProgramCache), still has to be built */
+		cl_int initProgramFromBinary(std::vector< unsigned char > const& binary);
+
+		/* program from a SPIR-V module (cl_khr_il_program), still has to be built */
+		cl_int initProgramFromIL(std::vector< char > const& il);
+
+		/* CL_PROGRAM_BINARIES of the built program for the device */
+		cl_int getBinary(std::vector< unsigned char >& binary) const;
 		
 		cl_int build
 		(
@@ -42,10 +70,46 @@ namespace opencl
 
 		cl_int createKernels();
 
+		/*
+		* Arg info of the kernels, queried by createKernels. Programs created from a binary or from IL
+		* usually have none, the program cache restores the info of the source build with setArgInfo.
+		*/
+		inline std::vector< KernelArgInfo > const* getArgInfo(std::string const& kernelName) const
+		{
+			auto pArgInfo = p_argInfo.find(kernelName);
+			return pArgInfo != p_argInfo.end() ? &pArgInfo->second : nullptr;
+		}
+
+		inline KernelArgInfoMap const& getArgInfo() const
+		{
+			return p_argInfo;
+		}
+
+		inline void setArgInfo(KernelArgInfoMap const& argInfo)
+		{
+			for (auto &pKernelArgs : argInfo)
+			{
+				p_argInfo[pKernelArgs.first] = pKernelArgs.second;
+			}
+		}
+
+		/* ProgramCache::getSourceHash of the sources (or IL) and the build options, 0 if unknown */
+		inline uint64_t getSourceHash() const
+		{
+			return p_sourceHash;
+		}
+
+		inline void setSourceHash(uint64_t sourceHash)
+		{
+			p_sourceHash = sourceHash;
+		}
+
 	protected:
 		Device*			p_Device;
 		cl::Program		p_clProgram;
 		std::map<size_t, cl::Kernel> p_clKernels;
+		KernelArgInfoMap p_argInfo;
+		uint64_t		p_sourceHash{ 0 };
 	};
 
 
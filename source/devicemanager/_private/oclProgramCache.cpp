@@ -0,0 +1,210 @@
+/*
+* ---------------------------------------------------------
+* Copyright 2018-present (c) Automatos Studios. All Rights Reserved.
+* ---------------------------------------------------------
+*/
+
+/**
+* @file			oclProgramCache.cpp
+* @author		cosmoplankton < cosmoplankton@automatos.studio >
+*/
+
+
+#include <cstring>
+#include <sstream>
+#include <iomanip>
+
+#include "oclProgramCache.h"
+
+
+namespace opencl
+{
+	/* cache file header, followed by the program binary and the kernel arg info */
+	struct ProgramCacheHeader
+	{
+		char		magic[8];
+		uint32_t	version;
+		uint64_t	key;
+		double		buildMilliseconds;
+		uint64_t	binarySize;
+	};
+
+	static const char s_cacheMagic[8] = { 'S', 'O', 'F', 'T', 'E', 'C', 'L', 'B' };
+	static const uint32_t s_cacheVersion = 2;	/* 2: kernel arg info */
+
+	template<typename T>
+	static inline void WRITE_VALUE(std::ofstream& fileStream, T const& value)
+	{
+		fileStream.write(reinterpret_cast<const char*>(&value), sizeof(T));
+	}
+
+	template<typename T>
+	static inline bool READ_VALUE(std::ifstream& fileStream, T& value)
+	{
+		fileStream.read(reinterpret_cast<char*>(&value), sizeof(T));
+		return static_cast<bool>(fileStream);
+	}
+
+	static inline void WRITE_STRING(std::ofstream& fileStream, std::string const& str)
+	{
+		WRITE_VALUE(fileStream, static_cast<uint32_t>(str.size())); // #safecast
+		fileStream.write(str.data(), str.size());
+	}
+
+	static inline bool READ_STRING(std::ifstream& fileStream, std::string& str)
+	{
+		uint32_t size = 0;
+		if (!READ_VALUE(fileStream, size))
+			return false;
+
+		str.resize(size);
+		fileStream.read(&str[0], size);
+		return static_cast<bool>(fileStream);
+	}
+
+	/* kernel count, then per kernel: name, arg count, (name, address, access, type qualifier, type name) per arg */
+	static void WRITE_ARG_INFO(std::ofstream& fileStream, KernelArgInfoMap const& argInfo)
+	{
+		WRITE_VALUE(fileStream, static_cast<uint32_t>(argInfo.size())); // #safecast
+		for (auto &pKernelArgs : argInfo)
+		{
+			WRITE_STRING(fileStream, pKernelArgs.first);
+			WRITE_VALUE(fileStream, static_cast<uint32_t>(pKernelArgs.second.size())); // #safecast
+			for (auto &pArg : pKernelArgs.second)
+			{
+				WRITE_STRING(fileStream, pArg.name);
+				WRITE_VALUE(fileStream, pArg.addressQualifier);
+				WRITE_VALUE(fileStream, pArg.accessQualifier);
+				WRITE_VALUE(fileStream, pArg.typeQualifier);
+				WRITE_STRING(fileStream, pArg.typeName);
+			}
+		}
+	}
+
+	static bool READ_ARG_INFO(std::ifstream& fileStream, KernelArgInfoMap& argInfo)
+	{
+		uint32_t kernelCount = 0;
+		if (!READ_VALUE(fileStream, kernelCount))
+			return false;
+
+		for (uint32_t kernelIdx = 0; kernelIdx < kernelCount; ++kernelIdx)
+		{
+			std::string kernelName;
+			uint32_t argCount = 0;
+			if (!READ_STRING(fileStream, kernelName) || !READ_VALUE(fileStream, argCount))
+				return false;
+
+			std::vector< KernelArgInfo >& kernelArgs = argInfo[kernelName];
+			kernelArgs.resize(argCount);
+			for (auto &pArg : kernelArgs)
+			{
+				if (!READ_STRING(fileStream, pArg.name) ||
+					!READ_VALUE(fileStream, pArg.addressQualifier) ||
+					!READ_VALUE(fileStream, pArg.accessQualifier) ||
+					!READ_VALUE(fileStream, pArg.typeQualifier) ||
+					!READ_STRING(fileStream, pArg.typeName))
+					return false;
+			}
+		}
+
+		return true;
+	}
+
+
+	ProgramCache::ProgramCache(std::string const& directory)
+		: p_directory(directory)
+	{
+		if (!p_directory.empty() && p_directory.back() != '/' && p_directory.back() != '\\')
+		{
+			p_directory += '/';
+		}
+	}
+
+	uint64_t ProgramCache::getSourceHash(std::vector< std::pair<char const*, size_t> > const& sources, std::string const& options)
+	{
+		uint64_t hash = FNV_OFFSET_BASIS;
+
+		for (auto &pSource : sources)
+		{
+			FNV_HASH_BYTES(hash, pSource.first, pSource.second);
+		}
+
+		FNV_HASH_STRING(hash, options);
+
+		return hash;
+	}
+
+	uint64_t ProgramCache::getKey(std::vector< std::pair<char const*, size_t> > const& sources, cl::Device const& device, std::string const& options) const
+	{
+		uint64_t hash = getSourceHash(sources, options);
+
+		FNV_HASH_STRING(hash, device.getInfo<CL_DEVICE_NAME>());
+		FNV_HASH_STRING(hash, device.getInfo<CL_DEVICE_VENDOR>());
+		FNV_HASH_STRING(hash, device.getInfo<CL_DEVICE_VERSION>());
+		FNV_HASH_STRING(hash, device.getInfo<CL_DRIVER_VERSION>());
+
+		return hash;
+	}
+
+	bool ProgramCache::load(uint64_t key, std::vector< unsigned char >& binary, KernelArgInfoMap& argInfo, double& buildMilliseconds) const
+	{
+		if (!isEnabled())
+			return false;
+
+		// same sources on two devices of the same model share the entry
+		std::lock_guard<std::mutex> lock(p_mutex);
+		std::ifstream fileStream(pGetFilePath(key), std::ios::binary);
+		if (!fileStream.is_open())
+			return false;
+
+		ProgramCacheHeader header;
+		fileStream.read(reinterpret_cast<char*>(&header), sizeof(header));
+		if (!fileStream || memcmp(header.magic, s_cacheMagic, sizeof(s_cacheMagic)) || header.version != s_cacheVersion || header.key != key || !header.binarySize)
+			return false;
+
+		binary.resize(static_cast<size_t>(header.binarySize));
+		fileStream.read(reinterpret_cast<char*>(binary.data()), binary.size());
+		if (!fileStream)
+			return false;
+
+		argInfo.clear();
+		if (!READ_ARG_INFO(fileStream, argInfo))
+			return false;
+
+		buildMilliseconds = header.buildMilliseconds;
+
+		return true;
+	}
+
+	bool ProgramCache::store(uint64_t key, std::vector< unsigned char > const& binary, KernelArgInfoMap const& argInfo, double buildMilliseconds) const
+	{
+		if (!isEnabled() || !binary.size())
+			return false;
+
+		std::lock_guard<std::mutex> lock(p_mutex);
+		std::ofstream fileStream(pGetFilePath(key), std::ios::binary | std::ios::trunc);
+		if (!fileStream.is_open())
+			return false;
+
+		ProgramCacheHeader header;
+		memcpy(header.magic, s_cacheMagic, sizeof(s_cacheMagic));
+		header.version = s_cacheVersion;
+		header.key = key;
+		header.buildMilliseconds = buildMilliseconds;
+		header.binarySize = binary.size();
+
+		fileStream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		fileStream.write(reinterpret_cast<const char*>(binary.data()), binary.size());
+		WRITE_ARG_INFO(fileStream, argInfo);
+
+		return static_cast<bool>(fileStream);
+	}
+
+	std::string ProgramCache::pGetFilePath(uint64_t key) const
+	{
+		std::ostringstream path;
+		path << p_directory << std::hex << std::setw(16) << std::setfill('0') << key << ".clbin";
+		return path.str();
+	}
+
+} // end namespace opencl
@@ -0,0 +1,98 @@
+/*
+* ---------------------------------------------------------
+* Copyright 2018-present (c) Automatos Studios. All Rights Reserved.
+* ---------------------------------------------------------
+*/
+
+/**
+* @file			oclProgramCache.h
+* @author		cosmoplankton < cosmoplankton@automatos.studio >
+*/
+
+
+#ifndef OPENCL_PROGRAM_CACHE
+#define OPENCL_PROGRAM_CACHE
+
+#include "oclDefines.h"
+#include "oclProgram.h"
+
+
+namespace opencl
+{
+
+	/**
+	* @class	ProgramCache
+	* @brief	On-disk cache of the program binaries (CL_PROGRAM_BINARIES).
+	*--------------------------------------------------------------------------
+	* Entries are keyed by a hash of the program sources, device name, device/driver version
+	* and the build options, so a driver update or an option change is always a miss.
+	* Every entry stores the original source build time to report the startup time saved, and the
+	* kernel arg info of the source build (a program created from a binary usually reports none).
+	* An empty cache directory disables the cache.
+	*--------------------------------------------------------------------------
+	*/
+	class ProgramCache
+	{
+	public:
+		explicit ProgramCache(std::string const& directory);
+
+		inline bool isEnabled() const
+		{
+			return !p_directory.empty();
+		}
+
+		inline size_t getHitCount() const
+		{
+			std::lock_guard<std::mutex> lock(p_mutex);
+			return p_hitCount;
+		}
+
+		inline size_t getMissCount() const
+		{
+			std::lock_guard<std::mutex> lock(p_mutex);
+			return p_missCount;
+		}
+
+		inline double getSavedMilliseconds() const
+		{
+			std::lock_guard<std::mutex> lock(p_mutex);
+			return p_savedMilliseconds;
+		}
+
+		/* hash of the program sources and the build options, the same on every device (see TuningDatabase::getKey) */
+		static uint64_t getSourceHash(std::vector< std::pair<char const*, size_t> > const& sources, std::string const& options);
+
+		uint64_t getKey(std::vector< std::pair<char const*, size_t> > const& sources, cl::Device const& device, std::string const& options) const;
+
+		bool load(uint64_t key, std::vector< unsigned char >& binary, KernelArgInfoMap& argInfo, double& buildMilliseconds) const;
+
+		bool store(uint64_t key, std::vector< unsigned char > const& binary, KernelArgInfoMap const& argInfo, double buildMilliseconds) const;
+
+		inline void recordHit(double savedMilliseconds)
+		{
+			std::lock_guard<std::mutex> lock(p_mutex);
+			++p_hitCount;
+			p_savedMilliseconds += savedMilliseconds;
+		}
+
+		inline void recordMiss()
+		{
+			std::lock_guard<std::mutex> lock(p_mutex);
+			++p_missCount;
+		}
+
+	protected:
+		std::string pGetFilePath(uint64_t key) const;
+
+	protected:
+		std::string		p_directory;
+		size_t			p_hitCount{ 0 };
+		size_t			p_missCount{ 0 };
+		double			p_savedMilliseconds{ 0.0 };
+		mutable std::mutex	p_mutex;		/* namespaces are built concurrently, see Manager::initKernelsFromSource */
+	};
+
+} // end namespace opencl
+
+
+#endif // !OPENCL_PROGRAM_CACHE
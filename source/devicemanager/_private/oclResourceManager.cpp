@@ -12,18 +12,43 @@
 
 #include "oclResources.h"
 #include "oclResourceManager.h"
+#include "oclManager.h"
+#include "oclProfiler.h"
 
 
 namespace opencl
 {
+
+	ResourceManager::~ResourceManager()
+	{
+		for (auto &pSlots : p_stagingSlots)
+		{
+			for (auto &pSlot : pSlots.second)
+			{
+				if (pSlot.hostPtr)
+					pSlot.cmdQueue.enqueueUnmapMemObject(pSlot.buffer, pSlot.hostPtr);
+			}
+			pSlots.second[0].cmdQueue.finish();
+		}
+	}
 	
 	cl_int ResourceManager::createBuffer(Buffer* buffer, compute::BufferDescription const& bufDesc)
 	{
 		cl_int clResult = CL_SUCCESS;
 
-		DataLayout datalayout(bufDesc.getDataAttributes());
-		cl_mem_flags memFlags = 0;
-		SET_CL_MEMFLAGS_FROM_DATA_ACCESS_QUALIFIER(bufDesc.getDataAccessQualifier(), memFlags);
+		DataLayout datalayout(bufDesc.getDataAttributes(), bufDesc.getLayout());
+		cl_mem_flags memFlags = pGetMemFlags(buffer->getDevice(), bufDesc.getDataAccessQualifier());
+
+		if (bufDesc.getDataAccessQualifier() == device::DataAccessQualifier::eSharedVirtual)
+		{
+			clResult = buffer->createSharedVirtual(datalayout, memFlags, bufDesc.getMaxUnitCount());
+			if (clResult != CL_SUCCESS)
+			{
+				std::string _logInfo_ = LOG_HEADER() + " SHARED VIRTUAL BUFFER CREATION FAILED: " + bufDesc.getTag();
+				getManager()->LOG_ERROR(_logInfo_);
+			}
+			return clResult;
+		}
 
 		clResult = buffer->create(datalayout, memFlags, bufDesc.getMaxUnitCount(), nullptr);
 
@@ -33,41 +58,153 @@ namespace opencl
 	cl_int ResourceManager::allocateBuffer(Buffer* buffer, compute::BufferDescription const& bufDesc)
 	{
 		cl_int clResult = CL_SUCCESS;
-		return clResult;
 
-		DataLayout datalayout(bufDesc.getDataAttributes());
-		cl_mem_flags memFlags = 0;
-		SET_CL_MEMFLAGS_FROM_DATA_ACCESS_QUALIFIER(bufDesc.getDataAccessQualifier(), memFlags);
+		DataLayout datalayout(bufDesc.getDataAttributes(), bufDesc.getLayout());
+		cl_mem_flags memFlags = pGetMemFlags(buffer->getDevice(), bufDesc.getDataAccessQualifier());
 		size_t bufferSize = bufDesc.getMaxUnitCount() * datalayout.getDataStride();
+
+		// user host memory and shared virtual memory can't be pooled
+		if (memFlags & (CL_MEM_USE_HOST_PTR | CL_MEM_COPY_HOST_PTR) || bufDesc.getDataAccessQualifier() == device::DataAccessQualifier::eSharedVirtual)
+			return createBuffer(buffer, bufDesc);
+
+		MemoryPoolHandle pool = pGetMemoryPool(buffer->getDevice(), memFlags);
+		if (bufferSize > pool->getMaxAllocationSize())
+			return createBuffer(buffer, bufDesc);
+
+		// the sub-buffer starts at the pool region, so the resource offset is 0
 		cl::Buffer resource;
-		size_t resourceOffset = 0;
+		PoolAllocation allocation;
+		clResult = pool->allocate(bufferSize, resource, allocation);
+		if (clResult != CL_SUCCESS)
+			return createBuffer(buffer, bufDesc);
 
-		// pAllocateBufferFromManaged(resource, resourceOffset, memFlags, bufferSize);
-		clResult = buffer->allocate(resource, resourceOffset, datalayout, bufDesc.getMaxUnitCount());
+		buffer->setPoolAllocation(pool, allocation);
+		clResult = buffer->allocate(resource, 0, datalayout, bufDesc.getMaxUnitCount());
 
 		return clResult;
 	}
 
-	cl_int ResourceManager::readBuffer(const Buffer* buffer, void* dstPtr, size_t dataSize, size_t offset)
+	MemoryPoolStats ResourceManager::getMemoryPoolStats() const
+	{
+		MemoryPoolStats stats;
+		for (auto &pPool : p_memoryPools)
+		{
+			stats += pPool.second->getStats();
+		}
+
+		return stats;
+	}
+
+	cl_int ResourceManager::readBuffer(const Buffer* buffer, void* dstPtr, size_t dataSize, size_t offset, bool blocking, cl::Event* event)
 	{
 		cl_int clResult = CL_SUCCESS;
 
-		bool blocking = true;
+		std::vector< cl::Event > waitEvents;
+		buffer->appendSyncEvent(waitEvents);
+
+		cl::Event transferEvent;
 		size_t dataOffset = buffer->getResourceOffset() + offset;
-		cl::CommandQueue cmdQueue = buffer->getDevice()->getCmdQueue();
-		clResult = cmdQueue.enqueueReadBuffer(buffer->getResource(), blocking, dataOffset, dataSize, dstPtr);
+		cl::CommandQueue cmdQueue = buffer->getDevice()->getCmdQueue(QueueType::eTransfer);
+		clResult = cmdQueue.enqueueReadBuffer(buffer->getResource(), blocking, dataOffset, dataSize, dstPtr, waitEvents.size() ? &waitEvents : nullptr, &transferEvent);
+		if (clResult != CL_SUCCESS)
+			return clResult;
+
+		pSetTransferEvent(cmdQueue, transferEvent, blocking, event, buffer);
 
 		return clResult;
 	}
 
-	cl_int ResourceManager::writeBuffer(Buffer* buffer, const void* srcPtr, size_t dataSize, size_t offset)
+	cl_int ResourceManager::writeBuffer(Buffer* buffer, const void* srcPtr, size_t dataSize, size_t offset, bool blocking, cl::Event* event)
 	{
 		cl_int clResult = CL_SUCCESS;
 
-		bool blocking = true;
+		std::vector< cl::Event > waitEvents;
+		buffer->appendSyncEvent(waitEvents);
+
+		cl::Event transferEvent;
 		size_t dataOffset = buffer->getResourceOffset() + offset;
-		cl::CommandQueue cmdQueue = buffer->getDevice()->getCmdQueue();
-		clResult = cmdQueue.enqueueWriteBuffer(buffer->getResource(), blocking, dataOffset, dataSize, srcPtr);
+		cl::CommandQueue cmdQueue = buffer->getDevice()->getCmdQueue(QueueType::eTransfer);
+		clResult = cmdQueue.enqueueWriteBuffer(buffer->getResource(), blocking, dataOffset, dataSize, srcPtr, waitEvents.size() ? &waitEvents : nullptr, &transferEvent);
+		if (clResult != CL_SUCCESS)
+			return clResult;
+
+		pSetTransferEvent(cmdQueue, transferEvent, blocking, event, buffer);
+
+		return clResult;
+	}
+
+	/* cl rect of the transfer with the resource offset of the buffer and the default pitches, fails if the window leaves the buffer */
+	static cl_int GET_BUFFER_RECT(const Buffer* buffer, compute::TransferRect const& rect, cl::size_t<3>& bufferOrigin, cl::size_t<3>& hostOrigin, cl::size_t<3>& region, size_t& bufferRowPitch, size_t& bufferSlicePitch)
+	{
+		if (!rect.region[0] || !rect.region[1] || !rect.region[2])
+			return CL_INVALID_VALUE;
+
+		bufferRowPitch = rect.bufferRowPitch ? rect.bufferRowPitch : rect.region[0];
+		bufferSlicePitch = rect.bufferSlicePitch ? rect.bufferSlicePitch : rect.region[1] * bufferRowPitch;
+
+		size_t lastByte = rect.bufferOrigin[0] + rect.region[0]
+			+ (rect.bufferOrigin[1] + rect.region[1] - 1) * bufferRowPitch
+			+ (rect.bufferOrigin[2] + rect.region[2] - 1) * bufferSlicePitch;
+		if (lastByte > buffer->getUnitStride() * buffer->getMaxUnitCount())
+			return CL_INVALID_VALUE;
+
+		for (int i = 0; i < 3; ++i)
+		{
+			bufferOrigin[i] = rect.bufferOrigin[i];
+			hostOrigin[i] = rect.hostOrigin[i];
+			region[i] = rect.region[i];
+		}
+
+		// pooled buffers start at an offset of the slab, the byte origin carries it
+		bufferOrigin[0] += buffer->getResourceOffset();
+
+		return CL_SUCCESS;
+	}
+
+	cl_int ResourceManager::readBufferRect(const Buffer* buffer, void* hostPtr, compute::TransferRect const& rect, bool blocking, cl::Event* event)
+	{
+		cl::size_t<3> bufferOrigin, hostOrigin, region;
+		size_t bufferRowPitch = 0;
+		size_t bufferSlicePitch = 0;
+		cl_int clResult = GET_BUFFER_RECT(buffer, rect, bufferOrigin, hostOrigin, region, bufferRowPitch, bufferSlicePitch);
+		if (clResult != CL_SUCCESS)
+			return clResult;
+
+		std::vector< cl::Event > waitEvents;
+		buffer->appendSyncEvent(waitEvents);
+
+		cl::Event transferEvent;
+		cl::CommandQueue cmdQueue = buffer->getDevice()->getCmdQueue(QueueType::eTransfer);
+		clResult = cmdQueue.enqueueReadBufferRect(buffer->getResource(), blocking, bufferOrigin, hostOrigin, region, bufferRowPitch, bufferSlicePitch,
+			rect.hostRowPitch, rect.hostSlicePitch, hostPtr, waitEvents.size() ? &waitEvents : nullptr, &transferEvent);
+		if (clResult != CL_SUCCESS)
+			return clResult;
+
+		pSetTransferEvent(cmdQueue, transferEvent, blocking, event, buffer);
+
+		return clResult;
+	}
+
+	cl_int ResourceManager::writeBufferRect(Buffer* buffer, const void* hostPtr, compute::TransferRect const& rect, bool blocking, cl::Event* event)
+	{
+		cl::size_t<3> bufferOrigin, hostOrigin, region;
+		size_t bufferRowPitch = 0;
+		size_t bufferSlicePitch = 0;
+		cl_int clResult = GET_BUFFER_RECT(buffer, rect, bufferOrigin, hostOrigin, region, bufferRowPitch, bufferSlicePitch);
+		if (clResult != CL_SUCCESS)
+			return clResult;
+
+		std::vector< cl::Event > waitEvents;
+		buffer->appendSyncEvent(waitEvents);
+
+		cl::Event transferEvent;
+		cl::CommandQueue cmdQueue = buffer->getDevice()->getCmdQueue(QueueType::eTransfer);
+		clResult = cmdQueue.enqueueWriteBufferRect(buffer->getResource(), blocking, bufferOrigin, hostOrigin, region, bufferRowPitch, bufferSlicePitch,
+			rect.hostRowPitch, rect.hostSlicePitch, const_cast<void*>(hostPtr), waitEvents.size() ? &waitEvents : nullptr, &transferEvent);
+		if (clResult != CL_SUCCESS)
+			return clResult;
+
+		pSetTransferEvent(cmdQueue, transferEvent, blocking, event, buffer);
 
 		return clResult;
 	}
@@ -77,24 +214,151 @@ namespace opencl
 		cl_int clResult = CL_SUCCESS;
 
 		if (srcbuffer->getDevice()->GetId() != dstbuffer->getDevice()->GetId())
-			return clResult; // #improvement - cross device copy
+			return pCopyBufferAcrossDevices(srcbuffer, dstbuffer, dataSize, srcOffset, dstOffset);
 
 		size_t srcDataOffset = srcbuffer->getResourceOffset() + srcOffset;
 		size_t dstDataOffset = dstbuffer->getResourceOffset() + dstOffset;
 
-		cl::CommandQueue cmdQueue = srcbuffer->getDevice()->getCmdQueue();
-		clResult = cmdQueue.enqueueCopyBuffer(srcbuffer->getResource(), dstbuffer->getResource(), srcDataOffset, dstDataOffset, dataSize);
+		std::vector< cl::Event > waitEvents;
+		srcbuffer->appendSyncEvent(waitEvents);
+		dstbuffer->appendSyncEvent(waitEvents);
+
+		cl::Event transferEvent;
+		cl::CommandQueue cmdQueue = srcbuffer->getDevice()->getCmdQueue(QueueType::eTransfer);
+		clResult = cmdQueue.enqueueCopyBuffer(srcbuffer->getResource(), dstbuffer->getResource(), srcDataOffset, dstDataOffset, dataSize, waitEvents.size() ? &waitEvents : nullptr, &transferEvent);
+		if (clResult != CL_SUCCESS)
+			return clResult;
+
+		pSetTransferEvent(cmdQueue, transferEvent, false, nullptr, srcbuffer, dstbuffer);
+
+		return clResult;
+	}
+
+	/* transfer window of the attribute values, a strided window (packed AoS) or a contiguous one (SoA, a single AoS unit) */
+	static cl_int GET_ATTRIBUTE_RECT(const Buffer* buffer, size_t attributeIdx, size_t unitCount, size_t firstUnit, compute::TransferRect& rect)
+	{
+		DataLayout const& layout = buffer->getDataLayout();
+		if (attributeIdx >= layout.getAttributesCount() || !unitCount || firstUnit + unitCount > buffer->getMaxUnitCount())
+			return CL_INVALID_VALUE;
+
+		size_t attributeSize = layout.getAttributeSize(attributeIdx);
+		size_t attributeOffset = layout.getAttributeOffset(attributeIdx, buffer->getMaxUnitCount());
+		if (layout.getLayout() == compute::BufferLayout::eSoA)
+		{
+			rect.region[0] = unitCount * attributeSize;
+			rect.bufferOrigin[0] = attributeOffset + firstUnit * attributeSize;
+			return CL_SUCCESS;
+		}
+
+		// the attribute of a single unit, a plain transfer at the offset of the unit
+		if (unitCount == 1)
+		{
+			rect.region[0] = attributeSize;
+			rect.bufferOrigin[0] = attributeOffset + firstUnit * layout.getDataStride();
+			return CL_SUCCESS;
+		}
+
+		// one row per unit, the rows are a unit stride apart in the buffer and packed on the host
+		rect.region[0] = attributeSize;
+		rect.region[1] = unitCount;
+		rect.bufferOrigin[0] = attributeOffset;
+		rect.bufferOrigin[1] = firstUnit;
+		rect.bufferRowPitch = layout.getDataStride();
+		rect.hostRowPitch = attributeSize;
+
+		return CL_SUCCESS;
+	}
+
+	cl_int ResourceManager::readBufferAttribute(const Buffer* buffer, size_t attributeIdx, void* dstPtr, size_t unitCount, size_t firstUnit, bool blocking, cl::Event* event)
+	{
+		compute::TransferRect rect;
+		cl_int clResult = GET_ATTRIBUTE_RECT(buffer, attributeIdx, unitCount, firstUnit, rect);
+		if (clResult != CL_SUCCESS)
+			return clResult;
+
+		// contiguous window, bufferOrigin[0] is the byte offset
+		if (rect.region[1] == 1)
+			return readBuffer(buffer, dstPtr, rect.region[0], rect.bufferOrigin[0], blocking, event);
+
+		return readBufferRect(buffer, dstPtr, rect, blocking, event);
+	}
+
+	cl_int ResourceManager::writeBufferAttribute(Buffer* buffer, size_t attributeIdx, const void* srcPtr, size_t unitCount, size_t firstUnit, bool blocking, cl::Event* event)
+	{
+		compute::TransferRect rect;
+		cl_int clResult = GET_ATTRIBUTE_RECT(buffer, attributeIdx, unitCount, firstUnit, rect);
+		if (clResult != CL_SUCCESS)
+			return clResult;
+
+		// contiguous window, bufferOrigin[0] is the byte offset
+		if (rect.region[1] == 1)
+			return writeBuffer(buffer, srcPtr, rect.region[0], rect.bufferOrigin[0], blocking, event);
+
+		return writeBufferRect(buffer, srcPtr, rect, blocking, event);
+	}
+
+	cl_int ResourceManager::mapBuffer(Buffer* buffer, cl_map_flags flags, size_t dataSize, size_t offset, void*& mappedPtr)
+	{
+		cl_int clResult = CL_SUCCESS;
+
+		mappedPtr = buffer->map(flags, offset, dataSize, &clResult);
 
 		return clResult;
 	}
 
+	cl_int ResourceManager::unmapBuffer(Buffer* buffer, void* mappedPtr)
+	{
+		return buffer->unmap(mappedPtr);
+	}
+
+	cl_int ResourceManager::createPipe(Pipe* pipe, compute::PipeDescription const& pipeDesc)
+	{
+		cl_int clResult = pipe->create(pipeDesc.getPacketSize(), pipeDesc.getMaxPackets());
+		if (clResult != CL_SUCCESS)
+		{
+			std::string _logInfo_ = LOG_HEADER() + " PIPE CREATION FAILED: " + pipeDesc.getTag();
+			getManager()->LOG_ERROR(_logInfo_);
+		}
+
+		return clResult;
+	}
+
+	/* single channel 16 bit formats are outside the OpenCL 1.2 minimum set, the support is device specific */
+	static bool IS_IMAGE_FORMAT_SUPPORTED(Device* device, cl_mem_flags memFlags, compute::ImageViewType viewType, cl::ImageFormat const& format)
+	{
+		cl_mem_object_type imageType = CL_MEM_OBJECT_IMAGE1D;
+		switch (viewType)
+		{
+		case compute::ImageViewType::e1DArray: imageType = CL_MEM_OBJECT_IMAGE1D_ARRAY; break;
+		case compute::ImageViewType::e2D: imageType = CL_MEM_OBJECT_IMAGE2D; break;
+		case compute::ImageViewType::e2DArray: imageType = CL_MEM_OBJECT_IMAGE2D_ARRAY; break;
+		case compute::ImageViewType::e3D: imageType = CL_MEM_OBJECT_IMAGE3D; break;
+		default: break;
+		}
+
+		std::vector< cl::ImageFormat > formats;
+		if (device->getContext().getSupportedImageFormats(memFlags, imageType, &formats) != CL_SUCCESS)
+			return false;
+
+		return std::any_of(formats.begin(), formats.end(), [&format](cl::ImageFormat const& supported)
+		{
+			return supported.image_channel_order == format.image_channel_order && supported.image_channel_data_type == format.image_channel_data_type;
+		});
+	}
+
 	cl_int ResourceManager::createImage(Image* image, compute::ImageDescription const& imgDesc)
 	{
 		cl_int clResult = CL_SUCCESS;
 
 		cl::ImageFormat format = GET_CL_IMAGEFORMAT_FROM_DATAFORMAT(imgDesc.getDataFormat());
-		cl_mem_flags memFlags = 0;
-		SET_CL_MEMFLAGS_FROM_DATA_ACCESS_QUALIFIER(imgDesc.getDataAccessQualifier(), memFlags);
+		cl_mem_flags memFlags = pGetMemFlags(image->getDevice(), imgDesc.getDataAccessQualifier());
+
+		if (!IS_IMAGE_FORMAT_SUPPORTED(image->getDevice(), memFlags, imgDesc.getResourceType(), format))
+		{
+			std::string _logInfo_ = LOG_HEADER() + " IMAGE FORMAT NOT SUPPORTED BY THE DEVICE: " + imgDesc.getTag();
+			getManager()->LOG_ERROR(_logInfo_);
+			return CL_IMAGE_FORMAT_NOT_SUPPORTED;
+		}
 
 		switch (imgDesc.getResourceType())
 		{
@@ -168,42 +432,52 @@ namespace opencl
 		return clResult;
 	}
 
-	cl_int ResourceManager::readImage(const Image* image, void* dstPtr, const size_t region[3], const size_t origin[3])
+	cl_int ResourceManager::readImage(const Image* image, void* dstPtr, const size_t region[3], const size_t origin[3], size_t rowPitch, size_t slicePitch, bool blocking, cl::Event* event)
 	{
 		cl_int clResult = CL_SUCCESS;
 
-		bool blocking = true;
-		size_t rowPitch = 0;
-		size_t slicePitch = 0;
 		cl::size_t<3> _region, _origin;
 		for (int i = 0; i < 3; ++i)
 		{
 			_region[i] = region[i];
-			_origin[i] = origin[i];
+			_origin[i] = origin ? origin[i] : 0; // slot default origin is null
 		}
 
-		cl::CommandQueue cmdQueue = image->getDevice()->getCmdQueue();
-		clResult = cmdQueue.enqueueReadImage(*image->getResource(), blocking, _origin, _region, rowPitch, slicePitch, dstPtr);
+		std::vector< cl::Event > waitEvents;
+		image->appendSyncEvent(waitEvents);
+
+		cl::Event transferEvent;
+		cl::CommandQueue cmdQueue = image->getDevice()->getCmdQueue(QueueType::eTransfer);
+		clResult = cmdQueue.enqueueReadImage(*image->getResource(), blocking, _origin, _region, rowPitch, slicePitch, dstPtr, waitEvents.size() ? &waitEvents : nullptr, &transferEvent);
+		if (clResult != CL_SUCCESS)
+			return clResult;
+
+		pSetTransferEvent(cmdQueue, transferEvent, blocking, event, image);
 
 		return clResult;
 	}
 
-	cl_int ResourceManager::writeImage(Image* image, const void* srcPtr, const size_t region[3], const size_t origin[3])
+	cl_int ResourceManager::writeImage(Image* image, const void* srcPtr, const size_t region[3], const size_t origin[3], size_t rowPitch, size_t slicePitch, bool blocking, cl::Event* event)
 	{
 		cl_int clResult = CL_SUCCESS;
 
-		bool blocking = true;
-		size_t rowPitch = 0;
-		size_t slicePitch = 0;
 		cl::size_t<3> _region, _origin;
 		for (int i = 0; i < 3; ++i)
 		{
 			_region[i] = region[i];
-			_origin[i] = origin[i];
+			_origin[i] = origin ? origin[i] : 0; // slot default origin is null
 		}
 
-		cl::CommandQueue cmdQueue = image->getDevice()->getCmdQueue();
-		clResult = cmdQueue.enqueueWriteImage(*image->getResource(), blocking, _origin, _region, rowPitch, slicePitch, const_cast<void*>(srcPtr));
+		std::vector< cl::Event > waitEvents;
+		image->appendSyncEvent(waitEvents);
+
+		cl::Event transferEvent;
+		cl::CommandQueue cmdQueue = image->getDevice()->getCmdQueue(QueueType::eTransfer);
+		clResult = cmdQueue.enqueueWriteImage(*image->getResource(), blocking, _origin, _region, rowPitch, slicePitch, const_cast<void*>(srcPtr), waitEvents.size() ? &waitEvents : nullptr, &transferEvent);
+		if (clResult != CL_SUCCESS)
+			return clResult;
+
+		pSetTransferEvent(cmdQueue, transferEvent, blocking, event, image);
 
 		return clResult;
 	}
@@ -213,7 +487,7 @@ namespace opencl
 		cl_int clResult = CL_SUCCESS;
 
 		if (srcimage->getDevice()->GetId() != dstimage->getDevice()->GetId())
-			return clResult; // #improvement - cross device copy
+			return pCopyImageAcrossDevices(srcimage, dstimage, region, srcOrigin, dstOrigin);
 
 		size_t rowPitch = 0;
 		size_t slicePitch = 0;
@@ -221,15 +495,271 @@ namespace opencl
 		for (int i = 0; i < 3; ++i)
 		{
 			_region[i] = region[i];
-			_srcOrigin[i] = srcOrigin[i];
-			_dstOrigin[i] = dstOrigin[i];
+			_srcOrigin[i] = srcOrigin ? srcOrigin[i] : 0;
+			_dstOrigin[i] = dstOrigin ? dstOrigin[i] : 0;
+		}
+
+		std::vector< cl::Event > waitEvents;
+		srcimage->appendSyncEvent(waitEvents);
+		dstimage->appendSyncEvent(waitEvents);
+
+		cl::Event transferEvent;
+		cl::CommandQueue cmdQueue = srcimage->getDevice()->getCmdQueue(QueueType::eTransfer);
+		clResult = cmdQueue.enqueueCopyImage(*srcimage->getResource(), *dstimage->getResource(), _srcOrigin, _dstOrigin, _region, waitEvents.size() ? &waitEvents : nullptr, &transferEvent);
+		if (clResult != CL_SUCCESS)
+			return clResult;
+
+		pSetTransferEvent(cmdQueue, transferEvent, false, nullptr, srcimage, dstimage);
+
+		return clResult;
+	}
+
+	cl_int ResourceManager::mapImage(Image* image, cl_map_flags flags, const size_t region[3], const size_t origin[3], void*& mappedPtr, size_t& rowPitch, size_t& slicePitch)
+	{
+		cl_int clResult = CL_SUCCESS;
+
+		mappedPtr = image->map(flags, region, origin, rowPitch, slicePitch, &clResult);
+
+		return clResult;
+	}
+
+	cl_int ResourceManager::unmapImage(Image* image, void* mappedPtr)
+	{
+		return image->unmap(mappedPtr);
+	}
+
+	cl_int ResourceManager::pCopyBufferAcrossDevices(const Buffer* srcbuffer, Buffer* dstbuffer, size_t dataSize, size_t srcOffset, size_t dstOffset)
+	{
+		cl_int clResult = CL_SUCCESS;
+
+		// zero-copy - the mapped source memory is host memory, written to the destination directly
+		if (srcbuffer->getDevice()->getIsHostUnifiedMemory() && dstbuffer->getDevice()->getIsHostUnifiedMemory())
+		{
+			void* srcPtr = srcbuffer->map(CL_MAP_READ, srcOffset, dataSize, &clResult);
+			if (!srcPtr)
+				return clResult;
+
+			clResult = writeBuffer(dstbuffer, srcPtr, dataSize, dstOffset, true);
+			cl_int unmapResult = srcbuffer->unmap(srcPtr);
+
+			return clResult != CL_SUCCESS ? clResult : unmapResult;
+		}
+
+		size_t chunkSize = COMPUTE_COPY_STAGING_CHUNK_SIZE;
+		size_t chunkCount = (dataSize + chunkSize - 1) / chunkSize;
+
+		auto readChunk = [&](size_t chunkIdx, void* staging, cl::Event* event)
+		{
+			size_t chunkOffset = chunkIdx * chunkSize;
+			return readBuffer(srcbuffer, staging, std::min(chunkSize, dataSize - chunkOffset), srcOffset + chunkOffset, false, event);
+		};
+
+		auto writeChunk = [&](size_t chunkIdx, void* staging, cl::Event* event)
+		{
+			size_t chunkOffset = chunkIdx * chunkSize;
+			return writeBuffer(dstbuffer, staging, std::min(chunkSize, dataSize - chunkOffset), dstOffset + chunkOffset, false, event);
+		};
+
+		clResult = pCopyStaged(srcbuffer->getDevice(), chunkCount, readChunk, writeChunk);
+
+		return clResult;
+	}
+
+	cl_int ResourceManager::pCopyImageAcrossDevices(const Image* srcimage, Image* dstimage, const size_t region[3], const size_t srcOrigin[3], const size_t dstOrigin[3])
+	{
+		cl_int clResult = CL_SUCCESS;
+
+		size_t _srcOrigin[3], _dstOrigin[3];
+		for (int i = 0; i < 3; ++i)
+		{
+			_srcOrigin[i] = srcOrigin ? srcOrigin[i] : 0;
+			_dstOrigin[i] = dstOrigin ? dstOrigin[i] : 0;
+		}
+
+		// zero-copy - the mapped source region is written with its pitches to the destination directly
+		if (srcimage->getDevice()->getIsHostUnifiedMemory() && dstimage->getDevice()->getIsHostUnifiedMemory())
+		{
+			size_t rowPitch = 0;
+			size_t slicePitch = 0;
+			void* srcPtr = srcimage->map(CL_MAP_READ, region, _srcOrigin, rowPitch, slicePitch, &clResult);
+			if (!srcPtr)
+				return clResult;
+
+			cl::size_t<3> _region, _origin;
+			for (int i = 0; i < 3; ++i)
+			{
+				_region[i] = region[i];
+				_origin[i] = _dstOrigin[i];
+			}
+
+			std::vector< cl::Event > waitEvents;
+			dstimage->appendSyncEvent(waitEvents);
+
+			cl::Event transferEvent;
+			cl::CommandQueue cmdQueue = dstimage->getDevice()->getCmdQueue(QueueType::eTransfer);
+			clResult = cmdQueue.enqueueWriteImage(*dstimage->getResource(), CL_TRUE, _origin, _region, rowPitch, slicePitch, srcPtr, waitEvents.size() ? &waitEvents : nullptr, &transferEvent);
+			if (clResult == CL_SUCCESS)
+				pSetTransferEvent(cmdQueue, transferEvent, true, nullptr, dstimage);
+
+			cl_int unmapResult = srcimage->unmap(srcPtr);
+
+			return clResult != CL_SUCCESS ? clResult : unmapResult;
 		}
 
-		cl::CommandQueue cmdQueue = srcimage->getDevice()->getCmdQueue();
-		clResult = cmdQueue.enqueueCopyImage(*srcimage->getResource(), *dstimage->getResource(), _srcOrigin, _dstOrigin, _region);
+		// chunks of rows per slice, packed in the staging memory
+		size_t rowSize = region[0] * srcimage->getResource()->getImageInfo<CL_IMAGE_ELEMENT_SIZE>();
+		if (!rowSize || rowSize > COMPUTE_COPY_STAGING_CHUNK_SIZE)
+			return CL_INVALID_VALUE;
+
+		size_t rowsPerChunk = COMPUTE_COPY_STAGING_CHUNK_SIZE / rowSize;
+		size_t chunksPerSlice = (region[1] + rowsPerChunk - 1) / rowsPerChunk;
+		size_t chunkCount = chunksPerSlice * region[2];
+
+		auto getChunk = [&](size_t chunkIdx, size_t chunkRegion[3], size_t chunkOrigin[3], const size_t origin[3])
+		{
+			size_t slice = chunkIdx / chunksPerSlice;
+			size_t firstRow = (chunkIdx % chunksPerSlice) * rowsPerChunk;
+
+			chunkRegion[0] = region[0];
+			chunkRegion[1] = std::min(rowsPerChunk, region[1] - firstRow);
+			chunkRegion[2] = 1;
+			chunkOrigin[0] = origin[0];
+			chunkOrigin[1] = origin[1] + firstRow;
+			chunkOrigin[2] = origin[2] + slice;
+		};
+
+		auto readChunk = [&](size_t chunkIdx, void* staging, cl::Event* event)
+		{
+			size_t chunkRegion[3], chunkOrigin[3];
+			getChunk(chunkIdx, chunkRegion, chunkOrigin, _srcOrigin);
+			return readImage(srcimage, staging, chunkRegion, chunkOrigin, 0, 0, false, event);
+		};
+
+		auto writeChunk = [&](size_t chunkIdx, void* staging, cl::Event* event)
+		{
+			size_t chunkRegion[3], chunkOrigin[3];
+			getChunk(chunkIdx, chunkRegion, chunkOrigin, _dstOrigin);
+			return writeImage(dstimage, staging, chunkRegion, chunkOrigin, 0, 0, false, event);
+		};
+
+		clResult = pCopyStaged(srcimage->getDevice(), chunkCount, readChunk, writeChunk);
+
+		return clResult;
+	}
+
+	cl_int ResourceManager::pCopyStaged(Device* srcDevice, size_t chunkCount, StagedChunkFn const& readChunk, StagedChunkFn const& writeChunk)
+	{
+		/*
+		*-------------------------------
+		* Chunk i+1 is read from the source device while chunk i is written to the destination device.
+		* Events of different contexts can't be in a wait list, so the hand over between the devices
+		* (and the reuse of a staging slot) is a host wait.
+		*-------------------------------
+		*/
+		cl_int clResult = CL_SUCCESS;
+
+		StagingSlots& slots = pGetStagingSlots(srcDevice);
+		for (auto &pSlot : slots)
+		{
+			if (!pSlot.hostPtr)
+				return CL_MEM_OBJECT_ALLOCATION_FAILURE;
+		}
+
+		std::array<cl::Event, COMPUTE_COPY_STAGING_SLOTS> readEvents, writeEvents;
+		for (size_t chunkIdx = 0; chunkIdx <= chunkCount && clResult == CL_SUCCESS; ++chunkIdx)
+		{
+			if (chunkIdx < chunkCount)
+			{
+				size_t slotIdx = chunkIdx % COMPUTE_COPY_STAGING_SLOTS;
+				if (writeEvents[slotIdx]())
+					clResult = writeEvents[slotIdx].wait();
+
+				if (clResult == CL_SUCCESS)
+					clResult = readChunk(chunkIdx, slots[slotIdx].hostPtr, &readEvents[slotIdx]);
+			}
+
+			if (chunkIdx > 0 && clResult == CL_SUCCESS)
+			{
+				size_t slotIdx = (chunkIdx - 1) % COMPUTE_COPY_STAGING_SLOTS;
+				clResult = readEvents[slotIdx].wait();
+
+				if (clResult == CL_SUCCESS)
+					clResult = writeChunk(chunkIdx - 1, slots[slotIdx].hostPtr, &writeEvents[slotIdx]);
+			}
+		}
+
+		// the staging memory is reused by the next copy
+		for (size_t slotIdx = 0; slotIdx < COMPUTE_COPY_STAGING_SLOTS; ++slotIdx)
+		{
+			if (readEvents[slotIdx]())
+				readEvents[slotIdx].wait();
+			if (writeEvents[slotIdx]())
+				writeEvents[slotIdx].wait();
+		}
 
 		return clResult;
 	}
 
+	ResourceManager::StagingSlots& ResourceManager::pGetStagingSlots(Device* device)
+	{
+		auto pSlots = p_stagingSlots.find(device->GetId());
+		if (pSlots != p_stagingSlots.end())
+			return pSlots->second;
+
+		StagingSlots& slots = p_stagingSlots[device->GetId()];
+		for (auto &pSlot : slots)
+		{
+			cl_int clResult = CL_SUCCESS;
+			pSlot.cmdQueue = device->getCmdQueue(QueueType::eTransfer);
+			pSlot.buffer = cl::Buffer(device->getContext(), CL_MEM_READ_WRITE | CL_MEM_ALLOC_HOST_PTR, COMPUTE_COPY_STAGING_CHUNK_SIZE, nullptr, &clResult);
+			if (clResult != CL_SUCCESS)
+				continue;
+
+			pSlot.hostPtr = pSlot.cmdQueue.enqueueMapBuffer(pSlot.buffer, CL_TRUE, CL_MAP_READ | CL_MAP_WRITE, 0, COMPUTE_COPY_STAGING_CHUNK_SIZE);
+		}
+
+		return slots;
+	}
+
+	cl_mem_flags ResourceManager::pGetMemFlags(Device* device, device::DataAccessQualifier accessQ) const
+	{
+		cl_mem_flags memFlags = 0;
+		SET_CL_MEMFLAGS_FROM_DATA_ACCESS_QUALIFIER(accessQ, memFlags);
+
+		if (device->getIsHostUnifiedMemory())
+			memFlags |= CL_MEM_ALLOC_HOST_PTR;
+
+		return memFlags;
+	}
+
+	MemoryPoolHandle ResourceManager::pGetMemoryPool(Device* device, cl_mem_flags memFlags)
+	{
+		auto poolKEY = std::make_pair(device->GetId(), memFlags);
+		auto pPool = p_memoryPools.find(poolKEY);
+		if (pPool != p_memoryPools.end())
+			return pPool->second;
+
+		MemoryPoolHandle pool = std::make_shared<MemoryPool>(device, memFlags);
+		p_memoryPools[poolKEY] = pool;
+
+		return pool;
+	}
+
+	void ResourceManager::pSetTransferEvent(cl::CommandQueue& cmdQueue, cl::Event const& transferEvent, bool blocking, cl::Event* event, ResourceSync const* resource, ResourceSync const* otherResource)
+	{
+		resource->setSyncEvent(transferEvent);
+		if (otherResource)
+			otherResource->setSyncEvent(transferEvent);
+
+		if (event)
+			*event = transferEvent;
+
+		if (Profiler* profiler = getManager()->getProfiler())
+			profiler->recordTransfer(transferEvent);
+
+		/* commands on the compute queue could wait on this event, so it has to reach the device */
+		if (!blocking)
+			cmdQueue.flush();
+	}
 
 } // end namespace opencl
\ No newline at end of file
@@ -14,6 +14,8 @@
 
 #include "oclDefines.h"
 #include "oclDevice.h"
+#include "oclEvent.h"
+#include "oclMemoryPool.h"
 
 
 namespace opencl
@@ -26,8 +28,7 @@ namespace opencl
 			: p_mgr(mgr)
 		{}
 
-		~ResourceManager()
-		{}
+		~ResourceManager();
 
 		inline Manager* getManager()
 		{
@@ -42,15 +43,35 @@ namespace opencl
 
 		/**
 		* @name	allocateBuffer
-		* @purpose	create a new buffer from the buffer description and assign memory(pointer & offset) from a managed memory (no standalone memory).
+		* @purpose	create a new buffer from the buffer description and assign memory(sub-buffer) from the device memory pool (no standalone memory).
+		*			large and host pointer buffers fall back to createBuffer.
 		*/
 		cl_int allocateBuffer(Buffer* buffer, compute::BufferDescription const& bufDesc);
 
-		/* read, write, and copy */
-		cl_int readBuffer(const Buffer* buffer, void* dstPtr, size_t dataSize, size_t offset);
-		cl_int writeBuffer(Buffer* buffer, const void* srcPtr, size_t dataSize, size_t offset);
+		/* occupancy and fragmentation of all the memory pools */
+		MemoryPoolStats getMemoryPoolStats() const;
+
+		/*
+		* read, write, and copy (non-blocking transfers signal the event on completion)
+		* copies across devices are staged through pinned host memory (zero-copy if both devices are host resident)
+		* and return after completion.
+		*/
+		cl_int readBuffer(const Buffer* buffer, void* dstPtr, size_t dataSize, size_t offset, bool blocking = true, cl::Event* event = nullptr);
+		cl_int writeBuffer(Buffer* buffer, const void* srcPtr, size_t dataSize, size_t offset, bool blocking = true, cl::Event* event = nullptr);
 		cl_int copyBuffer(const Buffer* srcbuffer, Buffer* dstbuffer, size_t dataSize, size_t srcOffset, size_t dstOffset);
 
+		/* 2D/3D window transfers (enqueueRead/WriteBufferRect), the window has to be inside the buffer */
+		cl_int readBufferRect(const Buffer* buffer, void* hostPtr, compute::TransferRect const& rect, bool blocking = true, cl::Event* event = nullptr);
+		cl_int writeBufferRect(Buffer* buffer, const void* hostPtr, compute::TransferRect const& rect, bool blocking = true, cl::Event* event = nullptr);
+
+		/* values of one attribute (tightly packed on the host) in either buffer layout, see compute::BufferLayout */
+		cl_int readBufferAttribute(const Buffer* buffer, size_t attributeIdx, void* dstPtr, size_t unitCount, size_t firstUnit, bool blocking = true, cl::Event* event = nullptr);
+		cl_int writeBufferAttribute(Buffer* buffer, size_t attributeIdx, const void* srcPtr, size_t unitCount, size_t firstUnit, bool blocking = true, cl::Event* event = nullptr);
+
+		/* blocking map for host access, the mapped pointer is valid till unmap */
+		cl_int mapBuffer(Buffer* buffer, cl_map_flags flags, size_t dataSize, size_t offset, void*& mappedPtr);
+		cl_int unmapBuffer(Buffer* buffer, void* mappedPtr);
+
 
 		/**
 		* @name	createImage
@@ -64,14 +85,69 @@ namespace opencl
 		*/
 		cl_int allocateImage(Image* image, compute::ImageDescription const& imgDesc);
 
-		/* read, write, and copy */
-		cl_int readImage(const Image* image, void* dstPtr, const size_t region[3], const size_t origin[3]);
-		cl_int writeImage(Image* image, const void* dstPtr, const size_t region[3], const size_t origin[3]);
+		/*
+		* read, write, and copy (non-blocking transfers signal the event on completion), see buffer copies
+		* rowPitch/slicePitch - host memory pitches in bytes, 0 - tightly packed.
+		*/
+		cl_int readImage(const Image* image, void* dstPtr, const size_t region[3], const size_t origin[3], size_t rowPitch, size_t slicePitch, bool blocking = true, cl::Event* event = nullptr);
+		cl_int writeImage(Image* image, const void* srcPtr, const size_t region[3], const size_t origin[3], size_t rowPitch, size_t slicePitch, bool blocking = true, cl::Event* event = nullptr);
 		cl_int copyImage(const Image* srcimage, Image* dstimage, const size_t region[3], const size_t srcOrigin[3], const size_t dstOrigin[3]);
 
+		/* pipes have no host access, native pipe on the devices supporting it else a ring buffer (see Pipe) */
+		cl_int createPipe(Pipe* pipe, compute::PipeDescription const& pipeDesc);
+
+		/* blocking map for host access, the mapped pointer is valid till unmap */
+		cl_int mapImage(Image* image, cl_map_flags flags, const size_t region[3], const size_t origin[3], void*& mappedPtr, size_t& rowPitch, size_t& slicePitch);
+		cl_int unmapImage(Image* image, void* mappedPtr);
+
+	protected:
+		/* records the transfer as the last access of the resource(s) */
+		void pSetTransferEvent
+		(
+			cl::CommandQueue& cmdQueue,
+			cl::Event const& transferEvent,
+			bool blocking,
+			cl::Event* event,
+			ResourceSync const* resource,
+			ResourceSync const* otherResource = nullptr
+		);
+
+		/* chunk reader/writer of a staged cross device copy, enqueues the chunk transfer from/to the staging memory */
+		using StagedChunkFn = std::function<cl_int(size_t chunkIdx, void* staging, cl::Event* event)>;
+
+		cl_int pCopyBufferAcrossDevices(const Buffer* srcbuffer, Buffer* dstbuffer, size_t dataSize, size_t srcOffset, size_t dstOffset);
+		cl_int pCopyImageAcrossDevices(const Image* srcimage, Image* dstimage, const size_t region[3], const size_t srcOrigin[3], const size_t dstOrigin[3]);
+
+		/* double buffered chunk pipeline through the pinned staging of the source device */
+		cl_int pCopyStaged(Device* srcDevice, size_t chunkCount, StagedChunkFn const& readChunk, StagedChunkFn const& writeChunk);
+
+		/* memory flags of the access qualifier, host resident devices always get host allocated memory (zero-copy map) */
+		cl_mem_flags pGetMemFlags(Device* device, device::DataAccessQualifier accessQ) const;
+
+		/* pool of the device for the memory flags, created on first use */
+		MemoryPoolHandle pGetMemoryPool(Device* device, cl_mem_flags memFlags);
+
+	protected:
+		/* persistently mapped CL_MEM_ALLOC_HOST_PTR buffer (pinned host memory) */
+		struct StagingSlot
+		{
+			cl::Buffer			buffer;
+			cl::CommandQueue	cmdQueue;
+			void*				hostPtr{ nullptr };
+		};
+		using StagingSlots = std::array<StagingSlot, COMPUTE_COPY_STAGING_SLOTS>;
+
+		/* staging of the device, created on first use */
+		StagingSlots& pGetStagingSlots(Device* device);
+
 	protected:
 		Manager * p_mgr;
-		// ManagedResourceHandle p_managedResurce;
+		std::map< size_t, StagingSlots > p_stagingSlots; /* device id -> staging */
+		std::map
+			<
+			std::pair<size_t, cl_mem_flags>,
+			MemoryPoolHandle
+			>		p_memoryPools; /* (device id, memory flags) -> pool */
 	};
 
 }
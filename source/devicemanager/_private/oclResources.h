@@ -16,6 +16,8 @@
 
 #include "oclDefines.h"
 #include "oclDevice.h"
+#include "oclEvent.h"
+#include "oclMemoryPool.h"
 
 namespace opencl
 {
@@ -26,8 +28,9 @@ namespace opencl
 		DataLayout()
 		{}
 
-		explicit DataLayout(device::DataAttributeList const& attributes)
+		explicit DataLayout(device::DataAttributeList const& attributes, compute::BufferLayout layout = compute::BufferLayout::ePackedAoS)
 			: p_atrributes(attributes)
+			, p_layout(layout)
 		{}
 
 		DataLayout& operator = (device::DataAttributeList const& attributes)
@@ -41,7 +44,7 @@ namespace opencl
 			return p_atrributes.size();
 		}
 
-		inline size_t getDataStride()
+		inline size_t getDataStride() const
 		{
 			size_t _size = 0;
 			for (auto &attribute : p_atrributes)
@@ -51,12 +54,62 @@ namespace opencl
 			return _size;
 		}
 
+		inline compute::BufferLayout getLayout() const
+		{
+			return p_layout;
+		}
+
+		inline size_t getAttributeSize(size_t attributeIdx) const
+		{
+			return GET_SIZE_FROM_DATAFORMAT(p_atrributes.at(attributeIdx).getFormat());
+		}
+
+		/* in the unit (packed AoS) or start of the attribute stream (SoA) */
+		inline size_t getAttributeOffset(size_t attributeIdx, size_t maxUnitCount) const
+		{
+			size_t _offset = 0;
+			for (size_t idx = 0; idx < attributeIdx; ++idx)
+			{
+				_offset += getAttributeSize(idx);
+			}
+			return p_layout == compute::BufferLayout::eSoA ? _offset * maxUnitCount : _offset;
+		}
+
+		/* byte ranges (offset, size) of the units [beginUnit, endUnit), one range (packed AoS) or one per attribute stream (SoA) */
+		inline void getUnitRanges(size_t beginUnit, size_t endUnit, size_t maxUnitCount, std::vector< std::pair<size_t, size_t> >& ranges) const
+		{
+			ranges.clear();
+			if (p_layout != compute::BufferLayout::eSoA)
+			{
+				ranges.push_back(std::make_pair(beginUnit * getDataStride(), (endUnit - beginUnit) * getDataStride()));
+				return;
+			}
+
+			for (size_t idx = 0; idx < p_atrributes.size(); ++idx)
+			{
+				size_t attributeSize = getAttributeSize(idx);
+				ranges.push_back(std::make_pair(getAttributeOffset(idx, maxUnitCount) + beginUnit * attributeSize, (endUnit - beginUnit) * attributeSize));
+			}
+		}
+
 	protected:
 		device::DataAttributeList p_atrributes;
+		compute::BufferLayout p_layout{ compute::BufferLayout::ePackedAoS };
 	};
 
 
+	/**
+	* @class	Buffer
+	* @brief	Buffer resource, standalone or a region of a memory pool.
+	*--------------------------------------------------------------------------
+	* eSharedVirtual buffers are coarse-grained svm allocations on the devices supporting it (built against
+	* the OpenCL 2.0 headers), the cl buffer aliases the svm memory so the transfers work unchanged and the
+	* kernel args are bound as svm pointers. Else a plain (flattened) buffer, the links of the data are byte
+	* offsets instead of pointers, see compute::BufferSlot::getSharedVirtualRef.
+	*--------------------------------------------------------------------------
+	*/
 	class Buffer
+		: public ResourceSync
 	{
 	public:
 		Buffer(Device* device)
@@ -64,7 +117,26 @@ namespace opencl
 		{}
 
 		~Buffer()
-		{}
+		{
+			if (p_pool)
+			{
+				// pending commands on the region (the last write and every reader) have to finish before the region is reused
+				pWaitPending();
+
+				p_pool->release(p_poolAllocation);
+			}
+
+#ifdef CL_VERSION_2_0
+			if (p_svmPtr)
+			{
+				pWaitPending();
+
+				// the alias goes first, the svm memory is freed after its last user
+				p_clResource = cl::Buffer();
+				clSVMFree(p_device->getContext()(), p_svmPtr);
+			}
+#endif
+		}
 
 		inline cl::Buffer getResource() const
 		{
@@ -81,14 +153,99 @@ namespace opencl
 			return p_resourceOffset;
 		}
 
-		void* map()
+		inline size_t getUnitStride() const
+		{
+			return p_dataLayout.getDataStride();
+		}
+
+		inline size_t getMaxUnitCount() const
+		{
+			return p_maxUnitCount;
+		}
+
+		inline DataLayout const& getDataLayout() const
+		{
+			return p_dataLayout;
+		}
+
+		/* eSharedVirtual buffer, svm or flattened */
+		inline bool getIsSharedVirtual() const
 		{
-			return nullptr;
+			return p_isSharedVirtual;
 		}
 
-		void unmap()
+		/* base of the svm allocation, nullptr for the flattened and the other buffers */
+		inline void* getSVMPointer() const
 		{
-			
+			return p_svmPtr;
+		}
+
+		/* blocking map on the transfer queue, ordered after the last access of the buffer */
+		void* map(cl_map_flags flags, size_t offset, size_t size, cl_int* err = nullptr) const
+		{
+			std::vector< cl::Event > waitEvents;
+			appendSyncEvent(waitEvents);
+
+			cl::CommandQueue cmdQueue = p_device->getCmdQueue(QueueType::eTransfer);
+#ifdef CL_VERSION_2_0
+			if (p_svmPtr)
+				return pMapSVM(cmdQueue, flags, offset, size, waitEvents, err);
+#endif
+
+			cl::Event mapEvent;
+			void* mappedPtr = cmdQueue.enqueueMapBuffer(p_clResource, CL_TRUE, flags, p_resourceOffset + offset, size, waitEvents.size() ? &waitEvents : nullptr, &mapEvent, err);
+			if (mappedPtr)
+				setSyncEvent(mapEvent);
+
+			return mappedPtr;
+		}
+
+		/* non-blocking, later commands on the buffer wait for the unmap */
+		cl_int unmap(void* mappedPtr) const
+		{
+			std::vector< cl::Event > waitEvents;
+			appendSyncEvent(waitEvents);
+
+			cl::CommandQueue cmdQueue = p_device->getCmdQueue(QueueType::eTransfer);
+#ifdef CL_VERSION_2_0
+			if (p_svmPtr)
+				return pUnmapSVM(cmdQueue, mappedPtr, waitEvents);
+#endif
+
+			cl::Event unmapEvent;
+			cl_int clResult = cmdQueue.enqueueUnmapMemObject(p_clResource, mappedPtr, waitEvents.size() ? &waitEvents : nullptr, &unmapEvent);
+			if (clResult != CL_SUCCESS)
+				return clResult;
+
+			setSyncEvent(unmapEvent);
+			return cmdQueue.flush();
+		}
+
+		/* svm allocation on the devices supporting it, else a flattened buffer (no pooling, the svm buffers can't be carved from a slab) */
+		cl_int createSharedVirtual(DataLayout const& layout, cl_mem_flags flags, size_t maxUnitCount)
+		{
+			cl_int clResult = CL_SUCCESS;
+
+			p_isSharedVirtual = true;
+#ifdef CL_VERSION_2_0
+			if (p_device->getIsSVMSupported())
+			{
+				p_dataLayout = layout;
+				p_maxUnitCount = maxUnitCount;
+				size_t bufferSize = p_dataLayout.getDataStride() * p_maxUnitCount;
+
+				// svm allocations only take the access flags
+				cl_mem_flags accessFlags = flags & (CL_MEM_READ_WRITE | CL_MEM_READ_ONLY | CL_MEM_WRITE_ONLY);
+				p_svmPtr = clSVMAlloc(p_device->getContext()(), accessFlags, bufferSize, 0);
+				if (!p_svmPtr)
+					return CL_MEM_OBJECT_ALLOCATION_FAILURE;
+
+				p_clResource = cl::Buffer(p_device->getContext(), accessFlags | CL_MEM_USE_HOST_PTR, bufferSize, p_svmPtr, &clResult);
+				return clResult;
+			}
+#endif
+
+			return create(layout, flags, maxUnitCount, nullptr);
 		}
 
 		cl_int create(DataLayout const& layout, cl_mem_flags flags, size_t maxUnitCount, void* hostPtr = nullptr)
@@ -114,16 +271,69 @@ namespace opencl
 			return clResult;
 		}
 
+		/* the pool region backing the buffer, returned to the pool on destruction */
+		inline void setPoolAllocation(MemoryPoolHandle pool, PoolAllocation const& allocation)
+		{
+			p_pool = pool;
+			p_poolAllocation = allocation;
+		}
+
+	protected:
+#ifdef CL_VERSION_2_0
+		/* coarse-grained svm has to be mapped for host access, the mapped pointer is the svm pointer */
+		void* pMapSVM(cl::CommandQueue& cmdQueue, cl_map_flags flags, size_t offset, size_t size, std::vector< cl::Event > const& waitEvents, cl_int* err) const
+		{
+			std::vector< cl_event > clWaitEvents;
+			for (auto &pEvent : waitEvents)
+			{
+				clWaitEvents.push_back(pEvent());
+			}
+
+			cl_event mapEvent = nullptr;
+			void* mappedPtr = static_cast<unsigned char*>(p_svmPtr) + offset;
+			cl_int clResult = clEnqueueSVMMap(cmdQueue(), CL_TRUE, flags, mappedPtr, size, static_cast<cl_uint>(clWaitEvents.size()), clWaitEvents.size() ? clWaitEvents.data() : nullptr, &mapEvent);
+			if (err)
+				*err = clResult;
+			if (clResult != CL_SUCCESS)
+				return nullptr;
+
+			setSyncEvent(cl::Event(mapEvent));
+			return mappedPtr;
+		}
+
+		cl_int pUnmapSVM(cl::CommandQueue& cmdQueue, void* mappedPtr, std::vector< cl::Event > const& waitEvents) const
+		{
+			std::vector< cl_event > clWaitEvents;
+			for (auto &pEvent : waitEvents)
+			{
+				clWaitEvents.push_back(pEvent());
+			}
+
+			cl_event unmapEvent = nullptr;
+			cl_int clResult = clEnqueueSVMUnmap(cmdQueue(), mappedPtr, static_cast<cl_uint>(clWaitEvents.size()), clWaitEvents.size() ? clWaitEvents.data() : nullptr, &unmapEvent);
+			if (clResult != CL_SUCCESS)
+				return clResult;
+
+			setSyncEvent(cl::Event(unmapEvent));
+			return cmdQueue.flush();
+		}
+#endif
+
 	protected:
-		Device*			p_device{ nullptr };
-		DataLayout		p_dataLayout;
-		size_t			p_maxUnitCount{ 0 };
-		cl::Buffer		p_clResource;
-		size_t			p_resourceOffset{ 0 };
+		Device*				p_device{ nullptr };
+		DataLayout			p_dataLayout;
+		size_t				p_maxUnitCount{ 0 };
+		cl::Buffer			p_clResource;
+		size_t				p_resourceOffset{ 0 };
+		MemoryPoolHandle	p_pool;
+		PoolAllocation		p_poolAllocation;
+		void*				p_svmPtr{ nullptr };
+		bool				p_isSharedVirtual{ false };
 	};
 
 
 	class Image
+		: public ResourceSync
 	{
 	public:
 		Image(Device* device)
@@ -145,14 +355,42 @@ namespace opencl
 			return p_device;
 		}
 
-		void* map()
+		/* blocking map on the transfer queue, ordered after the last access of the image */
+		void* map(cl_map_flags flags, const size_t region[3], const size_t origin[3], size_t& rowPitch, size_t& slicePitch, cl_int* err = nullptr) const
 		{
-			return nullptr;
+			cl::size_t<3> _region, _origin;
+			for (int i = 0; i < 3; ++i)
+			{
+				_region[i] = region[i];
+				_origin[i] = origin ? origin[i] : 0;
+			}
+
+			std::vector< cl::Event > waitEvents;
+			appendSyncEvent(waitEvents);
+
+			cl::Event mapEvent;
+			cl::CommandQueue cmdQueue = p_device->getCmdQueue(QueueType::eTransfer);
+			void* mappedPtr = cmdQueue.enqueueMapImage(*p_clResource, CL_TRUE, flags, _origin, _region, &rowPitch, &slicePitch, waitEvents.size() ? &waitEvents : nullptr, &mapEvent, err);
+			if (mappedPtr)
+				setSyncEvent(mapEvent);
+
+			return mappedPtr;
 		}
 
-		void unmap()
+		/* non-blocking, later commands on the image wait for the unmap */
+		cl_int unmap(void* mappedPtr) const
 		{
+			std::vector< cl::Event > waitEvents;
+			appendSyncEvent(waitEvents);
+
+			cl::Event unmapEvent;
+			cl::CommandQueue cmdQueue = p_device->getCmdQueue(QueueType::eTransfer);
+			cl_int clResult = cmdQueue.enqueueUnmapMemObject(*p_clResource, mappedPtr, waitEvents.size() ? &waitEvents : nullptr, &unmapEvent);
+			if (clResult != CL_SUCCESS)
+				return clResult;
 
+			setSyncEvent(unmapEvent);
+			return cmdQueue.flush();
 		}
 
 
@@ -209,16 +447,128 @@ namespace opencl
 
 	protected:
 		Device*		p_device{ nullptr };
-		cl::Image*	p_clResource;
+		cl::Image*	p_clResource{ nullptr };
 	};
 
-	
-	/*
-	*-------------------------------
-	* currently the application is not using pipes
-	*-------------------------------
-	class Pipe {};
+
+	/**
+	* @class	Pipe
+	* @brief	Bounded fifo of fixed size packets between a producer and a consumer kernel.
+	*--------------------------------------------------------------------------
+	* A cl pipe on the devices with pipe support (built against the OpenCL 2.0 headers), else a ring
+	* buffer: [read count, write count, capacity, packet size, overflow, 3 x reserved] uint header
+	* followed by the packets. The kernels use the pipe prelude macros (see COMPUTE_PIPE_PRELUDE) so the
+	* same source runs on both.
+	*
+	* The ring buffer is a staging buffer, not a stream: the kernels using it are serialized through the
+	* sync event of the pipe, so the consumer starts only after the producer completed and the capacity
+	* has to hold every packet of a producer dispatch. Writes to a full ring are dropped and set the
+	* overflow word, see checkOverflow.
+	*--------------------------------------------------------------------------
 	*/
+	class Pipe
+		: public ResourceSync
+	{
+	public:
+		Pipe(Device* device)
+			: p_device(device)
+		{}
+
+		inline cl::Memory getResource() const
+		{
+			return p_clResource;
+		}
+
+		inline Device* getDevice() const
+		{
+			return p_device;
+		}
+
+		inline bool getIsNative() const
+		{
+			return p_isNative;
+		}
+
+		inline cl_uint getCapacity() const
+		{
+			return p_capacity;
+		}
+
+		cl_int create(cl_uint packetSize, cl_uint maxPackets)
+		{
+			cl_int clResult = CL_SUCCESS;
+
+			if (!packetSize || !maxPackets)
+				return CL_INVALID_VALUE;
+
+#ifdef CL_VERSION_2_0
+			if (p_device->getIsPipeSupported())
+			{
+				cl_mem clPipe = clCreatePipe(p_device->getContext()(), CL_MEM_READ_WRITE, packetSize, maxPackets, nullptr, &clResult);
+				if (clResult != CL_SUCCESS)
+					return clResult;
+
+				p_clResource = cl::Memory(clPipe);
+				p_capacity = maxPackets;
+				p_isNative = true;
+				return clResult;
+			}
+#endif
+
+			// power of two capacity, the ring slots stay consistent when the 32 bit counters wrap
+			p_capacity = 1;
+			while (p_capacity < maxPackets)
+			{
+				p_capacity <<= 1;
+			}
+
+			std::array< cl_uint, COMPUTE_PIPE_RING_HEADER > header = { { 0, 0, p_capacity, packetSize } };
+			size_t ringSize = sizeof(header) + static_cast<size_t>(p_capacity) * packetSize;
+			p_ring = cl::Buffer(p_device->getContext(), CL_MEM_READ_WRITE, ringSize, nullptr, &clResult);
+			if (clResult != CL_SUCCESS)
+				return clResult;
+
+			clResult = p_device->getCmdQueue(QueueType::eTransfer).enqueueWriteBuffer(p_ring, CL_TRUE, 0, sizeof(header), header.data());
+			if (clResult != CL_SUCCESS)
+				return clResult;
+
+			p_clResource = p_ring;
+			p_isNative = false;
+
+			return clResult;
+		}
+
+		/*
+		* ring buffer only | blocking, after the kernels submitted so far with the pipe bound.
+		* CL_OUT_OF_RESOURCES if a write was dropped on a full ring since the last check (the flag is cleared).
+		*/
+		cl_int checkOverflow()
+		{
+			if (p_isNative)
+				return CL_SUCCESS;
+
+			std::vector< cl::Event > waitEvents;
+			appendSyncEvent(waitEvents, ResourceAccess::eRead);
+
+			const size_t flagOffset = COMPUTE_PIPE_RING_OVERFLOW * sizeof(cl_uint);
+			cl_uint overflow = 0;
+			cl::CommandQueue cmdQueue = p_device->getCmdQueue(QueueType::eTransfer);
+			cl_int clResult = cmdQueue.enqueueReadBuffer(p_ring, CL_TRUE, flagOffset, sizeof(overflow), &overflow, waitEvents.size() ? &waitEvents : nullptr);
+			if (clResult != CL_SUCCESS || !overflow)
+				return clResult;
+
+			overflow = 0;
+			clResult = cmdQueue.enqueueWriteBuffer(p_ring, CL_TRUE, flagOffset, sizeof(overflow), &overflow);
+			return clResult != CL_SUCCESS ? clResult : CL_OUT_OF_RESOURCES;
+		}
+
+	protected:
+		Device*		p_device{ nullptr };
+		cl::Memory	p_clResource;
+		cl::Buffer	p_ring; /* p_clResource of the ring buffer fallback */
+		cl_uint		p_capacity{ 0 };
+		bool		p_isNative{ false };
+	};
 
 
 } // end namespace opencl
@@ -0,0 +1,68 @@
+/*
+* ---------------------------------------------------------
+* Copyright 2018-present (c) Automatos Studios. All Rights Reserved.
+* ---------------------------------------------------------
+*/
+
+/**
+* @file			oclShardBalancer.cpp
+* @author		cosmoplankton < cosmoplankton@automatos.studio >
+*/
+
+
+#include "oclShardBalancer.h"
+
+
+namespace opencl
+{
+
+	void ShardBalancer::split(uint64_t globalworksize, uint64_t granularity, std::vector< uint64_t >& shardSizes) const
+	{
+		size_t shardCount = p_throughput.size();
+		shardSizes.assign(shardCount, 0);
+		if (!shardCount)
+			return;
+
+		double measuredSum = 0.0;
+		size_t measuredCount = 0;
+		for (auto throughput : p_throughput)
+		{
+			if (throughput > 0.0)
+			{
+				measuredSum += throughput;
+				++measuredCount;
+			}
+		}
+
+		double prior = measuredCount ? measuredSum / measuredCount : 1.0;
+		std::vector< double > weights(shardCount);
+		double weightSum = 0.0;
+		for (size_t idx = 0; idx < shardCount; ++idx)
+		{
+			weights[idx] = p_throughput[idx] > 0.0 ? p_throughput[idx] : prior;
+			weightSum += weights[idx];
+		}
+
+		granularity = std::max<uint64_t>(granularity, 1);
+		uint64_t assigned = 0;
+		for (size_t idx = 0; idx + 1 < shardCount; ++idx)
+		{
+			uint64_t share = static_cast<uint64_t>(globalworksize * (weights[idx] / weightSum));
+			share = std::min<uint64_t>((share / granularity) * granularity, globalworksize - assigned);
+			shardSizes[idx] = share;
+			assigned += share;
+		}
+		shardSizes[shardCount - 1] = globalworksize - assigned;
+	}
+
+	void ShardBalancer::record(size_t shardIdx, uint64_t workItems, double milliseconds)
+	{
+		if (milliseconds <= 0.0 || !workItems)
+			return;
+
+		double throughput = static_cast<double>(workItems) / milliseconds;
+		double& average = p_throughput.at(shardIdx);
+		average = average > 0.0 ? (1.0 - COMPUTE_SHARD_EWMA_WEIGHT) * average + COMPUTE_SHARD_EWMA_WEIGHT * throughput : throughput;
+	}
+
+} // end namespace opencl
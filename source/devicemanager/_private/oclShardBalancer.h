@@ -0,0 +1,80 @@
+/*
+* ---------------------------------------------------------
+* Copyright 2018-present (c) Automatos Studios. All Rights Reserved.
+* ---------------------------------------------------------
+*/
+
+/**
+* @file			oclShardBalancer.h
+* @author		cosmoplankton < cosmoplankton@automatos.studio >
+*/
+
+
+#ifndef OPENCL_SHARD_BALANCER
+#define OPENCL_SHARD_BALANCER
+
+#include "oclDefines.h"
+
+
+namespace opencl
+{
+
+	/**
+	* @class	ShardBalancer
+	* @brief	Splits the global work of a sharded dispatch by the measured throughput of the shard devices.
+	*--------------------------------------------------------------------------
+	* Throughput (work items / ms, submit to gather complete) is an exponentially weighted moving average
+	* over the previous dispatches. Shards without a measurement get the mean of the measured ones,
+	* so the very first dispatch is an even split.
+	*--------------------------------------------------------------------------
+	*/
+	class ShardBalancer
+	{
+	public:
+		explicit ShardBalancer(size_t shardCount)
+			: p_throughput(shardCount, 0.0)
+		{}
+
+		inline size_t getShardCount() const
+		{
+			return p_throughput.size();
+		}
+
+		/* work items per shard, multiples of the granularity (the last shard takes the remainder) */
+		void split(uint64_t globalworksize, uint64_t granularity, std::vector< uint64_t >& shardSizes) const;
+
+		void record(size_t shardIdx, uint64_t workItems, double milliseconds);
+
+	protected:
+		std::vector< double > p_throughput;
+	};
+
+
+	/**
+	* @struct	ShardSet
+	* @brief	Replicas of a sharded ExecutionNode on the non primary devices (shard 0 is the node itself).
+	*/
+	struct ShardSet
+	{
+		std::vector< ExecNodeHandle >	replicas;
+		ShardBalancer					balancer{ 1 };
+	};
+
+
+	/* least common multiple of the shard local sizes */
+	static inline uint64_t GET_LCM(uint64_t a, uint64_t b)
+	{
+		uint64_t x = a, y = b;
+		while (y)
+		{
+			uint64_t r = x % y;
+			x = y;
+			y = r;
+		}
+		return x ? (a / x) * b : 0;
+	}
+
+} // end namespace opencl
+
+
+#endif // !OPENCL_SHARD_BALANCER
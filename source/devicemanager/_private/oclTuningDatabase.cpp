@@ -0,0 +1,106 @@
+/*
+* ---------------------------------------------------------
+* Copyright 2018-present (c) Automatos Studios. All Rights Reserved.
+* ---------------------------------------------------------
+*/
+
+/**
+* @file			oclTuningDatabase.cpp
+* @author		cosmoplankton < cosmoplankton@automatos.studio >
+*/
+
+
+#include <sstream>
+#include <iomanip>
+
+#include "oclTuningDatabase.h"
+
+
+namespace opencl
+{
+
+	TuningDatabase::TuningDatabase(std::string const& path)
+		: p_path(path)
+	{
+		pLoad();
+	}
+
+	uint64_t TuningDatabase::getKey(std::string const& kernelnamespace, std::string const& kernel, uint64_t sourceHash, cl::Device const& device, uint32_t bucket)
+	{
+		uint64_t hash = FNV_OFFSET_BASIS;
+
+		FNV_HASH_STRING(hash, kernelnamespace);
+		FNV_HASH_STRING(hash, kernel);
+		FNV_HASH_BYTES(hash, &sourceHash, sizeof(sourceHash));
+		FNV_HASH_STRING(hash, device.getInfo<CL_DEVICE_NAME>());
+		FNV_HASH_STRING(hash, device.getInfo<CL_DRIVER_VERSION>());
+		FNV_HASH_BYTES(hash, &bucket, sizeof(bucket));
+
+		return hash;
+	}
+
+	bool TuningDatabase::find(uint64_t key, TunedShape& shape) const
+	{
+		std::lock_guard<std::mutex> lock(p_mutex);
+
+		auto pEntry = p_entries.find(key);
+		if (pEntry == p_entries.end())
+			return false;
+
+		shape = pEntry->second;
+		return true;
+	}
+
+	bool TuningDatabase::store(uint64_t key, TunedShape const& shape)
+	{
+		std::lock_guard<std::mutex> lock(p_mutex);
+
+		p_entries[key] = shape;
+
+		return pSave();
+	}
+
+	void TuningDatabase::pLoad()
+	{
+		if (p_path.empty())
+			return;
+
+		std::ifstream fileStream(p_path);
+		if (!fileStream.is_open())
+			return;
+
+		// key(hex) dims local milliseconds
+		std::string line;
+		while (std::getline(fileStream, line))
+		{
+			if (line.empty() || line[0] == '#')
+				continue;
+
+			std::istringstream entry(line);
+			uint64_t key = 0;
+			TunedShape shape;
+			if (entry >> std::hex >> key >> std::dec >> shape.dims >> shape.local >> shape.milliseconds)
+				p_entries[key] = shape;
+		}
+	}
+
+	bool TuningDatabase::pSave() const
+	{
+		if (p_path.empty())
+			return true;
+
+		std::ofstream fileStream(p_path, std::ios::trunc);
+		if (!fileStream.is_open())
+			return false;
+
+		fileStream << "# kernel tuning database | key dims local milliseconds\n";
+		for (auto &pEntry : p_entries)
+		{
+			fileStream << std::hex << std::setw(16) << std::setfill('0') << pEntry.first << std::dec << " "
+				<< pEntry.second.dims << " " << pEntry.second.local << " " << pEntry.second.milliseconds << "\n";
+		}
+
+		return static_cast<bool>(fileStream);
+	}
+
+} // end namespace opencl
@@ -0,0 +1,84 @@
+/*
+* ---------------------------------------------------------
+* Copyright 2018-present (c) Automatos Studios. All Rights Reserved.
+* ---------------------------------------------------------
+*/
+
+/**
+* @file			oclTuningDatabase.h
+* @author		cosmoplankton < cosmoplankton@automatos.studio >
+*/
+
+
+#ifndef OPENCL_TUNING_DATABASE
+#define OPENCL_TUNING_DATABASE
+
+#include "oclDefines.h"
+
+
+namespace opencl
+{
+
+	/**
+	* @struct	TunedShape
+	* @brief	Fastest dispatch shape of a (kernel, device, problem size bucket).
+	*/
+	struct TunedShape
+	{
+		uint32_t	dims{ 0 };			/* 0 - the default work distribution of the device profile, 1 - 1D local size */
+		uint64_t	local{ 0 };
+		double		milliseconds{ 0.0 };
+	};
+
+
+	/**
+	* @class	TuningDatabase
+	* @brief	Autotuning results, persisted as a text file (one entry per line).
+	*--------------------------------------------------------------------------
+	* Keys hash the kernel, the program sources and build options, device name, driver version and the
+	* problem size bucket (log2 of the global work size), so a kernel edit or a driver update retunes.
+	* An empty path keeps the results in memory.
+	*--------------------------------------------------------------------------
+	*/
+	class TuningDatabase
+	{
+	public:
+		explicit TuningDatabase(std::string const& path);
+
+		/* sourceHash - Program::getSourceHash of the kernel program */
+		static uint64_t getKey(std::string const& kernelnamespace, std::string const& kernel, uint64_t sourceHash, cl::Device const& device, uint32_t bucket);
+
+		static inline uint32_t getBucket(uint64_t globalworksize)
+		{
+			uint32_t bucket = 0;
+			while (globalworksize >>= 1)
+			{
+				++bucket;
+			}
+			return bucket;
+		}
+
+		bool find(uint64_t key, TunedShape& shape) const;
+
+		/* adds (or replaces) the entry and rewrites the file */
+		bool store(uint64_t key, TunedShape const& shape);
+
+	protected:
+		void pLoad();
+
+		bool pSave() const;
+
+	protected:
+		std::string					p_path;
+		std::unordered_map
+			<
+			uint64_t,
+			TunedShape
+			>						p_entries;
+		mutable std::mutex			p_mutex;
+	};
+
+} // end namespace opencl
+
+
+#endif // !OPENCL_TUNING_DATABASE
@@ -41,26 +41,39 @@ namespace graphics_compute
 
 
         COMPUTE_API virtual int getDeviceCount(size_t& count) const = 0;
+
+
+        /**
+        * @brief Properties of the primary device, valid after initContextandDevices().
+        *
+        * @return Error code, any non-zero value specifies an error (no device).
+        */
+        COMPUTE_API virtual int getPrimaryDeviceInfo(DeviceInfo& info) const = 0;
         
         
         /**
         * @brief Initialize the compute instance(vulkan)/context(opencl) and devices.
+        *        GPUs are preferred as the primary device, CPU devices (e.g. PoCL) are used when no GPU is available
+        *        (see ContextDescription::setPrimaryDeviceType to pick the device type).
+        *        Every device gets a compute queue and a transfer queue, so transfers overlap the dispatches.
         *
-        * @param
+        * @param ContextDescription	Context/device options (queue modes, etc.).
         *
         * @return Error code, any non-zero value specifies an error.
         */
-        COMPUTE_API virtual int initContextandDevices() = 0;
+        COMPUTE_API virtual int initContextandDevices(ContextDescription const& contextDesc = ContextDescription()) = 0;
 
 
         /**
         * @brief	Initialize(Build the Program Executable) the compute kernels(opencl). This creates a compute kernels table.
         *			Separate Compiling, Linking, and Program Library creation are not exposed to the application (#improvement #todo)
+        *			The build runs on a worker thread (namespaces build concurrently) and the call returns immediately,
+        *			see getKernelsReady(). initApplicationComputePipeline waits only for the namespaces of its dispatches.
         *
         * @param	tag - unique tag of the program (to avoid rebuilding/loading)
-        * @param	source - source of the program.
+        * @param	source - source of the program (copied, could be released after the call).
         *
-        * @return	Error code, any non-zero value specifies an error.
+        * @return	Error code, any non-zero value specifies an error (CL_INVALID_VALUE - no sources). Build errors are reported by getKernelsReady().
         */
         COMPUTE_API virtual int initKernelsFromSource(std::vector< char const* > const& sources, std::string const& kernelnamespace = "global") = 0;
 
@@ -75,6 +88,30 @@ namespace graphics_compute
         */
         COMPUTE_API virtual int initKernel(std::string const& kernelCode, std::string const& kernelName) = 0;
 
+        /**
+        * @brief	Initialize the compute kernels(opencl) from a SPIR-V module (see source/data/kernels), this skips the
+        *			OpenCL C front end at startup. Devices without IL support (cl_khr_il_program) build the fallback sources.
+        *			The module should keep the kernel arg names (OpName), the arg io slots are looked up by name.
+        *
+        * @param	ilFile - path of the SPIR-V module (.spv).
+        * @param	fallbackSources - OpenCL C sources of the same kernels, could be empty if every device supports IL.
+        * @param	kernelnamespace - namespace of the program.
+        *
+        * @return	Error code, any non-zero value specifies an error (CL_INVALID_PROGRAM - module unreadable and no fallback
+        *			sources). Build errors are reported by getKernelsReady().
+        */
+        COMPUTE_API virtual int initKernelsFromIL(std::string const& ilFile, std::vector< char const* > const& fallbackSources, std::string const& kernelnamespace = "global") = 0;
+
+
+        /**
+        * @brief	Readiness of the kernels of a namespace (initKernelsFromSource/initKernelsFromIL build asynchronously).
+        *
+        * @param	kernelnamespace - namespace of the program.
+        *
+        * @return	Future of the build error code (non-zero for a failed build or an unknown namespace).
+        */
+        COMPUTE_API virtual std::shared_future<int> getKernelsReady(std::string const& kernelnamespace) = 0;
+
         // #improvement - Add the binary versions.
 
         
@@ -94,11 +131,84 @@ namespace graphics_compute
         * @brief Dispatch a compute task to the backend.
         *
         * @param DispatchPayload	Information about the compute tasks (kernels/offsets/workitems).
-        *							Currently supports only one ExecutionNode(single kernel). Adding support for the ExecutionGraph.
+        *							Executes a single ExecutionNode(single kernel), see dispatchGraph() for multiple kernels.
         *
         * @return Error code, any non-zero value specifies an error.
         */
         COMPUTE_API virtual int dispatch(DispatchPayload const& payload) = 0;
+
+
+        /**
+        * @brief Dispatch a sequence of compute tasks in a single submission, for pipelines issuing many small dispatches.
+        *        Same ordering as consecutive dispatch() calls, but the tags are resolved upfront
+        *        (an unknown tag fails the batch before anything is enqueued) and the queues are flushed once.
+        *
+        * @param payloads	Array of the dispatches, in submission order (e.g. std::vector::data()).
+        * @param count		Number of the dispatches.
+        * @param fuseElementwise	Consecutive stages of an elementwise chain run fused (see DispatchDescription::setElementwiseFunction).
+        *
+        * @return Error code, any non-zero value specifies an error (the dispatches after a failed one are not submitted).
+        */
+        COMPUTE_API virtual int dispatchBatch(DispatchPayload const* payloads, size_t count, bool fuseElementwise = false) = 0;
+
+
+        /**
+        * @brief Submit a set of dispatches as an ExecutionGraph. The dispatches are ordered by their
+        *        DispatchDescription dependencies using device events, independent branches run concurrently.
+        *
+        * @param GraphPayload	Dispatches of the graph and the host synchronization for the submission.
+        *
+        * @return Error code, any non-zero value specifies an error. A blocking submission returns the waitGraph() result.
+        */
+        COMPUTE_API virtual int dispatchGraph(GraphPayload const& payload) = 0;
+
+
+        /**
+        * @brief Block till the last submitted ExecutionGraph completes (for non-blocking submissions).
+        *
+        * @return Error code, any non-zero value specifies an error. CL_OUT_OF_RESOURCES (-5) - a ring buffer
+        *         pipe dropped writes since the last wait (any submission, see PipeDescription).
+        */
+        COMPUTE_API virtual int waitGraph() = 0;
+
+
+        /**
+        * @brief Add/remove pipeline resources and dispatches after initApplicationComputePipeline, without
+        *        rebuilding the pipeline. Only the changed resources/nodes are allocated or freed, the other
+        *        slots, interned ids and kernel arg bindings stay valid. Slots (and KernelIO) of a removed
+        *        resource (or dispatch) must not be used after the removal.
+        *        A resource still bound to a kernel arg can't be removed, rebind the arg or remove the dispatch first.
+        *        See T_AppComputePipeline, which keeps its descriptions in sync.
+        *
+        * @return Error code, any non-zero value specifies an error (duplicate/unknown tag, bound resource, dependency cycle).
+        */
+        COMPUTE_API virtual int addBuffer(BufferDescription const& bufDesc) = 0;
+        COMPUTE_API virtual int removeBuffer(std::string const& tag) = 0;
+        COMPUTE_API virtual int addImage(ImageDescription const& imgDesc) = 0;
+        COMPUTE_API virtual int removeImage(std::string const& tag) = 0;
+        COMPUTE_API virtual int addDispatch(DispatchDescription const& dispatchDesc) = 0;
+        COMPUTE_API virtual int removeDispatch(std::string const& tag) = 0;
+
+
+        /**
+        * @brief Timings of the dispatches (by tag) and the transfers (by command), see ContextDescription::setIsProfiling.
+        *        Blocks till the pending profiled commands complete.
+        *
+        * @param stats	Filled with one entry per dispatch tag / transfer command, ordered by the total execution time.
+        *
+        * @return Error code, any non-zero value specifies an error (profiling disabled).
+        */
+        COMPUTE_API virtual int getTimingStats(std::vector< TimingStats >& stats) = 0;
+
+
+        /**
+        * @brief Write the getTimingStats() result to a JSON file.
+        *
+        * @param path	Output file, overwritten.
+        *
+        * @return Error code, any non-zero value specifies an error.
+        */
+        COMPUTE_API virtual int dumpTimingStats(std::string const& path) = 0;
     };
 }
 
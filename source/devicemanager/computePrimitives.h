@@ -0,0 +1,353 @@
+/*
+* ---------------------------------------------------------
+* Copyright 2018-present (c) Automatos Studios. All Rights Reserved.
+* ---------------------------------------------------------
+*/
+
+/**
+* @file			computePrimitives.h
+* @author		cosmoplankton < cosmoplankton@automatos.studio >
+*/
+
+
+#ifndef COMPUTE_PRIMITIVES
+#define COMPUTE_PRIMITIVES
+
+
+#include <string>
+#include <fstream>
+#include <iterator>
+#include <algorithm>
+
+#include "Idevice.h"
+#include "IcomputeAppManager.h"
+#include "computeManager.h"
+
+
+#define COMPUTE_PRIMITIVES_NAMESPACE "primitives"	/* kernel namespace of source/data/kernels/primitives.cl */
+#define COMPUTE_PRIMITIVES_GROUP_SIZE 256			/* PRIM_GROUP_SIZE of the kernels */
+#define COMPUTE_PRIMITIVES_GROUPS_PER_UNIT 4		/* groups of the tiled kernels per compute unit, for load balancing */
+#define COMPUTE_PRIMITIVES_MAX_GROUPS 1024			/* the partials are scanned by a single group, this bounds its work */
+#define COMPUTE_PRIMITIVES_RADIX_BITS 4				/* PRIM_RADIX_BITS of the kernels */
+
+
+namespace graphics_compute
+{
+
+	/* operation of ComputePrimitives::reduce */
+	enum class ReduceOp : uint32_t
+	{
+		eSum = 0x0,
+		eMin = 0x1,
+		eMax = 0x2
+	};
+
+
+	/**
+	* @class	ComputePrimitives
+	* @brief	Parallel primitives (reduce, scan, histogram, radix sort, stream compaction) over the application pipeline.
+	*--------------------------------------------------------------------------
+	* 1. initKernels() - queues the build of source/data/kernels/primitives.cl as the "primitives" kernel namespace.
+	* 2. init() - adds the scratch buffers and one dispatch per kernel to the initialized pipeline. The grid of the
+	*    tiled kernels is sized from the compute units of the primary device (see getGroupCount).
+	* 3. the operations bind the application buffers (by tag) and dispatch. Every dispatch waits for the previous
+	*    accesses of its buffers, so the operations are ordered with the rest of the pipeline without host waits,
+	*    the results are read with the buffer slots of the DataIO.
+	*--------------------------------------------------------------------------
+	* Element formats: eDouble32 (float), eInt32 and eUint32 for reduce and scan, float values for the histogram,
+	* uint keys and values for the sort, any 32 bit values for the compaction. The operations of an object share the
+	* scratch buffers, so they are submitted from one thread.
+	*--------------------------------------------------------------------------
+	*/
+	class ComputePrimitives final
+	{
+	public:
+		ComputePrimitives(IComputeManager* computeManager, IApplicationComputePipeline* pipeline)
+			: m_pipeline(pipeline)
+		{
+			DeviceInfo deviceInfo;
+			uint32_t computeUnits = computeManager->getPrimaryDeviceInfo(deviceInfo) ? 1 : deviceInfo.computeUnits;
+
+			// power of two, the dispatch splits the grid evenly if it exceeds a dimension
+			uint32_t targetGroups = std::max<uint32_t>(computeUnits, 1) * COMPUTE_PRIMITIVES_GROUPS_PER_UNIT;
+			while (m_groupCount < targetGroups && m_groupCount < COMPUTE_PRIMITIVES_MAX_GROUPS)
+			{
+				m_groupCount <<= 1;
+			}
+		}
+
+		/* the source is read here and copied by the compute manager */
+		static int initKernels(IComputeManager* computeManager, std::string const& sourceFile)
+		{
+			std::ifstream fileStream(sourceFile, std::ios::binary);
+			if (!fileStream.is_open())
+				return -1;
+
+			std::string source((std::istreambuf_iterator<char>(fileStream)), std::istreambuf_iterator<char>());
+			return computeManager->initKernelsFromSource({ source.c_str() }, COMPUTE_PRIMITIVES_NAMESPACE);
+		}
+
+		/* groups of the tiled kernels, a power of two from the compute units of the primary device */
+		inline uint32_t getGroupCount() const { return m_groupCount; }
+
+		/* maxSortCount - capacity of the radix sort ping-pong buffers (0 - no sort) */
+		int init(uint32_t maxSortCount = 0)
+		{
+			// partials and totals in the element format of the operation
+			int result = 0;
+			for (auto format : { device::DataFormat::eDouble32, device::DataFormat::eInt32, device::DataFormat::eUint32 })
+			{
+				std::string typeName = pGetTypeName(format);
+				if (!result)
+					result = pAddScratchBuffer(pTag("partials_" + typeName), format, m_groupCount);
+				if (!result)
+					result = pAddScratchBuffer(pTag("total_" + typeName), format, 1);
+			}
+			if (!result)
+				result = pAddScratchBuffer(pTag("radixHistogram"), device::DataFormat::eUint32, (1 << COMPUTE_PRIMITIVES_RADIX_BITS) * m_groupCount);
+			if (!result && maxSortCount)
+				result = pAddScratchBuffer(pTag("radixKeys"), device::DataFormat::eUint32, maxSortCount);
+			if (!result && maxSortCount)
+				result = pAddScratchBuffer(pTag("radixValues"), device::DataFormat::eUint32, maxSortCount);
+			if (result)
+				return result;
+
+			m_maxSortCount = maxSortCount;
+
+			static char const* const kernelNames[] =
+			{
+				"prim_reduce_sum_float", "prim_reduce_min_float", "prim_reduce_max_float",
+				"prim_reduce_sum_int", "prim_reduce_min_int", "prim_reduce_max_int",
+				"prim_reduce_sum_uint", "prim_reduce_min_uint", "prim_reduce_max_uint",
+				"prim_scan_groups_float", "prim_scan_groups_int", "prim_scan_groups_uint",
+				"prim_scan_apply_float", "prim_scan_apply_int", "prim_scan_apply_uint",
+				"prim_fill_uint", "prim_histogram_float",
+				"prim_radix_count", "prim_radix_scatter",
+				"prim_compact_count", "prim_compact_scatter"
+			};
+
+			for (char const* kernelName : kernelNames)
+			{
+				result = m_pipeline->addDispatch(DispatchDescription().setTag(pTag(kernelName)).setKernelName(kernelName).setKernelNamespace(COMPUTE_PRIMITIVES_NAMESPACE));
+				if (result)
+					return result;
+			}
+
+			return result;
+		}
+
+		/* resultTag[0] = op over inTag[0, count) */
+		int reduce(ReduceOp op, device::DataFormat format, std::string const& inTag, std::string const& resultTag, uint32_t count)
+		{
+			static char const* const opNames[] = { "sum", "min", "max" };
+
+			char const* typeName = pGetTypeName(format);
+			if (!typeName || static_cast<uint32_t>(op) > static_cast<uint32_t>(ReduceOp::eMax))
+				return -1;
+
+			std::string kernelName = std::string("prim_reduce_") + opNames[static_cast<uint32_t>(op)] + "_" + typeName;
+			KernelIO* kernelIO = m_pipeline->getKernelIO(kernelName, COMPUTE_PRIMITIVES_NAMESPACE);
+
+			// tiles -> partials, partials -> result
+			std::string partialsTag = pTag(std::string("partials_") + typeName);
+			kernelIO->argBindBuffer(0, inTag);
+			kernelIO->argBindBuffer(1, partialsTag);
+			kernelIO->argSet<uint32_t>(2, count);
+			int result = pDispatch(kernelName, m_groupCount);
+			if (result)
+				return result;
+
+			kernelIO->argBindBuffer(0, partialsTag);
+			kernelIO->argBindBuffer(1, resultTag);
+			kernelIO->argSet<uint32_t>(2, m_groupCount);
+			return pDispatch(kernelName, 1);
+		}
+
+		/* prefix sums of inTag[0, count) into outTag (in place if the tags are the same) */
+		int scan(device::DataFormat format, std::string const& inTag, std::string const& outTag, uint32_t count, bool inclusive = false)
+		{
+			char const* typeName = pGetTypeName(format);
+			if (!typeName)
+				return -1;
+
+			std::string partialsTag = pTag(std::string("partials_") + typeName);
+			std::string reduceName = std::string("prim_reduce_sum_") + typeName;
+			KernelIO* reduceIO = m_pipeline->getKernelIO(reduceName, COMPUTE_PRIMITIVES_NAMESPACE);
+			reduceIO->argBindBuffer(0, inTag);
+			reduceIO->argBindBuffer(1, partialsTag);
+			reduceIO->argSet<uint32_t>(2, count);
+			int result = pDispatch(reduceName, m_groupCount);
+			if (result)
+				return result;
+
+			result = pScanGroups(typeName, partialsTag, pTag(std::string("total_") + typeName), m_groupCount);
+			if (result)
+				return result;
+
+			std::string applyName = std::string("prim_scan_apply_") + typeName;
+			KernelIO* applyIO = m_pipeline->getKernelIO(applyName, COMPUTE_PRIMITIVES_NAMESPACE);
+			applyIO->argBindBuffer(0, inTag);
+			applyIO->argBindBuffer(1, outTag);
+			applyIO->argBindBuffer(2, partialsTag);
+			applyIO->argSet<uint32_t>(3, count);
+			applyIO->argSet<uint32_t>(4, inclusive ? 1 : 0);
+			return pDispatch(applyName, m_groupCount);
+		}
+
+		/*
+		* binsTag[binCount] (uint) counts of the float values in inTag[0, count) over [minValue, maxValue),
+		* the values outside the range count into the first/last bin, NaN values are not counted.
+		* accumulate - keeps the previous counts.
+		*/
+		int histogram(std::string const& inTag, std::string const& binsTag, uint32_t count, uint32_t binCount, float minValue, float maxValue, bool accumulate = false)
+		{
+			if (!binCount || !(maxValue > minValue))
+				return -1;
+
+			int result = 0;
+			if (!accumulate)
+			{
+				KernelIO* fillIO = m_pipeline->getKernelIO("prim_fill_uint", COMPUTE_PRIMITIVES_NAMESPACE);
+				fillIO->argBindBuffer(0, binsTag);
+				fillIO->argSet<uint32_t>(1, 0);
+				fillIO->argSet<uint32_t>(2, binCount);
+				result = pDispatch("prim_fill_uint", m_groupCount);
+				if (result)
+					return result;
+			}
+
+			KernelIO* histogramIO = m_pipeline->getKernelIO("prim_histogram_float", COMPUTE_PRIMITIVES_NAMESPACE);
+			histogramIO->argBindBuffer(0, inTag);
+			histogramIO->argBindBuffer(1, binsTag);
+			histogramIO->argSet<uint32_t>(2, count);
+			histogramIO->argSet<uint32_t>(3, binCount);
+			histogramIO->argSet<float>(4, minValue);
+			histogramIO->argSet<float>(5, binCount / (maxValue - minValue));
+			return pDispatch("prim_histogram_float", m_groupCount);
+		}
+
+		/* stable ascending sort of the uint keys keysTag[0, count), the uint values are moved with their keys */
+		int radixSort(std::string const& keysTag, std::string const& valuesTag, uint32_t count)
+		{
+			if (count > m_maxSortCount)
+				return -1;
+
+			KernelIO* countIO = m_pipeline->getKernelIO("prim_radix_count", COMPUTE_PRIMITIVES_NAMESPACE);
+			KernelIO* scatterIO = m_pipeline->getKernelIO("prim_radix_scatter", COMPUTE_PRIMITIVES_NAMESPACE);
+
+			// even pass count, the sorted data ends up in the application buffers
+			std::string keys[2] = { keysTag, pTag("radixKeys") };
+			std::string values[2] = { valuesTag, pTag("radixValues") };
+			int result = 0;
+			for (uint32_t shift = 0, pass = 0; shift < 32; shift += COMPUTE_PRIMITIVES_RADIX_BITS, pass ^= 1)
+			{
+				countIO->argBindBuffer(0, keys[pass]);
+				countIO->argBindBuffer(1, pTag("radixHistogram"));
+				countIO->argSet<uint32_t>(2, count);
+				countIO->argSet<uint32_t>(3, shift);
+				result = pDispatch("prim_radix_count", m_groupCount);
+				if (result)
+					return result;
+
+				result = pScanGroups("uint", pTag("radixHistogram"), pTag("total_uint"), (1 << COMPUTE_PRIMITIVES_RADIX_BITS) * m_groupCount);
+				if (result)
+					return result;
+
+				scatterIO->argBindBuffer(0, keys[pass]);
+				scatterIO->argBindBuffer(1, values[pass]);
+				scatterIO->argBindBuffer(2, keys[pass ^ 1]);
+				scatterIO->argBindBuffer(3, values[pass ^ 1]);
+				scatterIO->argBindBuffer(4, pTag("radixHistogram"));
+				scatterIO->argSet<uint32_t>(5, count);
+				scatterIO->argSet<uint32_t>(6, shift);
+				result = pDispatch("prim_radix_scatter", m_groupCount);
+				if (result)
+					return result;
+			}
+
+			return result;
+		}
+
+		/* outTag = the values of valuesTag[0, count) with a non-zero uint flag in flagsTag (order kept), countTag[0] = output count */
+		int compact(std::string const& valuesTag, std::string const& flagsTag, std::string const& outTag, std::string const& countTag, uint32_t count)
+		{
+			KernelIO* countIO = m_pipeline->getKernelIO("prim_compact_count", COMPUTE_PRIMITIVES_NAMESPACE);
+			countIO->argBindBuffer(0, flagsTag);
+			countIO->argBindBuffer(1, pTag("partials_uint"));
+			countIO->argSet<uint32_t>(2, count);
+			int result = pDispatch("prim_compact_count", m_groupCount);
+			if (result)
+				return result;
+
+			result = pScanGroups("uint", pTag("partials_uint"), countTag, m_groupCount);
+			if (result)
+				return result;
+
+			KernelIO* scatterIO = m_pipeline->getKernelIO("prim_compact_scatter", COMPUTE_PRIMITIVES_NAMESPACE);
+			scatterIO->argBindBuffer(0, valuesTag);
+			scatterIO->argBindBuffer(1, flagsTag);
+			scatterIO->argBindBuffer(2, outTag);
+			scatterIO->argBindBuffer(3, pTag("partials_uint"));
+			scatterIO->argSet<uint32_t>(4, count);
+			return pDispatch("prim_compact_scatter", m_groupCount);
+		}
+
+	protected:
+		static inline std::string pTag(std::string const& name)
+		{
+			return std::string(COMPUTE_PRIMITIVES_NAMESPACE) + "::" + name;
+		}
+
+		static inline char const* pGetTypeName(device::DataFormat format)
+		{
+			switch (format)
+			{
+			case device::DataFormat::eDouble32: return "float";
+			case device::DataFormat::eInt32: return "int";
+			case device::DataFormat::eUint32: return "uint";
+			default: return nullptr;
+			}
+		}
+
+		int pAddScratchBuffer(std::string const& tag, device::DataFormat format, uint32_t unitCount)
+		{
+			device::DataAttribute attribute;
+			attribute.setType(device::DataAttributeType::eUndefined).setFormat(format);
+
+			return m_pipeline->addBuffer(BufferDescription()
+				.setTag(tag)
+				.setMaxUnitCount(unitCount)
+				.setDataAttributeList({ attribute })
+				.setDataAccessQualifier(device::DataAccessQualifier::eDeviceLocal));
+		}
+
+		/* groupCount groups of COMPUTE_PRIMITIVES_GROUP_SIZE work-items */
+		int pDispatch(std::string const& kernelName, uint32_t groupCount)
+		{
+			DispatchPayload payload;
+			payload.tag = pTag(kernelName);
+			payload.globalworksize = static_cast<size_t>(groupCount) * COMPUTE_PRIMITIVES_GROUP_SIZE;
+			return m_pipeline->dispatch(payload);
+		}
+
+		/* exclusive scan of dataTag[0, count) in place by a single group, totalTag[0] = sum */
+		int pScanGroups(char const* typeName, std::string const& dataTag, std::string const& totalTag, uint32_t count)
+		{
+			std::string kernelName = std::string("prim_scan_groups_") + typeName;
+			KernelIO* kernelIO = m_pipeline->getKernelIO(kernelName, COMPUTE_PRIMITIVES_NAMESPACE);
+			kernelIO->argBindBuffer(0, dataTag);
+			kernelIO->argBindBuffer(1, totalTag);
+			kernelIO->argSet<uint32_t>(2, count);
+			return pDispatch(kernelName, 1);
+		}
+
+	protected:
+		IApplicationComputePipeline* m_pipeline;
+		uint32_t m_groupCount{ 1 };
+		uint32_t m_maxSortCount{ 0 };
+	};
+
+} // end namespace graphics_compute
+
+
+#endif // !COMPUTE_PRIMITIVES